@@ -3,20 +3,28 @@
 //
 #include <pybind11/pybind11.h>
 #include "logger.h"
+#include "trace.h"
 #include "servo.h"
+#include "serial/recorder.h"
+#include "serial/replay.h"
 
 #ifdef __linux__
 
 #include "unix/adc.h"
+#include "unix/sampler.h"
 #include "unix/gpio.h"
 #include "unix/spi.h"
+#include <cstring>
 
 #endif
 
 #include "servo_manager.h"
 #include "servo_protocol_parse.h"
 #include "firmware_update.h"
+#include "firmware_rollout.h"
+#include "firmware_package.h"
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include <pybind11/functional.h>
 
 #include "system_up.h"
@@ -27,6 +35,108 @@ extern "C" {
 
 namespace py = pybind11;
 
+namespace pybind11 {
+    namespace detail {
+        /**
+         * 数据帧参数（std::vector<uint8_t>）除 int 列表外，也接受 bytes / bytearray / memoryview / uint8 NumPy 数组等
+         * 单字节元素的连续缓冲区，整块复制而不是逐个元素转换；其他对象按序列转换。返回值仍转换为列表，需要 bytes 的接口单独包装。
+         */
+        template<>
+        struct type_caster<std::vector<uint8_t> > : list_caster<std::vector<uint8_t>, uint8_t> {
+            bool load(handle src, bool convert) {
+                Py_buffer view;
+                if (PyObject_CheckBuffer(src.ptr())) {
+                    if (PyObject_GetBuffer(src.ptr(), &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == 0) {
+                        bool bytes = view.itemsize == 1;
+                        if (bytes) {
+                            const uint8_t *data = static_cast<const uint8_t *>(view.buf);
+                            value.assign(data, data + view.len);
+                        }
+                        PyBuffer_Release(&view);
+                        if (bytes) {
+                            return true;
+                        }
+                    } else {
+                        // 带步长的视图等不连续的缓冲区按序列逐个元素转换
+                        PyErr_Clear();
+                    }
+                }
+                return list_caster<std::vector<uint8_t>, uint8_t>::load(src, convert);
+            }
+        };
+    }
+}
+
+namespace {
+    py::bytes toBytes(const std::vector<uint8_t> &frame) {
+        return py::bytes(reinterpret_cast<const char *>(frame.data()), frame.size());
+    }
+
+    // 指令构建函数返回 bytes，可以直接交给 Serial.write / Servo.send_command，不产生逐字节的 int 对象
+    template<typename C, typename... Args>
+    std::function<py::bytes(C &, Args...)> frameBuilder(std::vector<uint8_t> (C::*build)(Args...)) {
+        return [build](C &self, Args... args) {
+            return toBytes((self.*build)(args...));
+        };
+    }
+
+    /**
+     * 析构时释放 GIL：Servo、Reactor 的析构函数等待后台线程退出，而后台线程可能正在等待 GIL 调用 Python 回调。
+     * 最后一个引用也可能在没有 GIL 的后台线程中释放，此时直接析构。
+     */
+    template<typename T>
+    struct GilReleasingDeleter {
+        void operator()(T *object) const {
+            if (PyGILState_Check()) {
+                py::gil_scoped_release release;
+                delete object;
+            } else {
+                delete object;
+            }
+        }
+    };
+
+    // 按 C 顺序连续存放的缓冲区的字节数（bytes / bytearray / memoryview / NumPy），其他布局需要先复制
+    size_t contiguousBytes(const py::buffer_info &info, const char *name) {
+        py::ssize_t stride = info.itemsize;
+        for (py::ssize_t i = info.ndim - 1; i >= 0; --i) {
+            if (info.shape[i] > 1 && info.strides[i] != stride) {
+                throw py::value_error(std::string(name) + " must be a C-contiguous buffer");
+            }
+            stride *= info.shape[i];
+        }
+        return static_cast<size_t>(info.size * info.itemsize);
+    }
+
+    // 在后台线程中调用 Python 回调：获取 GIL，回调抛出的异常作为 unraisable 异常报告，不传播到后台线程
+    template<typename... Args>
+    std::function<void(Args...)> withGil(std::function<void(Args...)> callback, const char *where) {
+        if (!callback) {
+            return nullptr;
+        }
+        return [callback, where](Args... args) {
+            py::gil_scoped_acquire acquire;
+            try {
+                callback(args...);
+            } catch (py::error_already_set &e) {
+                e.discard_as_unraisable(where);
+            }
+        };
+    }
+}
+
+#ifdef __linux__
+
+namespace {
+    // transfer_segments 每段引用的缓冲区，ioctl 完成之前保持引用（也阻止 bytearray 改变大小）
+    struct SegmentBuffers {
+        py::buffer_info tx;
+        py::buffer_info rx;
+    };
+}
+
+#endif
+
 PYBIND11_MODULE(up_core, m) {
     m.doc() = "up_core module for python";
 
@@ -56,7 +166,31 @@ PYBIND11_MODULE(up_core, m) {
             .def("error", &Logger::error, "Log an ERROR message")
             .def("init_logger", []() {
                 Logger::setLogLevel(Logger::INFO); // 设置默认日志级别为INFO
-            }, "Initialize the Logger with INFO level");
+            }, "Initialize the Logger with INFO level")
+            .def("enable_async_logging",
+                 [](size_t capacity, bool block, uint32_t flush_interval_ms, const std::string &path) {
+                     Logger::AsyncOptions options;
+                     options.capacity = capacity;
+                     options.overflow = block ? Logger::BLOCK : Logger::DROP;
+                     options.flush_interval_ms = flush_interval_ms;
+                     options.path = path;
+                     Logger::enableAsync(options);
+                 },
+                 py::arg("capacity") = 4096, py::arg("block") = false, py::arg("flush_interval_ms") = 10,
+                 py::arg("path") = "", "Write logs from a background thread; path empty means console")
+            .def("disable_async_logging", &Logger::disableAsync, py::call_guard<py::gil_scoped_release>(),
+                 "Drain the async log queue and return to synchronous logging")
+            .def("flush_logs", &Logger::flush, py::call_guard<py::gil_scoped_release>(),
+                 "Wait until queued log messages are written")
+            .def("dropped_log_count", &Logger::droppedCount, "Messages dropped because the async queue was full");
+
+    // 二进制跟踪，用 scripts/trace_decode.py 转换为 CSV / Chrome trace JSON
+    m.def("trace_start", &trace::start, py::arg("path"), py::arg("buffer_records") = 4096,
+          "Start writing fixed-size frame / transaction trace records to path")
+            .def("trace_stop", &trace::stop, py::call_guard<py::gil_scoped_release>(),
+                 "Write out all per-thread trace buffers and close the trace file")
+            .def("trace_flush", &trace::flush, py::call_guard<py::gil_scoped_release>())
+            .def("trace_enabled", &trace::enabled);
 
 #ifdef __linux__
 
@@ -71,12 +205,123 @@ PYBIND11_MODULE(up_core, m) {
                 .def(py::init<const char *>())
                 .def("what", &gpio::GPIOException::what);
 
+        // 同一控制器上的一组引脚：一次调用读写全部引脚，输入引脚可以监听边沿事件
+        py::class_<gpio::LineEvent>(m, "LineEvent")
+                .def_readonly("offset", &gpio::LineEvent::offset)
+                .def_readonly("rising", &gpio::LineEvent::rising)
+                .def_readonly("time_ns", &gpio::LineEvent::time_ns, "内核记录的事件时间（CLOCK_MONOTONIC 纳秒）")
+                .def("__repr__", [](const gpio::LineEvent &event) {
+                    return "LineEvent(offset=" + std::to_string(event.offset) + ", rising=" +
+                           (event.rising ? "True" : "False") + ", time_ns=" + std::to_string(event.time_ns) + ")";
+                });
+
+        py::class_<gpio::GPIOLines, std::shared_ptr<gpio::GPIOLines>> gpio_lines(m, "GPIOLines");
+        py::enum_<gpio::GPIOLines::Edge>(gpio_lines, "Edge")
+                .value("RISING", gpio::GPIOLines::RISING)
+                .value("FALLING", gpio::GPIOLines::FALLING)
+                .value("BOTH", gpio::GPIOLines::BOTH)
+                .export_values();
+        gpio_lines
+                .def(py::init<int, const std::vector<unsigned int> &>(), py::arg("chip_id"), py::arg("offsets"),
+                     "构造 GPIO 引脚组")
+                .def("request_output", &gpio::GPIOLines::requestOutput, py::arg("defaults") = std::vector<int>(),
+                     "请求为输出，defaults 为初始电平")
+                .def("request_input", &gpio::GPIOLines::requestInput, "请求为输入")
+                .def("request_events", &gpio::GPIOLines::requestEvents, py::arg("edge") = gpio::GPIOLines::BOTH,
+                     "请求为输入并监听边沿事件")
+                .def("set_values", static_cast<void (gpio::GPIOLines::*)(const std::vector<int> &)>(
+                        &gpio::GPIOLines::setValues), py::arg("values"), "一次设置所有引脚的电平")
+                .def("get_values", static_cast<std::vector<int> (gpio::GPIOLines::*)()>(&gpio::GPIOLines::getValues),
+                     "一次读取所有引脚的电平")
+                .def("event_fd", &gpio::GPIOLines::eventFd, py::arg("index"),
+                     "第 index 个引脚的事件文件描述符（非阻塞），可以交给 selectors / asyncio")
+                .def("read_events", [](gpio::GPIOLines &self, size_t index) {
+                    std::vector<gpio::LineEvent> events;
+                    gpio::LineEvent buffer[16];
+                    size_t count;
+                    do {
+                        count = self.readEvents(index, buffer, 16);
+                        events.insert(events.end(), buffer, buffer + count);
+                    } while (count == 16);
+                    return events;
+                }, py::arg("index"), "取出第 index 个引脚已发生的全部事件，没有事件时返回空列表")
+                .def("watch", [](gpio::GPIOLines &self, serial::Reactor &reactor,
+                                 std::function<void(const gpio::LineEvent &)> callback) {
+                         auto on_event = withGil(std::move(callback), "GPIOLines event callback");
+                         // watch 等待事件循环线程完成注册，该线程调用 Python 回调前需要 GIL
+                         py::gil_scoped_release release;
+                         self.watch(reactor, std::move(on_event));
+                     }, py::arg("reactor"), py::arg("callback"), py::keep_alive<2, 1>(),
+                     "在事件循环中监听边沿事件，callback(LineEvent) 在事件循环线程中调用")
+                .def("unwatch", &gpio::GPIOLines::unwatch, py::arg("reactor"),
+                     py::call_guard<py::gil_scoped_release>(), "停止在事件循环中监听")
+                .def("release", &gpio::GPIOLines::release, "释放引脚")
+                .def("__len__", &gpio::GPIOLines::size)
+                .def_property_readonly("offsets", &gpio::GPIOLines::getOffsets);
+
         // ADC
         py::class_<adc::ADC, std::shared_ptr<adc::ADC>>(m, "ADC")
                 .def(py::init<spi::SPI &, uint8_t>(), py::arg("spi"), py::arg("channel_count"), "构造 ADC 对象")
                 .def("init", &adc::ADC::init, "初始化 ADC")
-                .def("read_channel", &adc::ADC::readChannel, py::arg("channel"), "读取单个 ADC 通道")
-                .def("read_all", &adc::ADC::readAll, "读取所有 ADC 通道");
+                .def("read_channel", &adc::ADC::readChannel, py::arg("channel"), py::call_guard<py::gil_scoped_release>(),
+                     "读取单个 ADC 通道")
+                .def("read_all", static_cast<std::vector<uint16_t> (adc::ADC::*)()>(&adc::ADC::readAll),
+                     py::call_guard<py::gil_scoped_release>(), "一次 SPI 传输读取所有 ADC 通道")
+                .def("read_channels", [](adc::ADC &self, const std::vector<uint8_t> &channels) {
+                    std::vector<uint16_t> values(channels.size());
+                    self.readChannels(channels.data(), channels.size(), values.data());
+                    return values;
+                }, py::arg("channels"), py::call_guard<py::gil_scoped_release>(), "一次 SPI 传输按顺序读取多个 ADC 通道")
+                .def_property_readonly("channel_count", &adc::ADC::getChannelCount, "ADC 通道数");
+
+        // 定频采样：样本由后台线程写入环形缓冲区，Python 侧按需读取，不受解释器调度抖动影响
+        py::class_<adc::Sampler, std::shared_ptr<adc::Sampler>>(m, "Sampler")
+                .def(py::init([](adc::ADC &adc, const std::vector<uint8_t> &channels, double rate_hz, size_t capacity,
+                                 uint32_t decimation) {
+                         adc::SamplerOptions options;
+                         options.channels = channels;
+                         options.rate_hz = rate_hz;
+                         options.capacity = capacity;
+                         options.decimation = decimation;
+                         return std::make_shared<adc::Sampler>(adc, options);
+                     }), py::arg("adc"), py::arg("channels"), py::arg("rate_hz"), py::arg("capacity") = 4096,
+                     py::arg("decimation") = 1, py::keep_alive<1, 2>(), "构造采样引擎，decimation 次扫描取平均输出一个样本")
+                .def("start", &adc::Sampler::start, "启动采样线程")
+                .def("stop", &adc::Sampler::stop, py::call_guard<py::gil_scoped_release>(), "停止采样线程")
+                .def_property_readonly("running", &adc::Sampler::running)
+                .def_property_readonly("channel_count", &adc::Sampler::channelCount)
+                .def("available", &adc::Sampler::available, "尚未取走的样本数")
+                // 复制并取走最多 max_samples 个样本，返回 (时间戳 uint64[n], 数值 uint16[n, 通道数])
+                .def("read", [](adc::Sampler &self, size_t max_samples) {
+                    size_t channels = self.channelCount();
+                    size_t count = std::min(max_samples, self.available());
+                    py::array_t<uint64_t> times(count);
+                    py::array_t<uint16_t> values({count, channels});
+                    count = self.read(times.mutable_data(), values.mutable_data(), count);
+                    return py::make_tuple(times[py::slice(0, count, 1)], values[py::slice(0, count, 1)]);
+                }, py::arg("max_samples") = static_cast<size_t>(-1))
+                // 直接引用环形缓冲区的只读数组（不复制），处理完后调用 consume(n)；
+                // 样本跨过缓冲区末尾时只返回第一段，consume 之后再次调用 view 取得其余样本
+                .def("view", [](py::object self_object) {
+                    adc::Sampler &self = self_object.cast<adc::Sampler &>();
+                    size_t channels = self.channelCount();
+                    size_t first = 0;
+                    size_t count = self.peek(&first);
+                    py::array_t<uint64_t> times({count}, {sizeof(uint64_t)}, self.timeData() + first, self_object);
+                    py::array_t<uint16_t> values({count, channels}, {channels * sizeof(uint16_t), sizeof(uint16_t)},
+                                                 self.valueData() + first * channels, self_object);
+                    times.attr("setflags")(py::arg("write") = false);
+                    values.attr("setflags")(py::arg("write") = false);
+                    return py::make_tuple(times, values);
+                })
+                .def("consume", &adc::Sampler::consume, py::arg("count"), "取走 view 返回的前 count 个样本")
+                .def("minimum", &adc::Sampler::minimum, "各通道原始读数的最小值")
+                .def("maximum", &adc::Sampler::maximum, "各通道原始读数的最大值")
+                .def("reset_stats", &adc::Sampler::resetStats)
+                .def_property_readonly("scans", &adc::Sampler::scans)
+                .def_property_readonly("overruns", &adc::Sampler::overruns)
+                .def_property_readonly("missed", &adc::Sampler::missed)
+                .def_property_readonly("last_error", &adc::Sampler::lastError);
 
         py::class_<adc::ADCException>(m, "ADCException")
                 .def(py::init<const char *>())
@@ -87,9 +332,80 @@ PYBIND11_MODULE(up_core, m) {
                 .def(py::init<const std::string &, uint32_t, uint8_t, uint8_t>(),
                      py::arg("device"), py::arg("speed"), py::arg("mode"), py::arg("bits_per_word"),
                      "构造 SPI 对象")
-                .def("init", &spi::SPI::init, "初始化 SPI 设备")
-                .def("transfer", &spi::SPI::transfer, py::arg("tx"), py::arg("rx"), py::arg("length"),
-                     "SPI 传输数据")
+                .def("init", &spi::SPI::init, py::call_guard<py::gil_scoped_release>(), "初始化 SPI 设备")
+                // 以下传输接口接受任何支持缓冲区协议的对象，直接使用其内存，ioctl 期间释放 GIL
+                .def("transfer", [](spi::SPI &self, const py::buffer &tx) {
+                    py::buffer_info tx_info = tx.request();
+                    size_t length = contiguousBytes(tx_info, "tx");
+                    py::bytes rx(nullptr, length);
+                    uint8_t *rx_data = reinterpret_cast<uint8_t *>(PyBytes_AS_STRING(rx.ptr()));
+                    {
+                        py::gil_scoped_release release;
+                        self.transfer(static_cast<uint8_t *>(tx_info.ptr), rx_data, length);
+                    }
+                    return rx;
+                }, py::arg("tx"), "全双工传输 tx，返回同样长度的接收数据（bytes）")
+                .def("transfer", [](spi::SPI &self, const py::buffer &tx, const py::buffer &rx) {
+                    py::buffer_info tx_info = tx.request();
+                    py::buffer_info rx_info = rx.request(true);
+                    size_t length = contiguousBytes(tx_info, "tx");
+                    if (contiguousBytes(rx_info, "rx") != length) {
+                        throw py::value_error("tx and rx must have the same size");
+                    }
+                    py::gil_scoped_release release;
+                    self.transfer(static_cast<uint8_t *>(tx_info.ptr), static_cast<uint8_t *>(rx_info.ptr), length);
+                }, py::arg("tx"), py::arg("rx"), "全双工传输 tx，接收数据写入可写缓冲区 rx（长度相同）")
+                .def("transfer_segments", [](spi::SPI &self, const py::sequence &segments) {
+                    size_t count = segments.size();
+                    if (count > spi::SPI::MAX_TRANSFERS) {
+                        throw py::value_error("too many segments");
+                    }
+                    std::vector<SegmentBuffers> buffers(count);
+                    std::vector<struct spi_ioc_transfer> transfers(count);
+                    for (size_t i = 0; i < count; ++i) {
+                        py::sequence segment = segments[i].cast<py::sequence>();
+                        if (segment.size() < 2 || segment.size() > 5) {
+                            throw py::value_error("segment must be (tx, rx[, speed_hz[, cs_change[, delay_usecs]]])");
+                        }
+                        struct spi_ioc_transfer &tr = transfers[i];
+                        memset(&tr, 0, sizeof(tr));
+                        size_t length = 0;
+                        bool has_tx = !segment[0].is_none();
+                        bool has_rx = !segment[1].is_none();
+                        if (!has_tx && !has_rx) {
+                            throw py::value_error("segment needs tx or rx");
+                        }
+                        if (has_tx) {
+                            buffers[i].tx = segment[0].cast<py::buffer>().request();
+                            length = contiguousBytes(buffers[i].tx, "tx");
+                            tr.tx_buf = (unsigned long) buffers[i].tx.ptr;
+                        }
+                        if (has_rx) {
+                            buffers[i].rx = segment[1].cast<py::buffer>().request(true);
+                            size_t rx_length = contiguousBytes(buffers[i].rx, "rx");
+                            if (has_tx && rx_length != length) {
+                                throw py::value_error("tx and rx must have the same size");
+                            }
+                            length = rx_length;
+                            tr.rx_buf = (unsigned long) buffers[i].rx.ptr;
+                        }
+                        tr.len = static_cast<uint32_t>(length);
+                        if (segment.size() > 2) {
+                            tr.speed_hz = segment[2].cast<uint32_t>();
+                        }
+                        if (segment.size() > 3) {
+                            tr.cs_change = segment[3].cast<bool>() ? 1 : 0;
+                        }
+                        if (segment.size() > 4) {
+                            tr.delay_usecs = segment[4].cast<uint16_t>();
+                        }
+                    }
+                    py::gil_scoped_release release;
+                    self.transferBatch(transfers.data(), count);
+                }, py::arg("segments"),
+                     "一次 ioctl 提交多段传输。每段为 (tx, rx[, speed_hz[, cs_change[, delay_usecs]]])："
+                     "tx 为 None 时只接收（发送 0），rx 为 None 时丢弃接收数据；speed_hz 为 0 时使用构造时的速度；"
+                     "cs_change 为 True 时该段之后释放片选")
                 .def("close", &spi::SPI::close, "关闭 SPI 设备");
 
         py::class_<spi::SPIException>(m, "SPIException")
@@ -219,105 +535,105 @@ PYBIND11_MODULE(up_core, m) {
     py::class_<servo::Base>(m, "Base")
             .def(py::init<uint8_t>(), py::arg("id"))
             .def("getID", &servo::Base::getID, "获取舵机 ID")
-            .def("buildShortPacket", &servo::Base::buildShortPacket, py::arg("write_length"), py::arg("commandData"))
-            .def("buildCommandPacket", &servo::Base::buildCommandPacket, py::arg("command"), py::arg("address"),
+            .def("buildShortPacket", frameBuilder(&servo::Base::buildShortPacket), py::arg("write_length"), py::arg("commandData"))
+            .def("buildCommandPacket", frameBuilder(&servo::Base::buildCommandPacket), py::arg("command"), py::arg("address"),
                  py::arg("data"))
-            .def("buildPingPacket", &servo::Base::buildPingPacket)
-            .def("buildReadPacket", &servo::Base::buildReadPacket, py::arg("address"), py::arg("read_length"))
-            .def("buildWritePacket", &servo::Base::buildWritePacket, py::arg("address"), py::arg("data"))
-            .def("buildRegWritePacket", &servo::Base::buildRegWritePacket, py::arg("address"), py::arg("data"))
-            .def("buildActionPacket", &servo::Base::buildActionPacket)
-            .def("buildResetPacket", &servo::Base::buildResetPacket)
-            .def("buildResetBootLoader", &servo::Base::buildResetBootLoader)
-            .def("buildSyncWritePacket", &servo::Base::buildSyncWritePacket, py::arg("address"),
+            .def("buildPingPacket", frameBuilder(&servo::Base::buildPingPacket))
+            .def("buildReadPacket", frameBuilder(&servo::Base::buildReadPacket), py::arg("address"), py::arg("read_length"))
+            .def("buildWritePacket", frameBuilder(&servo::Base::buildWritePacket), py::arg("address"), py::arg("data"))
+            .def("buildRegWritePacket", frameBuilder(&servo::Base::buildRegWritePacket), py::arg("address"), py::arg("data"))
+            .def("buildActionPacket", frameBuilder(&servo::Base::buildActionPacket))
+            .def("buildResetPacket", frameBuilder(&servo::Base::buildResetPacket))
+            .def("buildResetBootLoader", frameBuilder(&servo::Base::buildResetBootLoader))
+            .def("buildSyncWritePacket", frameBuilder(&servo::Base::buildSyncWritePacket), py::arg("address"),
                  py::arg("write_length"), py::arg("protocols"), py::arg("func"));
 
 
     // servo::ServoEEPROM
     py::class_<servo::ServoEEPROM>(m, "ServoEEPROM")
             .def(py::init<uint8_t>(), py::arg("id"), "构造 ServoEEPROM 对象")
-            .def("buildGetSoftwareVersion", &servo::ServoEEPROM::buildGetSoftwareVersion, "读取软件版本")
-            .def("buildGetID", &servo::ServoEEPROM::buildGetID, "读取舵机 ID")
-            .def("buildSetID", &servo::ServoEEPROM::buildSetID, py::arg("new_id"), "设置舵机 ID")
-            .def("buildGetBaudrate", &servo::ServoEEPROM::buildGetBaudrate, "读取波特率")
-            .def("buildSetBaudrate", &servo::ServoEEPROM::buildSetBaudrate, py::arg("baud"), "设置波特率")
-            .def("buildGetReturnDelayTime", &servo::ServoEEPROM::buildGetReturnDelayTime, "读取返回延迟时间")
-            .def("buildSetReturnDelayTime", &servo::ServoEEPROM::buildSetReturnDelayTime, py::arg("delay"),
+            .def("buildGetSoftwareVersion", frameBuilder(&servo::ServoEEPROM::buildGetSoftwareVersion), "读取软件版本")
+            .def("buildGetID", frameBuilder(&servo::ServoEEPROM::buildGetID), "读取舵机 ID")
+            .def("buildSetID", frameBuilder(&servo::ServoEEPROM::buildSetID), py::arg("new_id"), "设置舵机 ID")
+            .def("buildGetBaudrate", frameBuilder(&servo::ServoEEPROM::buildGetBaudrate), "读取波特率")
+            .def("buildSetBaudrate", frameBuilder(&servo::ServoEEPROM::buildSetBaudrate), py::arg("baud"), "设置波特率")
+            .def("buildGetReturnDelayTime", frameBuilder(&servo::ServoEEPROM::buildGetReturnDelayTime), "读取返回延迟时间")
+            .def("buildSetReturnDelayTime", frameBuilder(&servo::ServoEEPROM::buildSetReturnDelayTime), py::arg("delay"),
                  "设置舵机返回数据的延迟时间（单位：微秒）")
-            .def("buildGetCwAngleLimit", &servo::ServoEEPROM::buildGetCwAngleLimit, "读取顺时针角度限制")
-            .def("buildGetCcwAngleLimit", &servo::ServoEEPROM::buildGetCcwAngleLimit, "读取逆时针角度限制")
-            .def("buildGetAngleLimit", &servo::ServoEEPROM::buildGetAngleLimit, "读取角度限制")
-            .def("buildSetAngleLimit", &servo::ServoEEPROM::buildSetAngleLimit, py::arg("min_angle"),
+            .def("buildGetCwAngleLimit", frameBuilder(&servo::ServoEEPROM::buildGetCwAngleLimit), "读取顺时针角度限制")
+            .def("buildGetCcwAngleLimit", frameBuilder(&servo::ServoEEPROM::buildGetCcwAngleLimit), "读取逆时针角度限制")
+            .def("buildGetAngleLimit", frameBuilder(&servo::ServoEEPROM::buildGetAngleLimit), "读取角度限制")
+            .def("buildSetAngleLimit", frameBuilder(&servo::ServoEEPROM::buildSetAngleLimit), py::arg("min_angle"),
                  py::arg("max_angle"),
                  "设定角度限制")
-            .def("buildGetMaxTemperature", &servo::ServoEEPROM::buildGetMaxTemperature, "读取最高温度上限")
-            .def("buildSetMaxTemperature", &servo::ServoEEPROM::buildSetMaxTemperature, py::arg("temperature"),
+            .def("buildGetMaxTemperature", frameBuilder(&servo::ServoEEPROM::buildGetMaxTemperature), "读取最高温度上限")
+            .def("buildSetMaxTemperature", frameBuilder(&servo::ServoEEPROM::buildSetMaxTemperature), py::arg("temperature"),
                  "设定最大温度")
-            .def("buildGetMinVoltage", &servo::ServoEEPROM::buildGetMinVoltage, "读取最低输入电压")
-            .def("buildGetMaxVoltage", &servo::ServoEEPROM::buildGetMaxVoltage, "读取最高输入电压")
-            .def("buildGetVoltageRange", &servo::ServoEEPROM::buildGetVoltageRange, "读取输入电压范围")
-            .def("buildSetVoltageRange", &servo::ServoEEPROM::buildSetVoltageRange, py::arg("min_voltage"),
+            .def("buildGetMinVoltage", frameBuilder(&servo::ServoEEPROM::buildGetMinVoltage), "读取最低输入电压")
+            .def("buildGetMaxVoltage", frameBuilder(&servo::ServoEEPROM::buildGetMaxVoltage), "读取最高输入电压")
+            .def("buildGetVoltageRange", frameBuilder(&servo::ServoEEPROM::buildGetVoltageRange), "读取输入电压范围")
+            .def("buildSetVoltageRange", frameBuilder(&servo::ServoEEPROM::buildSetVoltageRange), py::arg("min_voltage"),
                  py::arg("max_voltage"), "设定电压范围")
-            .def("buildGetMaxTorque", &servo::ServoEEPROM::buildGetMaxTorque, "读取最大扭矩")
-            .def("buildSetMaxTorque", &servo::ServoEEPROM::buildSetMaxTorque, py::arg("torque"), "设定最大扭矩")
-            .def("buildGetStatusReturnLevel", &servo::ServoEEPROM::buildGetStatusReturnLevel, "读取应答状态级别")
-            .def("buildSetStatusReturnLevel", &servo::ServoEEPROM::buildSetStatusReturnLevel, py::arg("level"),
+            .def("buildGetMaxTorque", frameBuilder(&servo::ServoEEPROM::buildGetMaxTorque), "读取最大扭矩")
+            .def("buildSetMaxTorque", frameBuilder(&servo::ServoEEPROM::buildSetMaxTorque), py::arg("torque"), "设定最大扭矩")
+            .def("buildGetStatusReturnLevel", frameBuilder(&servo::ServoEEPROM::buildGetStatusReturnLevel), "读取应答状态级别")
+            .def("buildSetStatusReturnLevel", frameBuilder(&servo::ServoEEPROM::buildSetStatusReturnLevel), py::arg("level"),
                  "设定应答返回级别")
-            .def("buildGetAlarmLED", &servo::ServoEEPROM::buildGetAlarmLED, "读取 LED 闪烁报警条件")
-            .def("buildSetAlarmLED", &servo::ServoEEPROM::buildSetAlarmLED, py::arg("config"), "设定 LED 报警")
-            .def("buildGetAlarmShutdown", &servo::ServoEEPROM::buildGetAlarmShutdown, "读取卸载条件")
-            .def("buildSetAlarmShutdown", &servo::ServoEEPROM::buildSetAlarmShutdown, py::arg("config"),
+            .def("buildGetAlarmLED", frameBuilder(&servo::ServoEEPROM::buildGetAlarmLED), "读取 LED 闪烁报警条件")
+            .def("buildSetAlarmLED", frameBuilder(&servo::ServoEEPROM::buildSetAlarmLED), py::arg("config"), "设定 LED 报警")
+            .def("buildGetAlarmShutdown", frameBuilder(&servo::ServoEEPROM::buildGetAlarmShutdown), "读取卸载条件")
+            .def("buildSetAlarmShutdown", frameBuilder(&servo::ServoEEPROM::buildSetAlarmShutdown), py::arg("config"),
                  "设定报警卸载条件")
-            .def("buildGetEepromData", &servo::ServoEEPROM::buildGetEepromData, py::arg("eeprom"), py::arg("length"),
+            .def("buildGetEepromData", frameBuilder(&servo::ServoEEPROM::buildGetEepromData), py::arg("eeprom"), py::arg("length"),
                  "读取EEPROM数据");
 
 
     // servo::ServoRAM
     py::class_<servo::ServoRAM>(m, "ServoRAM")
             .def(py::init<uint8_t>(), py::arg("id"), "构造 ServoRAM 对象")
-            .def("buildGetTorqueEnabled", &servo::ServoRAM::buildGetTorqueEnabled, "读取扭矩开关状态")
-            .def("buildSetTorqueEnabled", &servo::ServoRAM::buildSetTorqueEnabled, py::arg("enable"), "使能/禁用扭矩")
-            .def("buildGetLEDEnabled", &servo::ServoRAM::buildGetLEDEnabled, "读取 LED 状态")
-            .def("buildSetLEDEnabled", &servo::ServoRAM::buildSetLEDEnabled, py::arg("enable"), "设置 LED 状态")
-            .def("buildGetCwComplianceMargin", &servo::ServoRAM::buildGetCwComplianceMargin, "读取顺时针不灵敏区")
-            .def("buildGetCcwComplianceMargin", &servo::ServoRAM::buildGetCcwComplianceMargin, "读取逆时针不灵敏区")
-            .def("buildGetCwComplianceSlope", &servo::ServoRAM::buildGetCwComplianceSlope, "读取顺时针比例系数")
-            .def("buildGetCcwComplianceSlope", &servo::ServoRAM::buildGetCcwComplianceSlope, "读取逆时针比例系数")
-            .def("buildMoveToPosition", &servo::ServoRAM::buildMoveToPosition, py::arg("angle"),
+            .def("buildGetTorqueEnabled", frameBuilder(&servo::ServoRAM::buildGetTorqueEnabled), "读取扭矩开关状态")
+            .def("buildSetTorqueEnabled", frameBuilder(&servo::ServoRAM::buildSetTorqueEnabled), py::arg("enable"), "使能/禁用扭矩")
+            .def("buildGetLEDEnabled", frameBuilder(&servo::ServoRAM::buildGetLEDEnabled), "读取 LED 状态")
+            .def("buildSetLEDEnabled", frameBuilder(&servo::ServoRAM::buildSetLEDEnabled), py::arg("enable"), "设置 LED 状态")
+            .def("buildGetCwComplianceMargin", frameBuilder(&servo::ServoRAM::buildGetCwComplianceMargin), "读取顺时针不灵敏区")
+            .def("buildGetCcwComplianceMargin", frameBuilder(&servo::ServoRAM::buildGetCcwComplianceMargin), "读取逆时针不灵敏区")
+            .def("buildGetCwComplianceSlope", frameBuilder(&servo::ServoRAM::buildGetCwComplianceSlope), "读取顺时针比例系数")
+            .def("buildGetCcwComplianceSlope", frameBuilder(&servo::ServoRAM::buildGetCcwComplianceSlope), "读取逆时针比例系数")
+            .def("buildMoveToPosition", frameBuilder(&servo::ServoRAM::buildMoveToPosition), py::arg("angle"),
                  "同步 控制舵机 直接移动到目标角度")
-            .def("buildMoveToWithSpeedRpm", &servo::ServoRAM::buildMoveToWithSpeedRpm, py::arg("angle"),
+            .def("buildMoveToWithSpeedRpm", frameBuilder(&servo::ServoRAM::buildMoveToWithSpeedRpm), py::arg("angle"),
                  py::arg("rpm"), "目标角度和速度 rpm")
-            .def("buildAsyncMoveToPosition", &servo::ServoRAM::buildAsyncMoveToPosition, py::arg("angle"),
+            .def("buildAsyncMoveToPosition", frameBuilder(&servo::ServoRAM::buildAsyncMoveToPosition), py::arg("angle"),
                  "异步写 (REG_WRITE)，舵机 不立即运动，等待 ACTION 指令")
-            .def("buildActionCommand", &servo::ServoRAM::buildActionCommand, "REG_WRITE + ACTION")
-            .def("buildSetAccelerationDeceleration", &servo::ServoRAM::buildSetAccelerationDeceleration,
+            .def("buildActionCommand", frameBuilder(&servo::ServoRAM::buildActionCommand), "REG_WRITE + ACTION")
+            .def("buildSetAccelerationDeceleration", frameBuilder(&servo::ServoRAM::buildSetAccelerationDeceleration),
                  py::arg("acceleration"), py::arg("deceleration"), "设置舵机运行的加速度和减速度")
-            .def("buildGetGoalPosition", &servo::ServoRAM::buildGetGoalPosition, "读取目标位置")
-            .def("buildGetRunSpeed", &servo::ServoRAM::buildGetRunSpeed, "读取运行速度")
-            .def("buildGetPosition", &servo::ServoRAM::buildGetPosition, "读取当前位置")
-            .def("buildGetSpeed", &servo::ServoRAM::buildGetSpeed, "读取当前速度")
-            .def("buildGetAcceleration", &servo::ServoRAM::buildGetAcceleration, "读取加速度")
-            .def("buildGetDeceleration", &servo::ServoRAM::buildGetDeceleration, "读取减速度")
-            .def("buildGetAccelerationDeceleration", &servo::ServoRAM::buildGetAccelerationDeceleration,
+            .def("buildGetGoalPosition", frameBuilder(&servo::ServoRAM::buildGetGoalPosition), "读取目标位置")
+            .def("buildGetRunSpeed", frameBuilder(&servo::ServoRAM::buildGetRunSpeed), "读取运行速度")
+            .def("buildGetPosition", frameBuilder(&servo::ServoRAM::buildGetPosition), "读取当前位置")
+            .def("buildGetSpeed", frameBuilder(&servo::ServoRAM::buildGetSpeed), "读取当前速度")
+            .def("buildGetAcceleration", frameBuilder(&servo::ServoRAM::buildGetAcceleration), "读取加速度")
+            .def("buildGetDeceleration", frameBuilder(&servo::ServoRAM::buildGetDeceleration), "读取减速度")
+            .def("buildGetAccelerationDeceleration", frameBuilder(&servo::ServoRAM::buildGetAccelerationDeceleration),
                  "读取加速度和减速度")
-            .def("buildGetLoad", &servo::ServoRAM::buildGetLoad, "读取当前负载")
-            .def("buildGetVoltage", &servo::ServoRAM::buildGetVoltage, "读取当前电压")
-            .def("buildGetTemperature", &servo::ServoRAM::buildGetTemperature, "读取当前温度")
-            .def("buildCheckRegWriteFlag", &servo::ServoRAM::buildCheckRegWriteFlag, "检查 REG WRITE 是否等待执行")
-            .def("buildCheckMovingFlag", &servo::ServoRAM::buildCheckMovingFlag, "检查舵机是否正在运行")
-            .def("buildSetLockFlag", &servo::ServoRAM::buildSetLockFlag, py::arg("lock"), "设置锁标志")
-            .def("buildGetLockFlag", &servo::ServoRAM::buildGetLockFlag, "读取锁标志")
-            .def("buildSetMinPWM", &servo::ServoRAM::buildSetMinPWM, py::arg("pwm"), "设置最小PWM")
-            .def("buildGetMinPWM", &servo::ServoRAM::buildGetMinPWM, "读取最小PWM")
-            .def("buildGetRamData", &servo::ServoRAM::buildGetRamData, py::arg("ram"), py::arg("length"),
+            .def("buildGetLoad", frameBuilder(&servo::ServoRAM::buildGetLoad), "读取当前负载")
+            .def("buildGetVoltage", frameBuilder(&servo::ServoRAM::buildGetVoltage), "读取当前电压")
+            .def("buildGetTemperature", frameBuilder(&servo::ServoRAM::buildGetTemperature), "读取当前温度")
+            .def("buildCheckRegWriteFlag", frameBuilder(&servo::ServoRAM::buildCheckRegWriteFlag), "检查 REG WRITE 是否等待执行")
+            .def("buildCheckMovingFlag", frameBuilder(&servo::ServoRAM::buildCheckMovingFlag), "检查舵机是否正在运行")
+            .def("buildSetLockFlag", frameBuilder(&servo::ServoRAM::buildSetLockFlag), py::arg("lock"), "设置锁标志")
+            .def("buildGetLockFlag", frameBuilder(&servo::ServoRAM::buildGetLockFlag), "读取锁标志")
+            .def("buildSetMinPWM", frameBuilder(&servo::ServoRAM::buildSetMinPWM), py::arg("pwm"), "设置最小PWM")
+            .def("buildGetMinPWM", frameBuilder(&servo::ServoRAM::buildGetMinPWM), "读取最小PWM")
+            .def("buildGetRamData", frameBuilder(&servo::ServoRAM::buildGetRamData), py::arg("ram"), py::arg("length"),
                  "读取 RAM 数据");
 
     py::class_<servo::Motor>(m, "Motor")
             .def(py::init<uint8_t>(), py::arg("id"), "构造 Motor 对象")
-            .def("buildMotorMode", &servo::Motor::buildMotorMode, "设置舵机进入电机调速模式")
-            .def("buildServoMode", &servo::Motor::buildServoMode, "设置舵机回到舵机模式")
-            .def("buildSetMotorSpeed", &servo::Motor::buildSetMotorSpeed, py::arg("rpm"), "设置电机模式的转速")
-            .def("buildRestoreAngleLimits", &servo::Motor::buildRestoreAngleLimits, "还原角度");
+            .def("buildMotorMode", frameBuilder(&servo::Motor::buildMotorMode), "设置舵机进入电机调速模式")
+            .def("buildServoMode", frameBuilder(&servo::Motor::buildServoMode), "设置舵机回到舵机模式")
+            .def("buildSetMotorSpeed", frameBuilder(&servo::Motor::buildSetMotorSpeed), py::arg("rpm"), "设置电机模式的转速")
+            .def("buildRestoreAngleLimits", frameBuilder(&servo::Motor::buildRestoreAngleLimits), "还原角度");
 
     py::class_<servo::ServoProtocol>(m, "ServoProtocol")
             .def(py::init<uint8_t>(), py::arg("id"), "构造 ServoProtocol 对象")
@@ -372,6 +688,17 @@ PYBIND11_MODULE(up_core, m) {
             .def_readwrite("write_timeout_constant", &serial::Timeout::write_timeout_constant)
             .def_readwrite("write_timeout_multiplier", &serial::Timeout::write_timeout_multiplier);
 
+    // 低延迟模式实际生效的配置
+    py::class_<serial::LowLatencyInfo>(m, "LowLatencyInfo")
+            .def_readonly("enabled", &serial::LowLatencyInfo::enabled)
+            .def_readonly("async_low_latency", &serial::LowLatencyInfo::async_low_latency)
+            .def_readonly("latency_timer_ms", &serial::LowLatencyInfo::latency_timer_ms)
+            .def_readonly("immediate_read", &serial::LowLatencyInfo::immediate_read)
+            .def_readonly("details", &serial::LowLatencyInfo::details)
+            .def("__repr__", [](const serial::LowLatencyInfo &info) {
+                return "<LowLatencyInfo " + info.details + ">";
+            });
+
     // Bind the Serial class
     py::class_<serial::Serial, std::shared_ptr<serial::Serial> >(m, "Serial")
             .def(py::init<const std::string &, uint32_t, serial::Timeout, serial::bytesize_t, serial::parity_t,
@@ -383,12 +710,13 @@ PYBIND11_MODULE(up_core, m) {
                  py::arg("parity") = serial::parity_none,
                  py::arg("stopbits") = serial::stopbits_one,
                  py::arg("flowcontrol") = serial::flowcontrol_none)
-            .def("open", &serial::Serial::open)
+            // 会等待设备或超时的调用都释放 GIL，其他 Python 线程（如 pup_core 的事件循环）可以继续运行
+            .def("open", &serial::Serial::open, py::call_guard<py::gil_scoped_release>())
             .def("isOpen", &serial::Serial::isOpen)
-            .def("close", &serial::Serial::close)
+            .def("close", &serial::Serial::close, py::call_guard<py::gil_scoped_release>())
             .def("available", &serial::Serial::available)
-            .def("waitReadable", &serial::Serial::waitReadable)
-            .def("waitByteTimes", &serial::Serial::waitByteTimes)
+            .def("waitReadable", &serial::Serial::waitReadable, py::call_guard<py::gil_scoped_release>())
+            .def("waitByteTimes", &serial::Serial::waitByteTimes, py::call_guard<py::gil_scoped_release>())
 
             // 绑定第一个 read 函数：接收 uint8_t* 缓冲区和大小
             .def("read_bytes", [](serial::Serial &self, py::buffer &buffer, size_t size) {
@@ -400,26 +728,33 @@ PYBIND11_MODULE(up_core, m) {
                 }
                 // 获取指向缓冲区的指针
                 uint8_t *ptr = static_cast<uint8_t *>(buf_info.ptr);
-                // 调用 C++ 的 read 函数
-                size_t bytes_read = self.read(ptr, size);
-                // 返回读取的字节数
-                return bytes_read;
+                // 调用 C++ 的 read 函数，等待数据期间释放 GIL
+                py::gil_scoped_release release;
+                return self.read(ptr, size);
             })
 
             // 绑定第二个 read 函数：接收 std::vector<uint8_t>
             .def("read", [](serial::Serial &self, size_t size) {
                 std::vector<uint8_t> buffer;
-                // 调用 C++ 的 std::vector 版本的 read 函数
-                size_t bytes_read = self.read(buffer, size);
-                // 返回读取的数据和读取的字节数
-                return py::make_tuple(buffer, bytes_read);
+                size_t bytes_read;
+                {
+                    // 调用 C++ 的 std::vector 版本的 read 函数
+                    py::gil_scoped_release release;
+                    bytes_read = self.read(buffer, size);
+                }
+                // 返回读取的数据（bytes）和读取的字节数
+                return py::make_tuple(toBytes(buffer), bytes_read);
             })
 
             // 绑定第一个 read 函数：接收 std::string 引用
             .def("read_string", [](serial::Serial &self, size_t size) {
                 std::string buffer;
-                // 调用 C++ 的 std::string 版本的 read 函数
-                size_t bytes_read = self.read(buffer, size);
+                size_t bytes_read;
+                {
+                    // 调用 C++ 的 std::string 版本的 read 函数
+                    py::gil_scoped_release release;
+                    bytes_read = self.read(buffer, size);
+                }
                 // 返回读取的数据和字节数
                 return py::make_tuple(buffer, bytes_read);
             })
@@ -427,16 +762,18 @@ PYBIND11_MODULE(up_core, m) {
             // 绑定第二个 read 函数：返回 std::string
             .def("read_str", [](serial::Serial &self, size_t size) {
                 // 直接调用 C++ 中返回 std::string 的 read 函数
-                std::string result = self.read(size);
-                // 返回结果
-                return result;
-            })
+                return self.read(size);
+            }, py::call_guard<py::gil_scoped_release>())
 
             // 绑定第一个 readline 函数：接收 string 引用
             .def("readline_buffer", [](serial::Serial &self, size_t size, const std::string &eol) {
                 std::string buffer;
-                // 调用 C++ 的 readline 函数
-                size_t bytes_read = self.readline(buffer, size, eol);
+                size_t bytes_read;
+                {
+                    // 调用 C++ 的 readline 函数
+                    py::gil_scoped_release release;
+                    bytes_read = self.readline(buffer, size, eol);
+                }
                 // 返回读取的数据和字节数
                 return py::make_tuple(buffer, bytes_read);
             })
@@ -444,24 +781,58 @@ PYBIND11_MODULE(up_core, m) {
             // 绑定第二个 readline 函数：返回 string
             .def("readline", [](serial::Serial &self, size_t size, const std::string &eol) {
                 // 直接调用 C++ 中返回 std::string 的 readline 函数
-                std::string result = self.readline(size, eol);
-                // 返回结果
-                return result;
-            })
+                return self.readline(size, eol);
+            }, py::call_guard<py::gil_scoped_release>())
 
             // 绑定 readlines 函数：返回 vector<string>
             .def("readlines", [](serial::Serial &self, size_t size, const std::string &eol) {
-                // 调用 C++ 中的 readlines 函数
-                std::vector<std::string> lines = self.readlines(size, eol);
+                std::vector<std::string> lines;
+                {
+                    // 调用 C++ 中的 readlines 函数
+                    py::gil_scoped_release release;
+                    lines = self.readlines(size, eol);
+                }
                 // 返回 Python 列表
                 return py::cast(lines);
             })
 
-            .def("write", py::overload_cast<const uint8_t *, size_t>(&serial::Serial::write))
-            .def("write", py::overload_cast<const std::vector<uint8_t> &>(&serial::Serial::write))
-            .def("write", py::overload_cast<const std::string &>(&serial::Serial::write))
-            .def("setPort", &serial::Serial::setPort)
+            // 绑定 readUntil 函数：读取直到分隔符，返回 bytes
+            .def("readUntil", [](serial::Serial &self, const py::bytes &delimiter, size_t size) {
+                std::string buffer;
+                std::string delimiter_bytes = delimiter;
+                {
+                    py::gil_scoped_release release;
+                    self.readUntil(buffer, delimiter_bytes, size);
+                }
+                return py::bytes(buffer);
+            }, py::arg("delimiter"), py::arg("size") = 65536)
+
+            // bytes / bytearray / memoryview / NumPy 等缓冲区直接写出，不转换为列表
+            .def("write", [](serial::Serial &self, const py::buffer &data) {
+                py::buffer_info info = data.request();
+                size_t size = contiguousBytes(info, "data");
+                py::gil_scoped_release release;
+                return self.write(static_cast<const uint8_t *>(info.ptr), size);
+            }, py::arg("data"))
+            .def("write", py::overload_cast<const std::vector<uint8_t> &>(&serial::Serial::write),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("write", py::overload_cast<const std::string &>(&serial::Serial::write),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("setPort", &serial::Serial::setPort, py::call_guard<py::gil_scoped_release>())
             .def("getPort", &serial::Serial::getPort)
+            .def("getReadTimestamp", &serial::Serial::getReadTimestamp,
+                 "最近一次读取的数据从内核读出的时间（CLOCK_MONOTONIC 纳秒，与 time.monotonic_ns() 同源）")
+            .def("getWriteTimestamp", &serial::Serial::getWriteTimestamp,
+                 "最近一次写入交给驱动的时间，flush() 后为发送完成的时间")
+            .def("writeBatch", &serial::Serial::writeBatch, py::arg("frames"), py::call_guard<py::gil_scoped_release>(),
+                 "批量写入多个数据帧")
+            .def("setRecorder", &serial::Serial::setRecorder, py::arg("recorder"), py::arg("channel") = 0,
+                 "录制收发的全部数据，传入 None 停止录制")
+            .def("getRecorder", &serial::Serial::getRecorder)
+            .def("setLowLatency", &serial::Serial::setLowLatency, py::arg("enabled"),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "开启或关闭低延迟模式（ASYNC_LOW_LATENCY、latency_timer、立即读取），返回实际生效的配置")
+            .def("getLowLatency", &serial::Serial::getLowLatency)
             .def("setTimeout", py::overload_cast<serial::Timeout &>(&serial::Serial::setTimeout))
             .def("setTimeout",
                  py::overload_cast<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>(&serial::Serial::setTimeout))
@@ -476,14 +847,14 @@ PYBIND11_MODULE(up_core, m) {
             .def("getStopbits", &serial::Serial::getStopbits)
             .def("setFlowcontrol", &serial::Serial::setFlowcontrol)
             .def("getFlowcontrol", &serial::Serial::getFlowcontrol)
-            .def("flush", &serial::Serial::flush)
-            .def("flushInput", &serial::Serial::flushInput)
-            .def("flushOutput", &serial::Serial::flushOutput)
-            .def("sendBreak", &serial::Serial::sendBreak)
+            .def("flush", &serial::Serial::flush, py::call_guard<py::gil_scoped_release>())
+            .def("flushInput", &serial::Serial::flushInput, py::call_guard<py::gil_scoped_release>())
+            .def("flushOutput", &serial::Serial::flushOutput, py::call_guard<py::gil_scoped_release>())
+            .def("sendBreak", &serial::Serial::sendBreak, py::call_guard<py::gil_scoped_release>())
             .def("setBreak", &serial::Serial::setBreak)
             .def("setRTS", &serial::Serial::setRTS)
             .def("setDTR", &serial::Serial::setDTR)
-            .def("waitForChange", &serial::Serial::waitForChange)
+            .def("waitForChange", &serial::Serial::waitForChange, py::call_guard<py::gil_scoped_release>())
             .def("getCTS", &serial::Serial::getCTS)
             .def("getDSR", &serial::Serial::getDSR)
             .def("getRI", &serial::Serial::getRI)
@@ -515,8 +886,159 @@ PYBIND11_MODULE(up_core, m) {
     // Bind the list_ports function
     m.def("list_ports", &serial::list_ports);
 
+#ifdef __linux__
+    // 事件循环：一个线程服务多个串口，回调在事件循环线程中调用，调用前获取 GIL
+    py::class_<serial::Reactor, std::shared_ptr<serial::Reactor> >(m, "Reactor")
+            .def(py::init([] {
+                return std::shared_ptr<serial::Reactor>(new serial::Reactor(),
+                                                        GilReleasingDeleter<serial::Reactor>());
+            }))
+            .def("start", &serial::Reactor::start, "在后台线程中运行事件循环")
+            .def("stop", &serial::Reactor::stop, py::call_guard<py::gil_scoped_release>(), "停止事件循环")
+            .def("running", &serial::Reactor::running)
+            .def("readTimestamp", &serial::Reactor::readTimestamp, "读回调中的数据读出的时间（CLOCK_MONOTONIC 纳秒）")
+            .def("add",
+                 [](serial::Reactor &self, const std::shared_ptr<serial::Serial> &port,
+                    std::function<void(py::bytes)> on_read, std::function<void(int)> on_error) {
+                     serial::Reactor::ErrorCallback error_callback;
+                     if (on_error) {
+                         error_callback = [on_error](int error) {
+                             py::gil_scoped_acquire acquire;
+                             try {
+                                 on_error(error);
+                             } catch (py::error_already_set &e) {
+                                 e.discard_as_unraisable("Reactor error callback");
+                             }
+                         };
+                     }
+                     serial::Reactor::ReadCallback read_callback = [on_read](const uint8_t *data, size_t size) {
+                         py::gil_scoped_acquire acquire;
+                         try {
+                             on_read(py::bytes(reinterpret_cast<const char *>(data), size));
+                         } catch (py::error_already_set &e) {
+                             e.discard_as_unraisable("Reactor read callback");
+                         }
+                     };
+                     // add 等待事件循环线程完成注册，该线程可能正在等待 GIL 调用其他端口的回调
+                     py::gil_scoped_release release;
+                     self.add(port, std::move(read_callback), std::move(error_callback));
+                 },
+                 py::arg("serial"), py::arg("on_read"), py::arg("on_error") = nullptr,
+                 "把串口加入事件循环，收到数据时以 bytes 调用 on_read")
+            .def("remove", &serial::Reactor::remove, py::arg("serial"),
+                 py::call_guard<py::gil_scoped_release>(), "把串口移出事件循环")
+            .def("send",
+                 [](serial::Reactor &self, const std::shared_ptr<serial::Serial> &port, const py::bytes &data) {
+                     std::string buffer = data;
+                     return self.send(port, reinterpret_cast<const uint8_t *>(buffer.data()), buffer.size());
+                 },
+                 py::arg("serial"), py::arg("data"), "把数据加入端口的写队列")
+            .def("pending", &serial::Reactor::pending, py::arg("serial"), py::call_guard<py::gil_scoped_release>(),
+                 "写队列中尚未发出的字节数")
+            .def("addTimer",
+                 [](serial::Reactor &self, uint32_t delay_ms, std::function<void()> callback, uint32_t interval_ms) {
+                     return self.addTimer(delay_ms, [callback]() {
+                         py::gil_scoped_acquire acquire;
+                         try {
+                             callback();
+                         } catch (py::error_already_set &e) {
+                             e.discard_as_unraisable("Reactor timer callback");
+                         }
+                     }, interval_ms);
+                 },
+                 py::arg("delay_ms"), py::arg("callback"), py::arg("interval_ms") = 0,
+                 "添加定时器，interval_ms 为 0 时只触发一次")
+            .def("cancelTimer", &serial::Reactor::cancelTimer, py::arg("id"));
+#endif
+
+    m.def("monotonic_ns", &serial::monotonicNs, "收发时间戳使用的单调时钟（纳秒），Linux 上与 time.monotonic_ns() 相同");
+
+    // 串口流量录制与回放
+    py::class_<serial::Recorder, std::shared_ptr<serial::Recorder> > recorder(m, "Recorder");
+    py::enum_<serial::Recorder::Direction>(recorder, "Direction")
+            .value("RX", serial::Recorder::RX)
+            .value("TX", serial::Recorder::TX)
+            .export_values();
+    recorder
+            .def(py::init<const std::string &, size_t, uint32_t>(),
+                 py::arg("path"), py::arg("buffer_size") = 64 * 1024, py::arg("flush_interval_ms") = 100)
+            .def("record",
+                 [](serial::Recorder &self, serial::Recorder::Direction direction, const py::bytes &data,
+                    uint64_t timestamp_ns, uint8_t channel) {
+                     std::string buffer = data;
+                     self.record(direction, reinterpret_cast<const uint8_t *>(buffer.data()), buffer.size(),
+                                 timestamp_ns != 0 ? timestamp_ns : serial::monotonicNs(), channel);
+                 },
+                 py::arg("direction"), py::arg("data"), py::arg("timestamp_ns") = 0, py::arg("channel") = 0,
+                 "追加一条记录，timestamp_ns 为 0 时使用当前时间")
+            .def("flush", &serial::Recorder::flush, py::call_guard<py::gil_scoped_release>(), "等待记录全部写入文件")
+            .def("close", &serial::Recorder::close, py::call_guard<py::gil_scoped_release>())
+            .def("startTime", &serial::Recorder::startTime)
+            .def("records", &serial::Recorder::records)
+            .def("bytes", &serial::Recorder::bytes);
+
+    py::class_<serial::Recording::Record>(m, "RecordingRecord")
+            .def_readonly("time_ns", &serial::Recording::Record::time_ns)
+            .def_readonly("direction", &serial::Recording::Record::direction)
+            .def_readonly("channel", &serial::Recording::Record::channel)
+            .def_property_readonly("data", [](const serial::Recording::Record &record) {
+                return py::bytes(reinterpret_cast<const char *>(record.data.data()), record.data.size());
+            });
+
+    py::class_<serial::Recording>(m, "Recording")
+            .def_static("fromFile", &serial::Recording::fromFile, py::arg("path"))
+            .def("startTime", &serial::Recording::startTime)
+            .def("records", &serial::Recording::records)
+            .def("duration", &serial::Recording::duration);
+
+    py::class_<serial::Replayer, std::shared_ptr<serial::Replayer> >(m, "Replayer")
+            .def(py::init<serial::Recording>(), py::arg("recording"))
+            .def("setSpeed", &serial::Replayer::setSpeed, py::arg("speed"), "1 为原始时序，大于 1 加速，0 不等待")
+            .def("getSpeed", &serial::Replayer::getSpeed)
+            .def("setChannel", &serial::Replayer::setChannel, py::arg("channel"), "-1 为全部通道")
+            .def("setDirections", &serial::Replayer::setDirections, py::arg("rx"), py::arg("tx"))
+            .def("run",
+                 [](serial::Replayer &self, const std::function<void(const serial::Recording::Record &, uint64_t)> &sink) {
+                     // 等待期间释放 GIL，调用回调时重新获取
+                     py::gil_scoped_release release;
+                     return self.run([&sink](const serial::Recording::Record &record, uint64_t now_ns) {
+                         py::gil_scoped_acquire acquire;
+                         sink(record, now_ns);
+                     });
+                 },
+                 py::arg("sink"), "按时序以 (record, now_ns) 调用 sink，返回回放的记录数")
+            .def("run",
+                 [](serial::Replayer &self, Servo &servo) {
+                     py::gil_scoped_release release;
+                     return self.run([&servo](const serial::Recording::Record &record, uint64_t now_ns) {
+                         servo.inject(record.data.data(), record.data.size(), now_ns);
+                     });
+                 },
+                 py::arg("servo"), "把记录按时序注入 Servo 的解析路径，返回回放的记录数")
+            .def("stop", &serial::Replayer::stop);
+
+#ifdef __linux__
+    py::class_<serial::ReplayPort>(m, "ReplayPort")
+            .def(py::init<>())
+            .def("port", &serial::ReplayPort::port, "伪终端从端的设备路径")
+            .def("start", &serial::ReplayPort::start, py::arg("replayer"), py::call_guard<py::gil_scoped_release>())
+            .def("wait", &serial::ReplayPort::wait, py::call_guard<py::gil_scoped_release>())
+            .def("stop", &serial::ReplayPort::stop, py::call_guard<py::gil_scoped_release>())
+            .def("finished", &serial::ReplayPort::finished);
+#endif
+
+    // 数据帧的收发时间
+    py::class_<FrameTimestamp>(m, "FrameTimestamp")
+            .def_readonly("rx_ns", &FrameTimestamp::rx_ns)
+            .def_readonly("tx_ns", &FrameTimestamp::tx_ns)
+            .def_property_readonly("response_us", &FrameTimestamp::responseUs)
+            .def("__repr__", [](const FrameTimestamp &timestamp) {
+                return "<FrameTimestamp rx_ns=" + std::to_string(timestamp.rx_ns) +
+                       " tx_ns=" + std::to_string(timestamp.tx_ns) + ">";
+            });
+
     // Servo
-    py::class_<Servo>(m, "Servo")
+    py::class_<Servo, std::unique_ptr<Servo, GilReleasingDeleter<Servo> > >(m, "Servo")
 #ifdef __linux__
         .def(py::init<std::shared_ptr<serial::Serial>, std::shared_ptr<gpio::GPIO>>(),
              py::arg("serial"), py::arg("gpio") = nullptr, "构造 Servo 对象")
@@ -524,10 +1046,46 @@ PYBIND11_MODULE(up_core, m) {
             .def(py::init<std::shared_ptr<serial::Serial> >(),
                  py::arg("serial"), "构造 Servo 对象")
 #endif
-            .def("init", &Servo::init, "Initialize the servo")
-            .def("close", &Servo::close, "Close the servo connection")
-            .def("send_command", &Servo::sendCommand, py::arg("frame"), "Send command to the servo")
-            .def("set_data_callback", &Servo::setDataCallback, "Set a data reception callback");
+            .def("init", static_cast<void (Servo::*)()>(&Servo::init), "Initialize the servo")
+#ifdef __linux__
+            .def("init", static_cast<void (Servo::*)(const std::shared_ptr<serial::Reactor> &)>(&Servo::init),
+                 py::arg("reactor"), py::call_guard<py::gil_scoped_release>(),
+                 "Initialize the servo, receiving through the reactor")
+#endif
+            .def("close", &Servo::close, py::call_guard<py::gil_scoped_release>(), "Close the servo connection")
+            .def("send_command", [](Servo &self, const py::buffer &frame) {
+                py::buffer_info info = frame.request();
+                size_t size = contiguousBytes(info, "frame");
+                py::gil_scoped_release release;
+                return self.sendCommand(static_cast<const uint8_t *>(info.ptr), size);
+            }, py::arg("frame"), "Send command to the servo, frame is any bytes-like object (not copied)")
+            .def("send_command", py::overload_cast<const std::vector<uint8_t> &>(&Servo::sendCommand), py::arg("frame"),
+                 py::call_guard<py::gil_scoped_release>(), "Send command to the servo, frame is a list of ints")
+            .def("send_commands", &Servo::sendCommands, py::arg("frames"), py::call_guard<py::gil_scoped_release>(),
+                 "Send several frames in one bus-enable window with a single vectored write")
+            .def("inject", [](Servo &self, const py::bytes &data, uint64_t rx_ns) {
+                std::string buffer = data;
+                return self.inject(reinterpret_cast<const uint8_t *>(buffer.data()), buffer.size(), rx_ns);
+            }, py::arg("data"), py::arg("rx_ns") = 0, "Feed received bytes into the packet parser")
+            // 回调在接收线程中调用
+            .def("set_data_callback", [](Servo &self, std::function<void(const std::vector<uint8_t> &)> callback) {
+                self.setDataCallback(withGil(std::move(callback), "Servo data callback"));
+            }, py::arg("callback"), "Set a data reception callback")
+            .def("set_timed_data_callback",
+                 [](Servo &self, std::function<void(const std::vector<uint8_t> &, const FrameTimestamp &)> callback) {
+                     self.setTimedDataCallback(withGil(std::move(callback), "Servo timed data callback"));
+                 }, py::arg("callback"), "Set a data reception callback called with (data, FrameTimestamp)")
+            .def("send_wait_command", [](Servo &self, const std::vector<uint8_t> &frame) {
+                std::vector<uint8_t> response;
+                FrameTimestamp timestamp;
+                bool success;
+                {
+                    py::gil_scoped_release release;
+                    success = self.sendWaitCommand(frame, response, timestamp);
+                }
+                return py::make_tuple(success, toBytes(response), timestamp);
+            }, py::arg("frame"),
+                 "Send a command and wait for the response, returns (success, response, FrameTimestamp)");
 
     // 绑定 ServoManager 类
     py::class_<ServoManager>(m, "ServoManager")
@@ -535,10 +1093,15 @@ PYBIND11_MODULE(up_core, m) {
             .def("searching", &ServoManager::searching, "是否正在搜索舵机")
             .def("setSearchTimeout", &ServoManager::setSearchTimeout, py::arg("timeout"), "设置搜索超时时间")
             .def("setVerify", &ServoManager::setVerify, py::arg("verify"), "设置校验标志")
-            .def("setCallback", &ServoManager::setCallback, py::arg("callback"), "设置回调函数")
+            // 回调在搜索线程中调用
+            .def("setCallback", [](ServoManager &self, std::function<void(int, int, int)> callback) {
+                self.setCallback(withGil(std::move(callback), "ServoManager callback"));
+            }, py::arg("callback"), "设置回调函数 (波特率, ID, 错误码)")
+            // 重新搜索时会关闭上一次搜索的舵机并等待其接收线程退出，期间需要释放 GIL
             .def("startSearchServoID", &ServoManager::startSearchServoID, py::arg("port"), py::arg("baudrates"),
-                 "启动舵机搜索")
-            .def("stopSearchServoID", &ServoManager::stopSearchServoID, "停止舵机搜索");
+                 py::call_guard<py::gil_scoped_release>(), "启动舵机搜索")
+            .def("stopSearchServoID", &ServoManager::stopSearchServoID, py::call_guard<py::gil_scoped_release>(),
+                 "停止舵机搜索");
 
 
     // 绑定 servo 命名空间中的全局函数
@@ -565,6 +1128,68 @@ PYBIND11_MODULE(up_core, m) {
 
     m.def("setConsoleOutputCP", &setConsoleOutputCP, "");
 
+    py::enum_<UpgradePhase>(m, "UpgradePhase")
+            .value("Idle", UpgradePhase::Idle)
+            .value("Bootloader", UpgradePhase::Bootloader)
+            .value("Handshake", UpgradePhase::Handshake)
+            .value("Transfer", UpgradePhase::Transfer)
+            .value("Wave", UpgradePhase::Wave)
+            .value("Done", UpgradePhase::Done)
+            .value("Failed", UpgradePhase::Failed);
+
+    py::class_<UpgradeMetrics>(m, "UpgradeMetrics")
+            .def_readonly("phase", &UpgradeMetrics::phase)
+            .def_readonly("round", &UpgradeMetrics::round)
+            .def_readonly("bootloader_seconds", &UpgradeMetrics::bootloader_seconds)
+            .def_readonly("handshake_seconds", &UpgradeMetrics::handshake_seconds)
+            .def_readonly("transfer_seconds", &UpgradeMetrics::transfer_seconds)
+            .def_readonly("wave_seconds", &UpgradeMetrics::wave_seconds)
+            .def_readonly("elapsed_seconds", &UpgradeMetrics::elapsed_seconds)
+            .def_readonly("frames_total", &UpgradeMetrics::frames_total)
+            .def_readonly("frames_acked", &UpgradeMetrics::frames_acked)
+            .def_readonly("frames_sent", &UpgradeMetrics::frames_sent)
+            .def_readonly("frames_retried", &UpgradeMetrics::frames_retried)
+            .def_readonly("bytes_acked", &UpgradeMetrics::bytes_acked)
+            .def_readonly("bytes_per_second", &UpgradeMetrics::bytes_per_second)
+            .def_readonly("block_size", &UpgradeMetrics::block_size)
+            .def_readonly("baud_rate", &UpgradeMetrics::baud_rate)
+            .def_readonly("nak_count", &UpgradeMetrics::nak_count)
+            .def_readonly("timeout_count", &UpgradeMetrics::timeout_count)
+            .def_readonly("write_error_count", &UpgradeMetrics::write_error_count)
+            .def_readonly("cancel_count", &UpgradeMetrics::cancel_count)
+            .def_readonly("bootloader_failures", &UpgradeMetrics::bootloader_failures)
+            .def_readonly("handshake_failures", &UpgradeMetrics::handshake_failures)
+            .def_readonly("transfer_failures", &UpgradeMetrics::transfer_failures)
+            .def_readonly("wave_failures", &UpgradeMetrics::wave_failures)
+            .def_readonly("resumes", &UpgradeMetrics::resumes);
+
+    // 固件包：加载时完成校验并预组装数据帧
+    py::class_<FirmwarePackage>(m, "FirmwarePackage")
+            .def_static("pack", [](const py::buffer &image, const std::string &model, const std::string &version,
+                                   size_t block_size) {
+                            py::buffer_info buf_info = image.request();
+                            size_t size = contiguousBytes(buf_info, "image");
+                            std::vector<uint8_t> packed = FirmwarePackage::pack(
+                                    static_cast<const uint8_t *>(buf_info.ptr), size, model, version, block_size);
+                            return py::bytes(reinterpret_cast<const char *>(packed.data()), packed.size());
+                        },
+                        py::arg("image"), py::arg("model"), py::arg("version"),
+                        py::arg("block_size") = FirmwareFrameStream::BLOCK_SIZE, "把固件镜像打包为固件包")
+            .def_static("fromFile", &FirmwarePackage::fromFile, py::arg("path"), "读取并校验固件包文件")
+            .def_static("fromBytes", [](const py::buffer &data) {
+                            py::buffer_info buf_info = data.request();
+                            size_t size = contiguousBytes(buf_info, "data");
+                            return FirmwarePackage::fromBuffer(static_cast<const uint8_t *>(buf_info.ptr), size);
+                        },
+                        py::arg("data"), "复制并校验内存中的固件包")
+            .def_property_readonly("model", &FirmwarePackage::model)
+            .def_property_readonly("version", &FirmwarePackage::version)
+            .def_property_readonly("image_size", &FirmwarePackage::imageSize)
+            .def_property_readonly("block_size", &FirmwarePackage::blockSize)
+            .def_property_readonly("frame_count", &FirmwarePackage::frameCount)
+            .def_property_readonly("image_crc", &FirmwarePackage::imageCrc);
+
+    // 升级期间释放 GIL，其他 Python 线程可以在回调之外查询进度；回调由 pybind 重新获取 GIL
     py::class_<FirmwareUpdate>(m, "FirmwareUpdate")
             .def(py::init<>()) // 绑定构造函数
             // 绑定 upgrade 方法，并支持默认参数
@@ -577,6 +1202,29 @@ PYBIND11_MODULE(up_core, m) {
                  py::arg("handshake_threshold") = 5,
                  py::arg("frame_retry_count") = 5,
                  py::arg("sign_retry_count") = 5,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "升级固件的方法")
+            // 支持缓冲区协议的对象（bytes / bytearray / memoryview / numpy）直接引用内存，不复制
+            .def("upgrade_stream", [](FirmwareUpdate &self, const std::string &port_input, int baud_rate,
+                                      const py::buffer &fileBuffer, uint8_t servo_id, int total_retry,
+                                      int handshake_threshold, int frame_retry_count, int sign_retry_count) {
+                     py::buffer_info buf_info = fileBuffer.request();
+                     // 带步长或反向的视图不能按连续内存读取
+                     size_t size = contiguousBytes(buf_info, "fileBuffer");
+                     py::gil_scoped_release release;
+                     return self.upgrade_buffer(port_input, baud_rate,
+                                                static_cast<const uint8_t *>(buf_info.ptr), size, servo_id,
+                                                total_retry, handshake_threshold,
+                                                frame_retry_count, sign_retry_count);
+                 },
+                 py::arg("port_input"),
+                 py::arg("baud_rate"),
+                 py::arg("fileBuffer"),
+                 py::arg("servo_id"),
+                 py::arg("total_retry") = 10,
+                 py::arg("handshake_threshold") = 5,
+                 py::arg("frame_retry_count") = 5,
+                 py::arg("sign_retry_count") = 5,
                  "升级固件的方法")
             .def("upgrade_stream", &FirmwareUpdate::upgrade_stream,
                  py::arg("port_input"),
@@ -587,5 +1235,80 @@ PYBIND11_MODULE(up_core, m) {
                  py::arg("handshake_threshold") = 5,
                  py::arg("frame_retry_count") = 5,
                  py::arg("sign_retry_count") = 5,
-                 "升级固件的方法");
+                 py::call_guard<py::gil_scoped_release>(),
+                 "升级固件的方法")
+            .def("upgrade_package", &FirmwareUpdate::upgrade_package,
+                 py::arg("port_input"),
+                 py::arg("baud_rate"),
+                 py::arg("package"),
+                 py::arg("servo_id"),
+                 py::arg("total_retry") = 10,
+                 py::arg("handshake_threshold") = 5,
+                 py::arg("frame_retry_count") = 5,
+                 py::arg("sign_retry_count") = 5,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "使用已校验的固件包升级")
+            // 回调在升级线程中调用，抛出的异常不会中断传输
+            .def("setProgressCallback", [](FirmwareUpdate &self, FirmwareUpdate::ProgressCallback callback) {
+                     self.setProgressCallback(withGil(std::move(callback), "FirmwareUpdate progress callback"));
+                 }, py::arg("callback"), "设置进度回调 (已发送帧数, 总帧数)")
+            .def("setResume", &FirmwareUpdate::setResume, py::arg("enable"), py::arg("retry_interval_ms") = 100,
+                 "设置断点续传及重试间隔（毫秒）")
+            .def("setTransferOptions", &FirmwareUpdate::setTransferOptions, py::arg("block_size"),
+                 py::arg("transfer_baud_rate") = 0, "设置数据块大小（128 / 1024）及握手后切换的波特率")
+            .def("setAckTimeoutMargin", &FirmwareUpdate::setAckTimeoutMargin, py::arg("margin_ms"),
+                 "设置数据帧应答超时在传输时间之外的余量（毫秒）")
+            .def("acknowledgedFrames", &FirmwareUpdate::acknowledgedFrames, "已被设备确认的数据帧数")
+            .def("setMetricsCallback", [](FirmwareUpdate &self, FirmwareUpdate::MetricsCallback callback) {
+                     self.setMetricsCallback(withGil(std::move(callback), "FirmwareUpdate metrics callback"));
+                 }, py::arg("callback"), "设置统计回调，阶段切换及每个数据帧被确认时调用 (UpgradeMetrics)")
+            .def("getMetrics", &FirmwareUpdate::getMetrics, "获取当前统计数据");
+
+    py::class_<RolloutTarget>(m, "RolloutTarget")
+            .def(py::init<>())
+            .def(py::init<std::string, uint8_t>(), py::arg("port"), py::arg("servo_id"))
+            .def_readwrite("port", &RolloutTarget::port)
+            .def_readwrite("servo_id", &RolloutTarget::servo_id);
+
+    py::class_<RolloutResult>(m, "RolloutResult")
+            .def_readonly("target", &RolloutResult::target)
+            .def_readonly("success", &RolloutResult::success)
+            .def_readonly("seconds", &RolloutResult::seconds)
+            .def_readonly("error", &RolloutResult::error)
+            .def_readonly("metrics", &RolloutResult::metrics);
+
+    // 批量升级在工作线程中调用回调，run 期间必须释放 GIL，回调时由 pybind 重新获取
+    py::class_<FirmwareRollout>(m, "FirmwareRollout")
+            .def(py::init<int, size_t>(), py::arg("baud_rate"), py::arg("max_workers") = 0)
+            .def("setRetry", &FirmwareRollout::setRetry,
+                 py::arg("total_retry") = 10,
+                 py::arg("handshake_threshold") = 5,
+                 py::arg("frame_retry_count") = 5,
+                 py::arg("sign_retry_count") = 5,
+                 "设置重试参数")
+            .def("setTransferOptions", &FirmwareRollout::setTransferOptions, py::arg("block_size"),
+                 py::arg("transfer_baud_rate") = 0, "设置数据块大小（128 / 1024）及握手后切换的波特率")
+            .def("setProgressCallback", [](FirmwareRollout &self, FirmwareRollout::ProgressCallback callback) {
+                     self.setProgressCallback(withGil(std::move(callback), "FirmwareRollout progress callback"));
+                 }, py::arg("callback"), "设置进度回调 (目标下标, 已发送帧数, 总帧数)")
+            .def("setResultCallback", [](FirmwareRollout &self, FirmwareRollout::ResultCallback callback) {
+                     self.setResultCallback(withGil(std::move(callback), "FirmwareRollout result callback"));
+                 }, py::arg("callback"), "设置结果回调 (目标下标, 升级结果)")
+            .def("run", [](FirmwareRollout &self, const std::vector<RolloutTarget> &targets,
+                           const py::buffer &fileBuffer) {
+                     py::buffer_info buf_info = fileBuffer.request();
+                     // 各工作线程直接读取这块内存，只接受连续的缓冲区
+                     size_t size = contiguousBytes(buf_info, "fileBuffer");
+                     py::gil_scoped_release release;
+                     return self.run(targets, static_cast<const uint8_t *>(buf_info.ptr), size);
+                 },
+                 py::arg("targets"), py::arg("fileBuffer"), "批量升级固件")
+            .def("runPackage", [](FirmwareRollout &self, const std::vector<RolloutTarget> &targets,
+                                  const FirmwarePackage &package) {
+                     return self.run(targets, package);
+                 },
+                 py::arg("targets"), py::arg("package"), py::call_guard<py::gil_scoped_release>(),
+                 "使用已校验的固件包批量升级")
+            .def("runPath", &FirmwareRollout::runPath, py::arg("targets"), py::arg("bin_path"),
+                 py::call_guard<py::gil_scoped_release>(), "批量升级固件");
 }
@@ -0,0 +1,32 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_CRC16_H
+#define UP_CORE_CRC16_H
+
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * CRC-16-CCITT（XMODEM）校验
+ *  多项式 0x1021 (x^16 + x^12 + x^5 + 1)，初值 0，高位先行，不取反
+ *
+ * 所有实现都直接作用于原始内存，可以通过 crc 参数分段累加计算。
+ */
+namespace crc16 {
+
+    /** @brief 逐位计算的参考实现 */
+    uint16_t xmodemBitwise(const uint8_t *data, size_t length, uint16_t crc = 0);
+
+    /** @brief 单表查表实现，每字节一次查表 */
+    uint16_t xmodemTable(const uint8_t *data, size_t length, uint16_t crc = 0);
+
+    /** @brief slicing-by-8 实现，每 8 字节一组、8 张表并行查表 */
+    uint16_t xmodemSlicing8(const uint8_t *data, size_t length, uint16_t crc = 0);
+
+    /** @brief 默认实现（当前为 slicing-by-8），固件帧等调用方统一使用此入口 */
+    uint16_t xmodem(const uint8_t *data, size_t length, uint16_t crc = 0);
+}
+
+#endif //UP_CORE_CRC16_H
@@ -0,0 +1,22 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_CRC32_H
+#define UP_CORE_CRC32_H
+
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * CRC-32（IEEE 802.3，与 zlib / Python binascii.crc32 一致）
+ *  多项式 0x04C11DB7（反射形式 0xEDB88320），初值 0xFFFFFFFF，结果取反
+ *
+ * 可以通过 crc 参数分段累加计算：crc32::compute(b, n, crc32::compute(a, m))
+ */
+namespace crc32 {
+
+    uint32_t compute(const uint8_t *data, size_t length, uint32_t crc = 0);
+}
+
+#endif //UP_CORE_CRC32_H
@@ -0,0 +1,131 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_FIRMWARE_IMAGE_H
+#define UP_CORE_FIRMWARE_IMAGE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * 固件镜像的只读视图
+ *
+ *  - fromFile：通过 mmap 映射固件文件，不把整个文件复制到堆上（Windows 退化为一次性读取）
+ *  - fromBuffer：直接引用调用方的内存（如 Python 的 bytes / bytearray / memoryview），
+ *    不复制数据，调用方需保证升级期间内存有效
+ */
+class FirmwareImage {
+public:
+    FirmwareImage() = default;
+
+    ~FirmwareImage();
+
+    FirmwareImage(FirmwareImage &&other) noexcept;
+
+    FirmwareImage &operator=(FirmwareImage &&other) noexcept;
+
+    FirmwareImage(const FirmwareImage &) = delete;
+
+    FirmwareImage &operator=(const FirmwareImage &) = delete;
+
+    /**
+     * @brief 映射固件文件
+     * @throws std::runtime_error 文件无法打开或映射失败时抛出
+     */
+    static FirmwareImage fromFile(const std::string &path);
+
+    /** @brief 引用一段已有内存，不复制 */
+    static FirmwareImage fromBuffer(const uint8_t *data, size_t size);
+
+    const uint8_t *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+private:
+    const uint8_t *data_{nullptr};
+    size_t size_{0};
+
+    // mmap 映射的起始地址和长度，为空表示未映射
+    void *mapping_{nullptr};
+    size_t mapping_size_{0};
+
+    // 不支持 mmap 的平台使用的存储
+    std::vector<uint8_t> owned_;
+
+    void reset();
+};
+
+/**
+ * 固件数据帧流
+ *
+ * 按需把第 N 块固件数据组装成升级帧，所有帧共用同一个缓冲区，
+ * 内存占用与镜像大小无关，第一帧也无需等待整个镜像分包完成。
+ *
+ * 帧格式：[0x01] [包序号] [包序号反码] [128 字节数据] [CRC 高字节] [CRC 低字节]
+ * XMODEM-1K：[0x02] [包序号] [包序号反码] [1024 字节数据] [CRC 高字节] [CRC 低字节]
+ */
+class FirmwareFrameStream {
+public:
+    static const size_t BLOCK_SIZE = 128;
+    static const size_t BLOCK_SIZE_1K = 1024;
+    static const size_t FRAME_SIZE = BLOCK_SIZE + 5;
+
+    /**
+     * @param block_size 每帧数据块大小，只能是 BLOCK_SIZE 或 BLOCK_SIZE_1K
+     * @throws std::invalid_argument 数据块大小不合法时抛出
+     */
+    FirmwareFrameStream(const uint8_t *data, size_t size, size_t block_size = BLOCK_SIZE);
+
+    explicit FirmwareFrameStream(const FirmwareImage &image, size_t block_size = BLOCK_SIZE);
+
+    /** @brief 切换数据块大小，帧序号随之重新划分 */
+    void setBlockSize(size_t block_size);
+
+    size_t blockSize() const { return block_size_; }
+
+    /** @brief 当前数据块大小下每帧的字节数 */
+    size_t frameSize() const { return block_size_ + 5; }
+
+    /** @brief 数据帧总数 */
+    size_t frameCount() const;
+
+    /** @brief 镜像总字节数 */
+    size_t imageSize() const { return size_; }
+
+    /**
+     * @brief 组装第 index 个数据帧（从 0 开始，对应包序号 index + 1）
+     * @return 帧缓冲区的引用，在下一次调用 frame() 之前有效
+     */
+    const std::vector<uint8_t> &frame(size_t index);
+
+    /**
+     * @brief 使用预先组装好的数据帧（如固件包加载时生成的帧）
+     *
+     * 当前数据块大小等于 block_size 时 frameData() 直接返回其中的帧，不再拷贝和计算 CRC
+     *
+     * @param frames 依次相连的数据帧，每帧 block_size + 5 字节，使用期间必须保持有效
+     */
+    void setPrecomputedFrames(const uint8_t *frames, size_t block_size);
+
+    /**
+     * @brief 第 index 个数据帧的首地址，帧长为 frameSize()
+     * @return 有预组装的帧时指向预组装的帧，否则同 frame()，在下一次调用 frame() 之前有效
+     */
+    const uint8_t *frameData(size_t index);
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t block_size_{BLOCK_SIZE};
+    std::vector<uint8_t> frame_;
+
+    const uint8_t *precomputed_{nullptr};
+    size_t precomputed_block_size_{0};
+};
+
+#endif //UP_CORE_FIRMWARE_IMAGE_H
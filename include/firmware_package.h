@@ -0,0 +1,132 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_FIRMWARE_PACKAGE_H
+#define UP_CORE_FIRMWARE_PACKAGE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "firmware_image.h"
+
+/**
+ * 固件包：固件镜像 + 型号、版本及完整性信息
+ *
+ * 格式（多字节字段均为小端）：
+ *
+ *  偏移  长度  字段
+ *  0     4     魔数 "UPFW"
+ *  4     2     格式版本（当前为 1）
+ *  6     2     包头长度（不含数据块 CRC 表），当前为 80
+ *  8     32    舵机型号，ASCII，不足补 0
+ *  40    16    固件版本，ASCII，不足补 0
+ *  56    4     镜像字节数
+ *  60    4     数据块大小（128 或 1024）
+ *  64    4     数据块个数
+ *  68    4     整个镜像的 CRC-32
+ *  72    4     保留，为 0
+ *  76    4     包头 CRC-32（覆盖偏移 0 ~ 75 及数据块 CRC 表）
+ *  80    2×N   每个数据块的 CRC16/XMODEM（只覆盖实际数据，与数据帧中的 CRC 相同）
+ *  ...         镜像数据
+ *
+ * 加载时一次性校验包头、每个数据块和整个镜像，并按包内的数据块大小预先组装好所有数据帧，
+ * 升级时直接把预组装的帧写入串口，不再逐帧拷贝和计算 CRC；
+ * 损坏的固件包在加载时即被拒绝，不会让舵机进入 Bootloader 后才发现。
+ */
+class FirmwarePackage {
+public:
+    static const size_t HEADER_SIZE = 80;
+    static const size_t MODEL_SIZE = 32;
+    static const size_t VERSION_SIZE = 16;
+    static const uint16_t FORMAT_VERSION = 1;
+
+    FirmwarePackage() = default;
+
+    FirmwarePackage(FirmwarePackage &&other) = default;
+
+    FirmwarePackage &operator=(FirmwarePackage &&other) = default;
+
+    FirmwarePackage(const FirmwarePackage &) = delete;
+
+    FirmwarePackage &operator=(const FirmwarePackage &) = delete;
+
+    /**
+     * @brief 把固件镜像打包
+     * @param block_size 预组装数据帧使用的数据块大小，只能是 128 或 1024
+     * @throws std::invalid_argument 数据块大小不合法或型号、版本过长时抛出
+     */
+    static std::vector<uint8_t> pack(const uint8_t *image, size_t size,
+                                     const std::string &model, const std::string &version,
+                                     size_t block_size = FirmwareFrameStream::BLOCK_SIZE);
+
+    /** @brief 数据是否以固件包魔数开头（不做校验） */
+    static bool isPackage(const uint8_t *data, size_t size);
+
+    /**
+     * @brief 映射并校验固件包文件
+     * @throws std::runtime_error 文件无法读取或校验失败时抛出
+     */
+    static FirmwarePackage fromFile(const std::string &path);
+
+    /**
+     * @brief 校验已映射的固件包，接管映射
+     * @throws std::runtime_error 校验失败时抛出
+     */
+    static FirmwarePackage fromImage(FirmwareImage &&image);
+
+    /**
+     * @brief 复制并校验内存中的固件包
+     * @throws std::runtime_error 校验失败时抛出
+     */
+    static FirmwarePackage fromBuffer(const uint8_t *data, size_t size);
+
+    const std::string &model() const { return model_; }
+
+    const std::string &version() const { return version_; }
+
+    /** @brief 固件镜像（不含包头） */
+    const uint8_t *image() const { return image_; }
+
+    size_t imageSize() const { return image_size_; }
+
+    size_t blockSize() const { return block_size_; }
+
+    size_t frameCount() const { return block_crcs_.size(); }
+
+    uint32_t imageCrc() const { return image_crc_; }
+
+    /** @brief 第 index 个数据块的 CRC16 */
+    uint16_t blockCrc(size_t index) const { return block_crcs_[index]; }
+
+    /** @brief 预组装的数据帧，共 frameCount() 帧，每帧 blockSize() + 5 字节，依次相连 */
+    const uint8_t *frames() const { return frames_.data(); }
+
+    /**
+     * @brief 创建使用预组装数据帧的帧流
+     *
+     * 帧流引用本对象的数据，升级期间本对象必须保持有效；
+     * 升级时切换到其他数据块大小（如 1K 回退到 128）会退回逐帧组装
+     */
+    FirmwareFrameStream frameStream() const;
+
+private:
+    // 文件映射或复制的固件包，image_ 指向其中的镜像部分
+    FirmwareImage file_;
+    std::vector<uint8_t> buffer_;
+
+    std::string model_;
+    std::string version_;
+    const uint8_t *image_{nullptr};
+    size_t image_size_{0};
+    size_t block_size_{FirmwareFrameStream::BLOCK_SIZE};
+    uint32_t image_crc_{0};
+    std::vector<uint16_t> block_crcs_;
+    std::vector<uint8_t> frames_;
+
+    // 校验 file_ 中的固件包并组装数据帧
+    void load();
+};
+
+#endif //UP_CORE_FIRMWARE_PACKAGE_H
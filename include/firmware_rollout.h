@@ -0,0 +1,120 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_FIRMWARE_ROLLOUT_H
+#define UP_CORE_FIRMWARE_ROLLOUT_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <stdint.h>
+#include "firmware_update.h"
+
+/**
+ * 升级目标：舵机所在的串口（总线）及舵机 ID
+ */
+struct RolloutTarget {
+    std::string port;
+    uint8_t servo_id;
+
+    RolloutTarget() : servo_id(0) {}
+
+    RolloutTarget(std::string port, uint8_t servo_id) : port(std::move(port)), servo_id(servo_id) {}
+};
+
+/**
+ * 单个目标的升级结果
+ */
+struct RolloutResult {
+    RolloutTarget target;
+    bool success{false};
+    double seconds{0};      // 该目标升级耗时（秒）
+    std::string error;      // 失败原因，成功时为空
+    UpgradeMetrics metrics; // 各阶段耗时及重发统计
+};
+
+/**
+ * 批量固件升级
+ *
+ *  - 不同串口（总线）之间由工作线程池并行升级
+ *  - 同一总线上的舵机按传入顺序依次升级，共用一个打开的串口
+ *  - 通过回调上报每个目标的进度和结果，回调之间互斥，调用方无需自行加锁
+ */
+class FirmwareRollout {
+public:
+    /**
+     * @param baud_rate         舵机正常通信的波特率
+     * @param max_workers       最大并行总线数，0 表示每条总线一个线程
+     */
+    explicit FirmwareRollout(int baud_rate, size_t max_workers = 0);
+
+    /** @brief 设置重试参数，含义同 FirmwareUpdate::upgrade_path */
+    void setRetry(int total_retry, int handshake_threshold, int frame_retry_count, int sign_retry_count);
+
+    /** @brief 设置传输参数，含义同 FirmwareUpdate::setTransferOptions */
+    void setTransferOptions(size_t block_size, uint32_t transfer_baud_rate = 0) {
+        this->block_size = block_size;
+        this->transfer_baud_rate = transfer_baud_rate;
+    }
+
+    // 进度回调：目标在列表中的下标，已发送帧数，总帧数
+    using ProgressCallback = std::function<void(size_t, size_t, size_t)>;
+
+    // 结果回调：目标在列表中的下标，升级结果
+    using ResultCallback = std::function<void(size_t, const RolloutResult &)>;
+
+    void setProgressCallback(ProgressCallback callback) {
+        progressCallback = std::move(callback);
+    }
+
+    void setResultCallback(ResultCallback callback) {
+        resultCallback = std::move(callback);
+    }
+
+    /**
+     * @brief 升级所有目标，全部完成后返回
+     * @param data  固件数据，升级期间必须保持有效
+     * @return 与 targets 顺序一致的升级结果
+     */
+    std::vector<RolloutResult> run(const std::vector<RolloutTarget> &targets, const uint8_t *data, size_t size);
+
+    /**
+     * @brief 使用已校验的固件包升级所有目标
+     *
+     * 所有工作线程共用包内预组装的数据帧，升级过程中不再逐帧组装和计算 CRC
+     */
+    std::vector<RolloutResult> run(const std::vector<RolloutTarget> &targets, const FirmwarePackage &package);
+
+    /** @brief 升级所有目标，固件从文件映射；固件包文件在升级前完成校验 */
+    std::vector<RolloutResult> runPath(const std::vector<RolloutTarget> &targets, const std::string &bin_path);
+
+private:
+    int baud_rate;
+    size_t max_workers;
+
+    int total_retry{10};
+    int handshake_threshold{5};
+    int frame_retry_count{5};
+    int sign_retry_count{5};
+
+    size_t block_size{FirmwareFrameStream::BLOCK_SIZE};
+    uint32_t transfer_baud_rate{0};
+
+    ProgressCallback progressCallback;
+    ResultCallback resultCallback;
+
+    // 保证回调不会被多个工作线程同时调用
+    std::mutex callback_mutex;
+
+    // 固件包不为空时发送包内的数据帧，否则发送 data
+    std::vector<RolloutResult> runAll(const std::vector<RolloutTarget> &targets, const uint8_t *data, size_t size,
+                                      const FirmwarePackage *package);
+
+    void runBus(const std::vector<size_t> &indices, const std::vector<RolloutTarget> &targets,
+                const uint8_t *data, size_t size, const FirmwarePackage *package,
+                std::vector<RolloutResult> &results);
+};
+
+#endif //UP_CORE_FIRMWARE_ROLLOUT_H
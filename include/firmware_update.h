@@ -8,8 +8,66 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
 #include "serial/serial.h"
-#include <unordered_map>
+#include "firmware_image.h"
+#include "firmware_package.h"
+#include <functional>
+#include <chrono>
+
+/**
+ * 升级阶段
+ */
+enum class UpgradePhase {
+    Idle,
+    Bootloader,     // 复位到 Bootloader
+    Handshake,      // 握手及传输参数协商
+    Transfer,       // 发送固件数据帧
+    Wave,           // 发送结束标志
+    Done,           // 升级成功
+    Failed          // 所有重试均失败
+};
+
+/**
+ * 升级过程的统计数据
+ *
+ * 各阶段耗时为所有重试轮次的累计值，正在进行的阶段包含到当前时刻为止的耗时
+ */
+struct UpgradeMetrics {
+    UpgradePhase phase{UpgradePhase::Idle};
+    int round{0};                       // 当前是第几轮（从 1 开始）
+
+    double bootloader_seconds{0};
+    double handshake_seconds{0};
+    double transfer_seconds{0};
+    double wave_seconds{0};
+    double elapsed_seconds{0};          // 升级开始至今的总耗时
+
+    size_t frames_total{0};             // 当前数据块大小下的数据帧总数
+    size_t frames_acked{0};             // 已被设备确认的数据帧数
+    size_t frames_sent{0};              // 实际发送的数据帧数（含重发）
+    size_t frames_retried{0};           // 需要重发的次数
+    size_t bytes_acked{0};              // 已被确认的固件字节数
+    double bytes_per_second{0};         // 传输阶段的有效速率
+
+    size_t block_size{0};
+    uint32_t baud_rate{0};              // 传输阶段的波特率
+
+    // 数据帧重发原因
+    size_t nak_count{0};
+    size_t timeout_count{0};
+    size_t write_error_count{0};
+    size_t cancel_count{0};
+
+    // 各阶段失败次数及续传次数
+    size_t bootloader_failures{0};
+    size_t handshake_failures{0};
+    size_t transfer_failures{0};
+    size_t wave_failures{0};
+    size_t resumes{0};
+};
 
 class FirmwareUpdate {
 public:
@@ -43,60 +101,232 @@ public:
                         int frame_retry_count = 5,
                         int sign_retry_count = 5);
 
+    /**
+     * 直接使用调用方提供的内存升级，不复制固件数据（供 Python 缓冲区协议使用）
+     *
+     * @param data              固件数据首地址，升级期间必须保持有效
+     * @param size              固件数据字节数
+     */
+    bool upgrade_buffer(const std::string &port_input,
+                        int baud_rate,
+                        const uint8_t *data,
+                        size_t size,
+                        uint8_t servo_id,
+                        int total_retry = 10,
+                        int handshake_threshold = 5,
+                        int frame_retry_count = 5,
+                        int sign_retry_count = 5);
+
+    /**
+     * 使用调用方已打开的串口升级，升级过程中不会关闭该串口，只在各阶段切换波特率，
+     * 便于同一总线上的多个舵机复用一个串口
+     *
+     * @param serial            已打开的串口
+     * @param baud_rate         舵机正常通信的波特率
+     */
+    bool upgrade_serial(const std::shared_ptr<serial::Serial> &serial,
+                        int baud_rate,
+                        const uint8_t *data,
+                        size_t size,
+                        uint8_t servo_id,
+                        int total_retry = 10,
+                        int handshake_threshold = 5,
+                        int frame_retry_count = 5,
+                        int sign_retry_count = 5);
+
+    /**
+     * 使用已校验的固件包升级，直接发送包内预组装的数据帧
+     *
+     * 固件包在加载时已经校验过，升级前不会再检查镜像；
+     * 调用方可以用 FirmwarePackage::model() 确认型号与目标舵机一致
+     *
+     * @param package           已加载的固件包，升级期间必须保持有效
+     */
+    bool upgrade_package(const std::string &port_input,
+                         int baud_rate,
+                         const FirmwarePackage &package,
+                         uint8_t servo_id,
+                         int total_retry = 10,
+                         int handshake_threshold = 5,
+                         int frame_retry_count = 5,
+                         int sign_retry_count = 5);
+
+    /** @brief 使用调用方已打开的串口及已校验的固件包升级 */
+    bool upgrade_serial(const std::shared_ptr<serial::Serial> &serial,
+                        int baud_rate,
+                        const FirmwarePackage &package,
+                        uint8_t servo_id,
+                        int total_retry = 10,
+                        int handshake_threshold = 5,
+                        int frame_retry_count = 5,
+                        int sign_retry_count = 5);
+
+    // 进度回调类型：已发送的数据帧数，数据帧总数
+    using ProgressCallback = std::function<void(size_t, size_t)>;
+
+    // 设置进度回调，每个数据帧发送成功后在升级线程中调用
+    void setProgressCallback(ProgressCallback callback) {
+        progressCallback = std::move(callback);
+    }
+
+    // 统计回调：阶段切换、每个数据帧被确认时在升级线程中调用，参数为当前统计数据的快照
+    using MetricsCallback = std::function<void(const UpgradeMetrics &)>;
+
+    void setMetricsCallback(MetricsCallback callback) {
+        metricsCallback = std::move(callback);
+    }
+
+    /** @brief 获取当前统计数据的快照，可在其他线程中调用 */
+    UpgradeMetrics getMetrics() const;
+
+    /**
+     * 设置断点续传
+     *
+     * @param enable            数据帧重试耗尽后，重新握手并从最后确认的数据帧继续发送；
+     *                          续传没有任何进展时（Bootloader 不支持续传）退回到从头升级
+     * @param retry_interval_ms 每轮重试之前的等待时间（毫秒）
+     */
+    void setResume(bool enable, int retry_interval_ms = 100) {
+        resume_enabled = enable;
+        this->retry_interval_ms = retry_interval_ms;
+    }
+
+    /**
+     * 设置 Bootloader 传输参数
+     *
+     * 握手成功后逐项协商：先请求切换波特率，再用 1K 数据帧发送第一帧；
+     * 设备不应答时自动回退到 128 字节 / 9600
+     *
+     * @param block_size            数据块大小：128 或 1024（XMODEM-1K）
+     * @param transfer_baud_rate    握手后切换到的波特率，0 表示保持 9600
+     */
+    void setTransferOptions(size_t block_size, uint32_t transfer_baud_rate = 0) {
+        preferred_block_size = block_size;
+        preferred_baud_rate = transfer_baud_rate;
+    }
+
+    /**
+     * 设置数据帧应答超时的余量
+     *
+     * 应答超时 = 数据帧及应答在当前波特率下的传输时间 + margin_ms，
+     * 余量用于设备校验数据帧和写入 Flash
+     */
+    void setAckTimeoutMargin(uint32_t margin_ms) {
+        ack_timeout_margin_ms = margin_ms;
+    }
+
+    // 最近一次升级中已被设备确认的连续数据帧数
+    size_t acknowledgedFrames() const {
+        return acked_frames;
+    }
+
 private:
     std::string port;
     int current_baud_rate;
 
+    ProgressCallback progressCallback;
+    MetricsCallback metricsCallback;
+
+    UpgradeMetrics metrics;
+    mutable std::mutex metrics_mutex;
+    std::chrono::steady_clock::time_point upgrade_start;
+    std::chrono::steady_clock::time_point phase_start;
+
     int handshake_count{5};
     int fire_ware_frame_retry{5};
     int wave_sign_retry{5};
 
+    bool resume_enabled{true};
+    int retry_interval_ms{100};
+    std::atomic<size_t> acked_frames{0};
+
     std::shared_ptr<serial::Serial> upgradeSerial;
 
-    std::atomic<int> read_count{0};
-    std::atomic<bool> stop_writing{false};
-    std::atomic<bool> stop_reading{false};
-    std::mutex mtx;
-    std::condition_variable cv;
-    bool write_finished = false;
+    // 握手时每次请求后等待应答的时间，以及整个握手的最长时间（毫秒）
+    const int handshake_interval_ms = 20;
+    const int handshake_window_ms = 1000;
 
-    const int write_iteration = 10;
-    const int read_iteration = 3;
     const uint8_t request_sing = 0x64;
     const uint8_t handshake_sign = 0x43;
     const uint8_t wave_sign = 0x04;
 
 
-    std::atomic<bool> stop_receive{false};
-    std::unordered_map<uint32_t, std::vector<uint8_t> > received_data_;
-    std::unordered_map<uint32_t, std::unique_ptr<std::condition_variable> > message_conditions_;
-    std::mutex mutex_;
-    uint32_t message_counter;
+    // Bootloader 默认波特率
+    static const uint32_t BOOTLOADER_BAUD_RATE = 9600;
 
-    // 生成唯一的消息 ID
-    uint32_t generateMessageId() {
-        return ++message_counter; // 简单的递增 ID 生成策略
-    }
+    // 切换波特率请求：[0x62] [波特率 4 字节，高位在前] [CRC 高字节] [CRC 低字节]
+    const uint8_t baud_switch_sign = 0x62;
 
-    std::vector<uint8_t> textureBinArray(const std::string &binPath);
+    // 1K 数据帧连续被拒绝多少次后回退到 128 字节
+    const int block_probe_attempts = 2;
 
-    std::vector<std::vector<uint8_t> > splitBinArray(std::vector<uint8_t> &fileBuffer, size_t dataSize);
+    size_t preferred_block_size{FirmwareFrameStream::BLOCK_SIZE};
+    uint32_t preferred_baud_rate{0};
 
-    bool bootloader(uint8_t id);
+    // 当前与 Bootloader 通信的波特率，重新进入 Bootloader 时恢复为 9600
+    uint32_t link_baud_rate{BOOTLOADER_BAUD_RATE};
 
-    bool firmware_upgrade();
+    // XMODEM 应答控制字节
+    static const uint8_t ACK = 0x06;
+    static const uint8_t NAK = 0x15;
+    static const uint8_t CAN = 0x18;
 
-    bool firmwareUpdate(std::vector<std::vector<uint8_t> > binArray);
+    // 单个数据帧的发送结果
+    enum class FrameResult {
+        Ack,        // 设备确认接收
+        Nak,        // 设备校验失败，要求重发
+        Cancel,     // 设备取消传输
+        Timeout,    // 超时未收到应答
+        WriteError  // 串口写入失败
+    };
 
-    bool sendFrame(const std::vector<uint8_t> &frame);
+    // 应答超时在帧传输时间之外预留的余量（毫秒），用于设备校验和写入 Flash
+    uint32_t ack_timeout_margin_ms{100};
 
-    bool wave();
+    // 设备是否取消了本次传输，取消后不再续传
+    bool transfer_cancelled{false};
+
+    // 根据当前串口参数计算发送 frame_size 字节数据帧后等待应答的超时时间（毫秒）
+    uint32_t frameAckTimeout(size_t frame_size) const;
+
+    // 打开升级使用的串口，失败时记录日志并返回空指针
+    std::shared_ptr<serial::Serial> openSerial(const std::string &port_input, int baud_rate);
+
+    // 保存升级参数，升级结束后恢复串口的正常通信波特率
+    bool upgradeFrames(const std::shared_ptr<serial::Serial> &serial, int baud_rate, FirmwareFrameStream &frames,
+                       uint8_t servo_id, int total_retry, int handshake_threshold, int frame_retry_count,
+                       int sign_retry_count);
+
+    bool upgrade(FirmwareFrameStream &frames, uint8_t servo_id, int total_retry);
+
+    // 进入新阶段并上报统计
+    void beginPhase(UpgradePhase phase);
 
-    static void buildFrame(const std::vector<uint8_t> &data, int packetNumber, std::vector<uint8_t> &frame);
+    // 把当前阶段的耗时累计到对应字段
+    void endPhase();
 
-    static uint16_t calculateCRC(const std::vector<uint8_t> &data);
+    // 记录当前数据块大小、帧数及波特率
+    void recordTransferShape(const FirmwareFrameStream &frames);
 
-    static void readFile(const std::string &fileName, std::vector<uint8_t> &buffer);
+    // 记录一次数据帧发送结果
+    void recordFrame(FrameResult result, size_t acked, size_t bytes);
+
+    // 在锁内累加失败 / 续传计数
+    void countFailure(size_t &counter);
+
+    void reportMetrics();
+
+    bool bootloader(uint8_t id);
+
+    bool firmware_upgrade();
+
+    bool negotiateBaudrate();
+
+    bool firmwareUpdate(FirmwareFrameStream &frames, size_t start_index = 0);
+
+    FrameResult sendFrame(const uint8_t *frame, size_t size);
+
+    bool wave();
 };
 
 
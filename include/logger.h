@@ -5,12 +5,19 @@
 #ifndef UP_CORE_LOGGER_H
 #define UP_CORE_LOGGER_H
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <mutex>
 #include <vector>
 #include "servo_protocol.h"
 
+#if defined(__GNUC__) || defined(__clang__)
+#define UP_LOG_UNLIKELY(condition) __builtin_expect(!!(condition), 0)
+#else
+#define UP_LOG_UNLIKELY(condition) (condition)
+#endif
+
 class Logger {
 public:
     enum LogLevel {
@@ -21,12 +28,46 @@ public:
         OFF // 关闭所有日志
     };
 
+    // 异步日志队列已满时的处理方式
+    enum OverflowPolicy {
+        DROP,  // 丢弃新日志并计数，调用方不等待
+        BLOCK  // 等待后台线程腾出空间，不丢日志
+    };
+
+    // 异步日志配置
+    struct AsyncOptions {
+        size_t capacity;            // 队列容量（条），向上取整为 2 的幂
+        OverflowPolicy overflow;
+        uint32_t flush_interval_ms; // 队列为空时后台线程的最长等待时间
+        std::string path;           // 非空时追加写入该文件，否则按级别写入 cout / clog / cerr
+
+        AsyncOptions() : capacity(4096), overflow(DROP), flush_interval_ms(10) {
+        }
+    };
+
     // 设置全局日志级别
     static void setLogLevel(LogLevel level);
 
     // 获取级别
     static LogLevel getLogLevel();
 
+    // 该级别的日志是否输出；内联的一次比较，供下面的宏和 lazy 在构造日志内容前判断
+    static bool isEnabled(LogLevel level) {
+        return level >= logLevel_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 级别输出时才调用 build() 生成日志内容
+     *
+     * Logger::lazy(Logger::DEBUG, [&] { return "接收到的数据 " + bytesToHex(buffer); });
+     */
+    template<typename Builder>
+    static void lazy(LogLevel level, Builder &&build) {
+        if (UP_LOG_UNLIKELY(isEnabled(level))) {
+            log(level, build());
+        }
+    }
+
     static void debug(const std::string &message);
 
     static void info(const std::string &message);
@@ -35,8 +76,28 @@ public:
 
     static void error(const std::string &message);
 
+    /**
+     * @brief 切换到异步日志：调用方只把日志放入无锁队列，由后台线程批量写出
+     *
+     * 已经是异步模式时先写完原队列中的日志再按新配置启动。进程退出时自动写完队列中的日志。
+     */
+    static void enableAsync(const AsyncOptions &options);
+
+    static void enableAsync();
+
+    /** @brief 写完队列中的日志，停止后台线程，恢复同步输出 */
+    static void disableAsync();
+
+    static bool isAsync();
+
+    /** @brief 等待调用前进入队列的日志全部写出，同步模式下立即返回 */
+    static void flush();
+
+    /** @brief 异步模式下因队列已满被丢弃的日志条数（累计） */
+    static uint64_t droppedCount();
+
 private:
-    static LogLevel logLevel_;
+    static std::atomic<LogLevel> logLevel_;
     static std::mutex mutex_;
 
     // 日志输出
@@ -47,4 +108,17 @@ private:
     static std::string getCurrentTime();
 };
 
+/**
+ * 延迟构造的日志：级别被过滤时只做一次判断，不计算日志内容表达式（字符串拼接、bytesToHex 等）。
+ * 热路径上拼接日志内容时使用这些宏代替 Logger::debug(...) 等函数。
+ */
+#define UP_LOG_DEBUG(...) \
+    do { if (UP_LOG_UNLIKELY(Logger::isEnabled(Logger::DEBUG))) Logger::debug(__VA_ARGS__); } while (0)
+#define UP_LOG_INFO(...) \
+    do { if (UP_LOG_UNLIKELY(Logger::isEnabled(Logger::INFO))) Logger::info(__VA_ARGS__); } while (0)
+#define UP_LOG_WARNING(...) \
+    do { if (UP_LOG_UNLIKELY(Logger::isEnabled(Logger::WARNING))) Logger::warning(__VA_ARGS__); } while (0)
+#define UP_LOG_ERROR(...) \
+    do { if (UP_LOG_UNLIKELY(Logger::isEnabled(Logger::ERROR))) Logger::error(__VA_ARGS__); } while (0)
+
 #endif //UP_CORE_LOGGER_H
@@ -43,6 +43,7 @@
 #include "serial/serial.h"
 
 #include <pthread.h>
+#include <sys/uio.h>
 
 namespace serial {
 
@@ -100,6 +101,9 @@ namespace serial {
         size_t
         write(const uint8_t *data, size_t length);
 
+        size_t
+        writeBatch(const std::vector<std::vector<uint8_t> > &frames);
+
         void
         flush();
 
@@ -142,6 +146,15 @@ namespace serial {
         string
         getPort() const;
 
+        int
+        getFd() const;
+
+        LowLatencyInfo
+        setLowLatency(bool enabled);
+
+        LowLatencyInfo
+        getLowLatency() const;
+
         void
         setTimeout(Timeout &timeout);
 
@@ -193,6 +206,15 @@ namespace serial {
     protected:
         void reconfigurePort();
 
+        // 在写超时内用 writev 写出 iov 中共 length 字节，iov 会被修改
+        size_t writeVectored(struct iovec *iov, size_t count, size_t length);
+
+        // 按 low_latency_ 配置驱动标志和 latency_timer，结果写入 low_latency_info_
+        void applyLowLatency();
+
+        // 清除 ASYNC_LOW_LATENCY 并恢复开启低延迟模式前的 latency_timer
+        void restoreLowLatency();
+
     private:
         string port_;               // Path to the file descriptor
         int fd_;                    // The current file descriptor
@@ -210,6 +232,11 @@ namespace serial {
         stopbits_t stopbits_;       // Stop Bits
         flowcontrol_t flowcontrol_; // Flow Control
 
+        bool low_latency_{false};           // 是否请求了低延迟模式
+        LowLatencyInfo low_latency_info_;   // 实际生效的低延迟配置
+        int saved_latency_timer_{-1};       // 修改前的 latency_timer，-1 表示未修改
+        int saved_async_low_latency_{-1};   // 修改前 ASYNC_LOW_LATENCY 是否置位（0 / 1），-1 表示未修改
+
         // Mutex used to lock the read functions
         pthread_mutex_t read_mutex;
         // Mutex used to lock the write functions
@@ -87,6 +87,9 @@ public:
   size_t
   write (const uint8_t *data, size_t length);
 
+  size_t
+  writeBatch (const std::vector<std::vector<uint8_t> > &frames);
+
   void
   flush ();
 
@@ -129,6 +132,12 @@ public:
   string
   getPort () const;
 
+  LowLatencyInfo
+  setLowLatency (bool enabled);
+
+  LowLatencyInfo
+  getLowLatency () const;
+
   void
   setTimeout (Timeout &timeout);
 
@@ -194,6 +203,8 @@ private:
   stopbits_t stopbits_;       // Stop Bits
   flowcontrol_t flowcontrol_; // Flow Control
 
+  LowLatencyInfo low_latency_info_; // 低延迟模式，Windows 上没有可配置的项
+
   // Mutex used to lock the read functions
   HANDLE read_mutex;
   // Mutex used to lock the write functions
@@ -0,0 +1,267 @@
+/*!
+ * \file serial/reactor.h
+ *
+ * \section DESCRIPTION
+ *
+ * 基于 epoll 的多串口事件循环（仅 Linux）。
+ *
+ * 一个线程同时服务任意多个 serial::Serial：
+ *  - 端口可读时一次读出内核缓冲区中的全部数据，通过读回调交给上层
+ *  - 写入先进入每个端口的写队列，端口可写时依次发出，不阻塞调用方
+ *  - 一次性 / 周期定时器，超时时间由 epoll_wait 的等待时间驱动，不需要额外线程
+ *  - 任意文件描述符（如 GPIO 边沿事件）也可以加入同一个循环
+ *
+ * 所有回调都在事件循环线程中调用，回调中可以再调用 Reactor 的任何方法。
+ */
+
+#ifndef SERIAL_REACTOR_H
+#define SERIAL_REACTOR_H
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "serial/serial.h"
+
+namespace serial {
+
+    class Reactor {
+    public:
+        // 读回调：本次读到的数据，指针只在回调期间有效；读出时间见 readTimestamp()
+        using ReadCallback = std::function<void(const uint8_t *, size_t)>;
+
+        // 错误回调：errno，端口已被自动移出事件循环
+        using ErrorCallback = std::function<void(int)>;
+
+        // 文件描述符事件回调：epoll 事件位（EPOLLIN / EPOLLPRI / EPOLLERR ...）
+        using EventCallback = std::function<void(uint32_t)>;
+
+        using TimerCallback = std::function<void()>;
+
+        using TimerId = uint64_t;
+
+        Reactor();
+
+        /*! 停止事件循环并关闭 epoll 描述符，不会关闭已注册的串口 */
+        ~Reactor();
+
+        Reactor(const Reactor &) = delete;
+
+        Reactor &operator=(const Reactor &) = delete;
+
+        /*!
+        * 在后台线程中运行事件循环。
+        */
+        void
+        start();
+
+        /*!
+        * 在当前线程中运行事件循环，直到调用 stop()。
+        */
+        void
+        run();
+
+        /*!
+        * 停止事件循环，由 start() 启动时等待后台线程退出。
+        * 可以在回调中调用。
+        */
+        void
+        stop();
+
+        /*! 事件循环是否正在运行 */
+        bool
+        running() const;
+
+        /*! 当前线程是否为事件循环线程 */
+        bool
+        inLoopThread() const;
+
+        /*!
+        * 本次读回调中的数据从内核读出的时间（serial::monotonicNs），只在读回调中有意义。
+        */
+        uint64_t
+        readTimestamp() const;
+
+        /*!
+        * 把串口加入事件循环。
+        *
+        * 加入后端口的读取由事件循环负责，调用方不应再调用该端口的 read / waitReadable，
+        * 写入应通过 send()，以保证与写队列中的数据不交错。
+        *
+        * \param serial 已打开的串口
+        * \param on_read 读回调
+        * \param on_error 读写出错或端口挂断时调用，可为空
+        *
+        * \throw serial::PortNotOpenedException 端口未打开
+        * \throw serial::IOException epoll_ctl 失败
+        */
+        void
+        add(const std::shared_ptr<Serial> &serial, ReadCallback on_read, ErrorCallback on_error = nullptr);
+
+        /*!
+        * 把串口移出事件循环，未发出的数据被丢弃。
+        *
+        * 在其他线程中调用时等待事件循环完成移除，返回后不会再有该端口的回调。
+        */
+        void
+        remove(const std::shared_ptr<Serial> &serial);
+
+        /*!
+        * 把数据追加到端口的写队列，端口可写时由事件循环发出。
+        *
+        * \return 端口未加入事件循环时返回 false
+        */
+        bool
+        send(const std::shared_ptr<Serial> &serial, const uint8_t *data, size_t size);
+
+        bool
+        send(const std::shared_ptr<Serial> &serial, std::vector<uint8_t> data);
+
+        /*! 端口写队列中尚未发出的字节数 */
+        size_t
+        pending(const std::shared_ptr<Serial> &serial);
+
+        /*!
+        * 监听任意文件描述符，如 GPIO 边沿事件。
+        *
+        * \param events epoll 事件位，如 EPOLLIN、EPOLLPRI
+        *
+        * \throw serial::IOException epoll_ctl 失败
+        */
+        void
+        addFd(int fd, uint32_t events, EventCallback on_event);
+
+        void
+        removeFd(int fd);
+
+        /*!
+        * 添加定时器。
+        *
+        * \param delay_ms 首次触发的延迟（毫秒）
+        * \param interval_ms 之后的触发周期，0 表示只触发一次
+        *
+        * \return 定时器 ID，用于 cancelTimer
+        */
+        TimerId
+        addTimer(uint32_t delay_ms, TimerCallback callback, uint32_t interval_ms = 0);
+
+        void
+        cancelTimer(TimerId id);
+
+        /*!
+        * 在事件循环线程中执行 task。
+        * 在事件循环线程中或事件循环未运行时立即执行。
+        */
+        void
+        post(std::function<void()> task);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Handler {
+            int fd{-1};
+            std::shared_ptr<Serial> serial;
+            ReadCallback on_read;
+            ErrorCallback on_error;
+            EventCallback on_event;
+            uint32_t events{0};
+
+            // 写队列及队首已发出的字节数
+            std::deque<std::vector<uint8_t> > out;
+            size_t out_offset{0};
+            size_t out_bytes{0};
+
+            bool removed{false};
+        };
+
+        struct Timer {
+            Clock::time_point deadline;
+            TimerId id;
+
+            bool operator>(const Timer &other) const { return deadline > other.deadline; }
+        };
+
+        struct TimerEntry {
+            TimerCallback callback;
+            std::chrono::milliseconds interval;
+        };
+
+        int epoll_fd_{-1};
+        int wake_fd_{-1};
+
+        std::thread thread_;
+        std::atomic<bool> quit_{false};
+
+        // 保护 tasks_、running_、loop_thread_ 和 registered_
+        mutable std::mutex mutex_;
+        std::vector<std::function<void()> > tasks_;
+        bool running_{false};
+        std::thread::id loop_thread_;
+
+        // 已加入事件循环的串口，send() 在调用方线程中据此判断端口是否有效
+        std::unordered_set<const Serial *> registered_;
+
+        // 以下成员只在事件循环线程中（或事件循环未运行时）访问
+        std::unordered_map<int, std::shared_ptr<Handler> > handlers_;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > timer_queue_;
+        std::unordered_map<TimerId, TimerEntry> timers_;
+        std::atomic<TimerId> next_timer_id_{1};
+
+        // 读缓冲区，所有端口共用
+        std::vector<uint8_t> read_buffer_;
+        uint64_t read_timestamp_{0};
+
+        void
+        wakeup();
+
+        // 在事件循环线程中执行 task 并等待完成
+        void
+        runAndWait(std::function<void()> task);
+
+        void
+        runPendingTasks();
+
+        // 距离最近的定时器触发还有多少毫秒，没有定时器时返回 -1
+        int
+        nextTimeout() const;
+
+        void
+        runTimers();
+
+        std::shared_ptr<Handler>
+        findSerial(const Serial *serial) const;
+
+        void
+        handleEvent(const std::shared_ptr<Handler> &handler, uint32_t events);
+
+        void
+        handleRead(const std::shared_ptr<Handler> &handler);
+
+        void
+        flushWrites(const std::shared_ptr<Handler> &handler);
+
+        void
+        updateEvents(const std::shared_ptr<Handler> &handler, uint32_t events);
+
+        void
+        fail(const std::shared_ptr<Handler> &handler, int error);
+
+        void
+        removeHandler(const std::shared_ptr<Handler> &handler);
+    };
+
+} // namespace serial
+
+#endif // __linux__
+
+#endif // SERIAL_REACTOR_H
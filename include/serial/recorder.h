@@ -0,0 +1,158 @@
+/*!
+ * \file serial/recorder.h
+ *
+ * \section DESCRIPTION
+ *
+ * 串口流量录制。
+ *
+ * Recorder 把串口收发的每一块数据连同方向、通道和单调时间戳追加写入二进制文件：
+ *  - 调用方只把记录复制到前台缓冲区（一次加锁和 memcpy），不做任何 I/O
+ *  - 后台线程在前台缓冲区达到阈值或每隔 flush_interval_ms 时交换前后台缓冲区并写入文件
+ *
+ * 文件格式（小端）：
+ *  - 文件头 16 字节：魔数 "UPRC"、格式版本 u16、保留 u16、开始录制时的 monotonicNs u64
+ *  - 每条记录 12 字节头 + 数据：相对开始时间的纳秒数 u64、数据长度 u16、方向 u8、通道 u8
+ *
+ * Recording 读取录制文件，供回放（\see serial::Replayer）和离线分析使用。
+ */
+
+#ifndef SERIAL_RECORDER_H
+#define SERIAL_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "serial/v8stdint.h"
+
+namespace serial {
+
+    class Recorder {
+    public:
+        enum Direction : uint8_t {
+            RX = 0, // 从串口读出
+            TX = 1  // 写入串口
+        };
+
+        static const size_t FILE_HEADER_SIZE = 16;
+        static const size_t RECORD_HEADER_SIZE = 12;
+        static const uint16_t FORMAT_VERSION = 1;
+
+        /*!
+        * 创建录制文件并启动后台写入线程，已存在的文件被覆盖。
+        *
+        * \param path 录制文件路径
+        * \param buffer_size 前台缓冲区达到该大小时唤醒后台线程写入
+        * \param flush_interval_ms 后台线程至少每隔该时间写入一次
+        *
+        * \throw serial::IOException 无法创建文件
+        */
+        explicit Recorder(const std::string &path, size_t buffer_size = 64 * 1024,
+                          uint32_t flush_interval_ms = 100);
+
+        /*! 写入剩余数据并关闭文件 */
+        ~Recorder();
+
+        Recorder(const Recorder &) = delete;
+
+        Recorder &operator=(const Recorder &) = delete;
+
+        /*!
+        * 追加一条记录，超过 65535 字节的数据拆成多条。
+        *
+        * \param timestamp_ns 数据收发的时间（monotonicNs）
+        * \param channel 通道号，多个串口录制到同一个文件时用于区分
+        */
+        void
+        record(Direction direction, const uint8_t *data, size_t size, uint64_t timestamp_ns, uint8_t channel = 0);
+
+        /*! 等待已追加的记录全部写入文件 */
+        void
+        flush();
+
+        /*! 停止后台线程并关闭文件，之后的 record 被忽略 */
+        void
+        close();
+
+        /*! 开始录制时的 monotonicNs */
+        uint64_t
+        startTime() const { return start_ns_; }
+
+        /*! 已追加的记录数 */
+        uint64_t
+        records() const { return records_; }
+
+        /*! 已追加的数据字节数（不含记录头） */
+        uint64_t
+        bytes() const { return bytes_; }
+
+    private:
+        void
+        run();
+
+        std::FILE *file_{nullptr};
+        uint64_t start_ns_{0};
+        size_t buffer_size_;
+        uint32_t flush_interval_ms_;
+
+        // 保护 front_、appended_、written_、closed_、flush_requested_，后台线程交换 front_ / back_
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable flushed_;
+        std::vector<uint8_t> front_;
+        std::vector<uint8_t> back_;
+        uint64_t appended_{0};  // 已追加到前台缓冲区的总字节数
+        uint64_t written_{0};   // 已写入文件的总字节数
+        bool closed_{false};
+        bool flush_requested_{false}; // flush() 等待写入，后台线程不等满缓冲区或间隔
+
+        std::atomic<uint64_t> records_{0};
+        std::atomic<uint64_t> bytes_{0};
+
+        std::thread thread_;
+    };
+
+    /*!
+    * 录制文件的内容
+    */
+    class Recording {
+    public:
+        struct Record {
+            uint64_t time_ns;   // 相对开始录制的纳秒数
+            Recorder::Direction direction;
+            uint8_t channel;
+            std::vector<uint8_t> data;
+        };
+
+        /*!
+        * 读取录制文件。文件末尾不完整的记录（录制进程异常退出）被忽略。
+        *
+        * \throw serial::IOException 无法打开文件
+        * \throw std::runtime_error 不是录制文件
+        */
+        static Recording
+        fromFile(const std::string &path);
+
+        /*! 开始录制时的 monotonicNs */
+        uint64_t
+        startTime() const { return start_ns_; }
+
+        const std::vector<Record> &
+        records() const { return records_; }
+
+        /*! 最后一条记录的相对时间（纳秒） */
+        uint64_t
+        duration() const { return records_.empty() ? 0 : records_.back().time_ns; }
+
+    private:
+        uint64_t start_ns_{0};
+        std::vector<Record> records_;
+    };
+
+} // namespace serial
+
+#endif // SERIAL_RECORDER_H
@@ -0,0 +1,147 @@
+/*!
+ * \file serial/replay.h
+ *
+ * \section DESCRIPTION
+ *
+ * 回放录制文件（\see serial::Recorder）。
+ *
+ * Replayer 按录制时的时间间隔（或按倍速、或不等待）把记录依次交给回调，
+ * 可以直接喂给 Servo::inject，在没有硬件的情况下重复运行解析和回调路径，用于确定性的性能测试。
+ *
+ * ReplayPort（仅 Linux）把记录写入伪终端，对端是普通的串口设备，
+ * 因此 Servo::init() 的接收线程、Reactor 等完整的读取路径都可以被回放驱动。
+ */
+
+#ifndef SERIAL_REPLAY_H
+#define SERIAL_REPLAY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "serial/recorder.h"
+
+namespace serial {
+
+    class Replayer {
+    public:
+        // 回放一条记录；now_ns 为该记录按回放时序应到达的时间（monotonicNs）
+        typedef std::function<void(const Recording::Record &record, uint64_t now_ns)> Sink;
+
+        explicit Replayer(Recording recording);
+
+        /*!
+        * 设置回放速度：1 为录制时的时序，大于 1 为加速，0 为不等待、尽快回放。
+        *
+        * \throw std::invalid_argument speed 为负数
+        */
+        void
+        setSpeed(double speed);
+
+        double
+        getSpeed() const { return speed_; }
+
+        /*! 只回放指定通道的记录，-1 为全部通道（默认） */
+        void
+        setChannel(int channel) { channel_ = channel; }
+
+        /*! 选择回放的方向，默认只回放 RX（串口读出的数据） */
+        void
+        setDirections(bool rx, bool tx) {
+            rx_ = rx;
+            tx_ = tx;
+        }
+
+        /*!
+        * 在当前线程中依次回放记录，返回时全部记录已回放或已调用 stop()。
+        *
+        * \return 回放的记录数
+        */
+        size_t
+        run(const Sink &sink);
+
+        /*!
+        * 让正在进行的 run() 在当前记录回放后返回，记录之间的等待立即结束；
+        * 在 run() 开始之前调用时，下一次 run() 立即返回。可以在其他线程或回调中调用。
+        */
+        void
+        stop();
+
+        /*! 是否已请求停止，回调中耗时较长的操作（如写满的伪终端）据此提前返回 */
+        bool
+        stopped() const { return stopped_; }
+
+        const Recording &
+        recording() const { return recording_; }
+
+    private:
+        Recording recording_;
+        double speed_{1.0};
+        int channel_{-1};
+        bool rx_{true};
+        bool tx_{false};
+        std::atomic<bool> stopped_{false};
+        // 记录之间的等待可以被 stop() 打断
+        std::mutex mutex_;
+        std::condition_variable wake_;
+    };
+
+#if defined(__linux__)
+
+    /*!
+    * 伪终端回放端口：后台线程把记录写入伪终端主端，从 port() 打开的串口读出。
+    *
+    * 写入该串口的数据被读出丢弃，避免内核缓冲区写满后阻塞写入方。
+    */
+    class ReplayPort {
+    public:
+        /*! \throw serial::IOException 无法创建伪终端 */
+        ReplayPort();
+
+        /*! 停止回放并关闭伪终端 */
+        ~ReplayPort();
+
+        ReplayPort(const ReplayPort &) = delete;
+
+        ReplayPort &operator=(const ReplayPort &) = delete;
+
+        /*! 伪终端从端的设备路径，用于构造 serial::Serial */
+        const std::string &
+        port() const { return port_; }
+
+        /*! 在后台线程中开始回放，前一次回放尚未结束时先停止 */
+        void
+        start(const std::shared_ptr<Replayer> &replayer);
+
+        /*! 等待回放结束 */
+        void
+        wait();
+
+        /*! 停止回放 */
+        void
+        stop();
+
+        /*! 回放是否已结束 */
+        bool
+        finished() const { return finished_; }
+
+    private:
+        void
+        writeAll(const uint8_t *data, size_t size);
+
+        int master_fd_{-1};
+        std::string port_;
+        std::shared_ptr<Replayer> replayer_;
+        std::thread thread_;
+        std::atomic<bool> finished_{true};
+    };
+
+#endif
+
+} // namespace serial
+
+#endif // SERIAL_REPLAY_H
@@ -6,7 +6,12 @@
 #ifndef SERIAL_H
 #define SERIAL_H
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <limits>
+#include <memory>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -20,6 +25,20 @@ __LINE__, (message) )
 
 namespace serial {
 
+    class Recorder;
+
+    /*!
+    * 单调时钟的当前时间（纳秒）。
+    *
+    * 与 std::chrono::steady_clock 同源，Linux 上即 CLOCK_MONOTONIC，
+    * 与 Python 的 time.monotonic_ns() 可以直接比较。收发时间戳都使用该时钟。
+    */
+    inline uint64_t
+    monotonicNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
     /*!
     * 枚举定义了串口可能的字节大小。
     */
@@ -109,6 +128,24 @@ namespace serial {
                   write_timeout_multiplier(write_timeout_multiplier_) {}
     };
 
+    /*!
+    * 低延迟模式实际生效的配置，设备或驱动不支持的项保持默认值。
+    *
+    * \see Serial::setLowLatency
+    */
+    struct LowLatencyInfo {
+        /*! 是否请求了低延迟模式 */
+        bool enabled{false};
+        /*! 驱动是否接受了 ASYNC_LOW_LATENCY 标志（TIOCSSERIAL） */
+        bool async_low_latency{false};
+        /*! USB 串口芯片当前的 latency_timer（毫秒），没有该 sysfs 节点时为 -1 */
+        int latency_timer_ms{-1};
+        /*! read 读到数据后立即返回已到达的字节，不再按字节时间等待剩余数据 */
+        bool immediate_read{false};
+        /*! 每一项的处理结果，以 "; " 分隔，如 "latency_timer 16 -> 1 ms" */
+        std::string details;
+    };
+
     /*!
     * 提供便携式串口接口的类。
     */
@@ -200,6 +237,38 @@ namespace serial {
         void
         waitByteTimes(size_t count);
 
+        /*!
+        * 最近一次读取返回的最后一个字节从内核读出的时间（monotonicNs），尚未读到数据时为 0。
+        *
+        * 从读缓冲区取出的数据使用其所在数据块读出时的时间，而不是取出时的时间。
+        */
+        uint64_t
+        getReadTimestamp() const;
+
+        /*!
+        * 最近一次写入交给驱动的时间（monotonicNs），尚未写入时为 0。
+        *
+        * 写入后调用 flush() 等待数据发送完毕时，更新为发送完成的时间。
+        */
+        uint64_t
+        getWriteTimestamp() const;
+
+        /*!
+        * 录制该端口收发的全部数据（\see serial::Recorder），传入空指针停止录制。
+        *
+        * 读写路径只把数据复制到录制器的缓冲区，文件写入在录制器的后台线程中进行。
+        * 多个端口可以录制到同一个 Recorder，用 channel 区分。
+        */
+        void
+        setRecorder(const std::shared_ptr<Recorder> &recorder, uint8_t channel = 0);
+
+        std::shared_ptr<Recorder>
+        getRecorder() const;
+
+        /*! setRecorder 设置的通道号 */
+        uint8_t
+        getRecorderChannel() const;
+
         /*!
         * 从串口读取指定数量的字节到给定的缓冲区中。
         *
@@ -313,6 +382,46 @@ namespace serial {
         std::vector<std::string>
         readlines(size_t size = 65536, std::string eol = "\n");
 
+        /*!
+        * 读取直到分隔符（包含分隔符）、读满 size 字节或超时。
+        *
+        * 每次从内核取走已到达的全部数据放入读缓冲区，用 memchr 查找分隔符，
+        * 分隔符之后多读的数据留给下一次读取。超时时间按 read(1) 计算，即两次数据到达之间的最长等待。
+        *
+        * \param buffer 用于追加数据的 std::string 引用。
+        * \param delimiter 分隔符，可以是多个字节。
+        * \param size 最多读取的字节数，默认为 65536 (2^16)。
+        *
+        * \return 表示读取字节数的 size_t，超时返回已读到的部分。
+        *
+        * \throw serial::PortNotOpenedException
+        * \throw serial::SerialException
+        */
+        size_t
+        readUntil(std::string &buffer, const std::string &delimiter, size_t size = 65536);
+
+        std::string
+        readUntil(const std::string &delimiter, size_t size = 65536);
+
+        /*!
+        * 读取一条完整的消息，消息边界由 complete 判断。
+        *
+        * complete 接收读缓冲区中尚未取走的数据，返回其中第一条完整消息的长度，不完整时返回 0。
+        * 每次有新数据到达时都会用全部未取走的数据重新调用。
+        *
+        * \param buffer 用于追加消息的 std::vector 引用。
+        * \param complete 消息边界判断函数。
+        * \param size 最多读取的字节数，默认为 65536 (2^16)。
+        *
+        * \return 表示读取字节数的 size_t，超时返回已读到的部分。
+        *
+        * \throw serial::PortNotOpenedException
+        * \throw serial::SerialException
+        */
+        size_t
+        readUntil(std::vector<uint8_t> &buffer, const std::function<size_t(const uint8_t *, size_t)> &complete,
+                  size_t size = 65536);
+
         /*!
         * 将字符串写入串口。
         *
@@ -357,6 +466,23 @@ namespace serial {
         size_t
         write(const std::string &data);
 
+        /*!
+        * 批量写入多个数据帧。
+        *
+        * 只获取一次写锁，各帧按顺序连续发出，中间不会插入其他线程的写入；
+        * Unix 上使用 writev，内核缓冲区足够时一次系统调用发出全部数据。
+        *
+        * \param frames 要依次写入的数据帧。
+        *
+        * \return 一个 size_t，表示实际写入串口的总字节数。
+        *
+        * \throw serial::PortNotOpenedException
+        * \throw serial::SerialException
+        * \throw serial::IOException
+        */
+        size_t
+        writeBatch(const std::vector<std::vector<uint8_t> > &frames);
+
         /*!
         * 设置串口标识符。
         *
@@ -378,6 +504,42 @@ namespace serial {
         std::string
         getPort() const;
 
+        /*!
+        * 开启或关闭低延迟模式，端口未打开时在打开后生效。
+        *
+        * USB 串口（FTDI / CH34x）的延迟主要来自驱动的 latency timer 和缓冲，而不是线路本身。
+        * 开启后依次尝试：
+        *  * 设置 ASYNC_LOW_LATENCY（TIOCSSERIAL），驱动收到数据后立即推送给 tty 层
+        *  * 把 /sys/class/tty/<tty>/device/latency_timer 设为 1 ms（FTDI 默认 16 ms，需要写权限）
+        *  * read 不再在多字节读取前按字节时间预先等待，数据到达即取走
+        *
+        * 端口以非阻塞方式打开并由 select 等待数据，VMIN / VTIME 保持 0 / 0，
+        * 不会引入内核侧的额外等待。
+        *
+        * 不支持的项被跳过，不会抛出异常；关闭低延迟模式或关闭端口时恢复原来的 latency_timer。
+        *
+        * \return 实际生效的配置
+        */
+        LowLatencyInfo
+        setLowLatency(bool enabled);
+
+        /*! 最近一次 setLowLatency 或打开端口时实际生效的配置 */
+        LowLatencyInfo
+        getLowLatency() const;
+
+#if !defined(_WIN32)
+
+        /*!
+        * 获取串口的文件描述符，端口未打开时返回 -1。
+        *
+        * 供 epoll 等事件循环监听端口的可读 / 可写事件（\see serial::Reactor），
+        * 不要直接关闭该描述符。直接从描述符读取时不会经过 Serial 的读缓冲区。
+        */
+        int
+        getFd() const;
+
+#endif
+
         /*!
         * 设置读写操作的超时，使用 Timeout 结构体。
         *
@@ -635,6 +797,41 @@ namespace serial {
         size_t
         read_(uint8_t *buffer, size_t size);
 
+        // 从串口补充读缓冲区：取走内核中已到达的全部数据，没有数据时按 read(1) 的超时等待
+        size_t
+        fillReadBuffer_();
+
+        // 取出读缓冲区开头的 size 字节
+        void
+        consumeReadBuffer_(size_t size);
+
+        // 返回读缓冲区中第一条完整消息的长度，必要时补充数据；超时返回已缓冲的字节数
+        size_t
+        frame_(size_t size, const std::function<size_t(const uint8_t *, size_t)> &complete);
+
+        // 用户态读缓冲区，[read_pos_, size) 为尚未取走的数据，由读锁保护
+        std::vector<uint8_t> read_buffer_;
+        size_t read_pos_;
+
+        // 未取走的字节数，available() / waitReadable() 不加锁读取
+        std::atomic<size_t> buffered_;
+
+        // 读缓冲区中每个数据块的结束位置（按累计字节数）及读出时间
+        std::deque<std::pair<uint64_t, uint64_t> > read_chunks_;
+        uint64_t read_appended_;
+        uint64_t read_consumed_;
+
+        std::atomic<uint64_t> read_timestamp_;
+        std::atomic<uint64_t> write_timestamp_;
+
+        // 通过 std::atomic_load / atomic_store 访问，读写路径不加额外的锁
+        std::shared_ptr<Recorder> recorder_;
+        std::atomic<uint8_t> recorder_channel_;
+
+        // 把一块收 / 发的数据交给录制器
+        void
+        record_(bool tx, const uint8_t *data, size_t size, uint64_t timestamp_ns);
+
         // Write common function
         size_t
         write_(const uint8_t *data, size_t length);
@@ -10,6 +10,7 @@
 #ifdef __linux__
 
 #include "unix/gpio.h"
+#include "serial/reactor.h"
 
 #endif
 
@@ -22,6 +23,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
 /**
@@ -52,6 +54,21 @@
  *       如果 ERROR = 0，说明舵机状态正常。
  */
 
+/**
+ * @brief 数据帧的收发时间（serial::monotonicNs，纳秒），0 表示未知
+ */
+struct FrameTimestamp {
+    uint64_t rx_ns{0};  // 帧最后一个字节从串口读出的时间
+    uint64_t tx_ns{0};  // 收到该帧前最近一次指令写出的时间
+
+    /** @brief 从指令写出到收到应答的时间（微秒），任一时间未知时返回 -1 */
+    double responseUs() const {
+        if (rx_ns == 0 || tx_ns == 0 || rx_ns < tx_ns)
+            return -1;
+        return static_cast<double>(rx_ns - tx_ns) / 1000.0;
+    }
+};
+
 class Servo {
 public:
 #ifdef __linux__
@@ -71,14 +88,49 @@ public:
     /** @brief 初始化 */
     void init();
 
+#ifdef __linux__
+
+    /**
+     * @brief 初始化，由事件循环接收数据，不再为每个串口单独创建监听线程
+     *
+     * 多个 Servo 可以共用一个 Reactor，一个线程同时服务所有串口
+     */
+    void init(const std::shared_ptr<serial::Reactor> &reactor);
+
+#endif
+
     /** @brief 关闭 */
     void close();
 
     /** @brief 发送指令 */
     bool sendCommand(const std::vector<uint8_t> &frame);
 
+    /** @brief 发送指令，frame 可以指向调用方的任意缓冲区（如 Python bytes），不复制 */
+    bool sendCommand(const uint8_t *frame, size_t size);
+
+    /**
+     * @brief 批量发送指令，如多个舵机的 REG_WRITE 之后紧跟 ACTION
+     *
+     * 所有帧在一次总线使能窗口内由一次 writev 连续发出，帧之间没有方向切换和额外的系统调用
+     */
+    bool sendCommands(const std::vector<std::vector<uint8_t> > &frames);
+
     bool sendWaitCommand(const std::vector<uint8_t> &frame, std::vector<uint8_t> &response_data);
 
+    /** @brief 发送指令并等待应答，同时返回应答的收发时间 */
+    bool sendWaitCommand(const std::vector<uint8_t> &frame, std::vector<uint8_t> &response_data,
+                         FrameTimestamp &timestamp);
+
+    /**
+     * @brief 注入一块接收数据，与从串口读出的数据走同一条解析路径
+     *
+     * 供回放录制文件（\see serial::Replayer）和离线测试使用，不应与接收线程或事件循环同时使用
+     *
+     * @param rx_ns 数据读出的时间，为 0 时使用当前时间
+     * @return 是否解析出了数据包
+     */
+    bool inject(const uint8_t *data, size_t size, uint64_t rx_ns = 0);
+
     /** @brief 解析串口数据 */
     bool performSerialData(const std::vector<uint8_t> &packet);
 
@@ -90,6 +142,13 @@ public:
         dataCallback = std::move(callback);
     }
 
+    // 带收发时间的数据接收回调
+    using TimedDataCallback = std::function<void(const std::vector<uint8_t> &, const FrameTimestamp &)>;
+
+    void setTimedDataCallback(TimedDataCallback callback) {
+        timedDataCallback = std::move(callback);
+    }
+
 private:
     std::shared_ptr<serial::Serial> serial;
 #ifdef __linux__
@@ -102,13 +161,27 @@ private:
 
     // 接收数据的线程
     std::thread receive_thread;
+
+#ifdef __linux__
+    // 使用事件循环接收数据时不创建接收线程
+    std::shared_ptr<serial::Reactor> reactor;
+#endif
+
+    // 尚未解析的接收数据
+    std::vector<uint8_t> receive_buffer;
+
     // 控制接收线程是否运行的标志
     std::atomic<bool> running{false};
 
     DataCallback dataCallback;
+    TimedDataCallback timedDataCallback;
+
+    // 最近一次指令写出的时间
+    std::atomic<uint64_t> last_tx_ns{0};
 
     // 用于存放接收到的数据，按消息 ID 存储
     std::unordered_map<uint32_t, std::vector<uint8_t> > received_data_;
+    std::unordered_map<uint32_t, FrameTimestamp> received_times_;
     // 存储每个消息 ID 对应的条件变量
     std::unordered_map<uint32_t, std::unique_ptr<std::condition_variable> > message_conditions_;
     // 用于保护接收到的数据和发送过程的互斥锁
@@ -126,14 +199,23 @@ private:
 
     void processSerialData();
 
+    // 追加收到的数据并解析数据包，返回是否解析出了数据包
+    bool handleReceivedData(const uint8_t *data, size_t size, uint64_t rx_ns);
+
+    // 交付一个完整的数据包：唤醒等待应答的 sendWaitCommand 并调用数据回调
+    void dispatchPacket(const std::vector<uint8_t> &packet, uint64_t rx_ns);
+
     void enableBus();
 
     void disableBus();
 
-    void processDataPacket(const std::vector<uint8_t> &packet) {
+    void processDataPacket(const std::vector<uint8_t> &packet, const FrameTimestamp &timestamp) {
         if (dataCallback) {
             dataCallback(packet); // 调用回调函数
         }
+        if (timedDataCallback) {
+            timedDataCallback(packet, timestamp);
+        }
     }
 };
 
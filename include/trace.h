@@ -0,0 +1,98 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_TRACE_H
+#define UP_CORE_TRACE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * 二进制跟踪：以定长记录记下帧收发、事务开始 / 结束、超时、重试和舵机错误位，供高帧率下的离线分析。
+ *
+ * - 每个线程写入自己的缓冲区（只锁本线程的缓冲区，没有竞争），缓冲区满、flush() 或 stop() 时整块写入文件
+ * - 未开启跟踪时 UP_TRACE 只有一次原子读和判断，可以常驻在热路径上
+ *
+ * 文件格式（小端，与运行平台的内存布局相同）：
+ *  - 文件头 16 字节：魔数 "UPTR"、格式版本 u16、记录长度 u16（32）、开始跟踪时的 monotonicNs u64
+ *  - 之后为连续的 Record，同一线程的记录按时间排列，不同线程的记录块交错
+ *
+ * scripts/trace_decode.py 把跟踪文件转换为 CSV 或 Chrome trace JSON（chrome://tracing、Perfetto）。
+ */
+namespace trace {
+
+    enum Event : uint16_t {
+        FRAME_TX = 1,          // 写出一帧：arg0 为长度，arg1 为帧开头的 8 个字节
+        FRAME_RX = 2,          // 收到一帧：同上，flags 为应答中的错误字节
+        TRANSACTION_BEGIN = 3, // 发送并等待应答开始：transaction 为消息 ID
+        TRANSACTION_END = 4,   // 收到应答：arg0 为应答长度，flags 为错误字节
+        TIMEOUT = 5,           // 等待应答超时：arg0 为超时时间（毫秒）
+        RETRY = 6,             // 重发：transaction 为帧序号，arg1 为第几次重发，flags 为 1 表示收到 NAK
+        ERROR = 7              // 舵机返回错误：flags 为错误字节
+    };
+
+    // 定长跟踪记录
+    struct Record {
+        uint64_t time_ns;     // serial::monotonicNs
+        uint32_t thread;      // 写入线程的编号（按首次写入的顺序从 1 开始）
+        uint16_t event;       // Event
+        uint8_t id;           // 舵机 ID
+        uint8_t flags;        // 错误位等
+        uint32_t transaction; // 事务（消息）ID，0 表示不属于事务
+        uint32_t arg0;
+        uint64_t arg1;
+    };
+
+    static_assert(sizeof(Record) == 32, "trace::Record must stay 32 bytes");
+
+    static const size_t FILE_HEADER_SIZE = 16;
+    static const uint16_t FORMAT_VERSION = 1;
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    /** @brief 是否正在跟踪 */
+    inline bool enabled() {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 开始跟踪，写入 path（覆盖已有文件）；已在跟踪时先结束上一次跟踪
+     * @param buffer_records 每个线程缓冲区的记录数，满时写入文件
+     * @throws std::runtime_error 无法创建文件
+     */
+    void start(const std::string &path, size_t buffer_records = 4096);
+
+    /** @brief 写出所有线程缓冲区中的记录并关闭文件。进程退出时自动调用 */
+    void stop();
+
+    /** @brief 写出所有线程缓冲区中的记录 */
+    void flush();
+
+    /** @brief 写入一条记录，time_ns 为 0 时使用当前时间；未开启跟踪时直接返回 */
+    void emit(Event event, uint8_t id = 0, uint8_t flags = 0, uint32_t transaction = 0, uint32_t arg0 = 0,
+              uint64_t arg1 = 0, uint64_t time_ns = 0);
+
+    /** @brief 记录一帧数据：长度和开头的 8 个字节，舵机 ID 取自帧的第 3 个字节 */
+    void emitFrame(Event event, const uint8_t *frame, size_t size, uint32_t transaction = 0, uint64_t time_ns = 0);
+
+    /** @brief 读取跟踪文件，末尾不完整的记录被忽略 */
+    std::vector<Record> load(const std::string &path, uint64_t *start_ns = nullptr);
+
+    /** @brief 事件名称，未知事件返回 "UNKNOWN" */
+    const char *eventName(uint16_t event);
+
+} // namespace trace
+
+// 只在开启跟踪时计算参数并写入记录
+#define UP_TRACE(...) \
+    do { if (trace::enabled()) trace::emit(__VA_ARGS__); } while (0)
+#define UP_TRACE_FRAME(...) \
+    do { if (trace::enabled()) trace::emitFrame(__VA_ARGS__); } while (0)
+
+#endif //UP_CORE_TRACE_H
@@ -33,6 +33,25 @@ namespace adc {
         uint16_t readChannel(uint8_t channel);   // 读取单个 ADC 通道
         std::vector<uint16_t> readAll();         // 读取所有 ADC 通道
 
+        /**
+         * @brief 一次 SPI_IOC_MESSAGE 读取 channels 中的各通道，结果按顺序写入 values
+         *
+         * 每个通道是一段 3 字节的传输，段之间释放片选开始下一次转换；与逐个 readChannel 相比
+         * 只有一次系统调用，通道之间的采样间隔也更短。
+         * @throws ADCException 通道索引无效
+         * @throws spi::SPIException 传输失败
+         */
+        void readChannels(const uint8_t *channels, size_t count, uint16_t *values);
+
+        /**
+         * @brief 一次 SPI_IOC_MESSAGE 读取所有通道，写入调用方提供的缓冲区
+         * @param capacity values 的长度，不能小于通道数
+         * @return 通道数
+         */
+        size_t readAll(uint16_t *values, size_t capacity);
+
+        uint8_t getChannelCount() const { return channel_count; }
+
     private:
         spi::SPI &spi;
         uint8_t channel_count;
@@ -5,10 +5,17 @@
 #ifndef UP_CORE_GPIO_H
 #define UP_CORE_GPIO_H
 
+#include <functional>
 #include <stdexcept>
 #include <string>
+#include <vector>
+#include <stdint.h>
 #include <gpiod.h>
 
+namespace serial {
+    class Reactor;
+}
+
 namespace gpio {
 /**
  * GPIO 设备异常类
@@ -38,6 +45,93 @@ namespace gpio {
         struct gpiod_chip *chip;
         struct gpiod_line *line;
     };
+
+/**
+ * GPIO 边沿事件
+ */
+    struct LineEvent {
+        unsigned int offset; // 引脚编号
+        bool rising;         // true 为上升沿，false 为下降沿
+        uint64_t time_ns;    // 内核记录的事件时间（Linux 5.7 起为 CLOCK_MONOTONIC，与 serial::monotonicNs 相同）
+    };
+
+/**
+ * 同一控制器上的一组 GPIO 引脚，一次请求、一次调用读写全部引脚
+ *
+ * 输入引脚可以请求边沿事件：每个引脚有一个事件文件描述符（非阻塞），可读时用 readEvents 取出事件，
+ * 也可以通过 watch 加入 serial::Reactor，在事件循环线程中回调，不需要轮询。
+ */
+    class GPIOLines {
+    public:
+        enum Edge {
+            RISING = 1,
+            FALLING = 2,
+            BOTH = 3
+        };
+
+        using EventCallback = std::function<void(const LineEvent &)>;
+
+        // 一次请求最多包含的引脚数（libgpiod 的限制）
+        static const size_t MAX_LINES = 64;
+
+        GPIOLines(int chip_id, const std::vector<unsigned int> &offsets);
+
+        ~GPIOLines();
+
+        GPIOLines(const GPIOLines &) = delete;
+
+        GPIOLines &operator=(const GPIOLines &) = delete;
+
+        void requestOutput(const std::vector<int> &defaults = std::vector<int>()); // 请求为输出，defaults 为初始电平（默认全 0）
+        void requestInput();                                // 请求为输入
+        void requestEvents(Edge edge = BOTH);               // 请求为输入并监听边沿事件
+
+        void setValues(const std::vector<int> &values);     // 一次设置所有引脚的电平（仅输出）
+        void setValues(const int *values);
+        std::vector<int> getValues();                       // 一次读取所有引脚的电平
+        void getValues(int *values);
+
+        /**
+         * @brief 取出第 index 个引脚已发生的边沿事件，没有事件时立即返回
+         * @return 取出的事件数，不超过 max
+         */
+        size_t readEvents(size_t index, LineEvent *events, size_t max);
+
+        int eventFd(size_t index) const;                    // 第 index 个引脚的事件文件描述符（仅事件模式）
+
+        /**
+         * @brief 把所有引脚的事件文件描述符加入 reactor，事件在事件循环线程中逐个回调
+         *
+         * 释放引脚（release 或析构）之前需要先 unwatch。
+         */
+        void watch(serial::Reactor &reactor, EventCallback on_event);
+
+        void unwatch(serial::Reactor &reactor);
+
+        void release();                                     // 释放引脚和控制器
+
+        size_t size() const { return offsets.size(); }
+
+        const std::vector<unsigned int> &getOffsets() const { return offsets; }
+
+    private:
+        enum Mode {
+            NONE,
+            OUTPUT,
+            INPUT,
+            EVENTS
+        };
+
+        void open();
+
+        void checkMode(bool output) const;
+
+        int chip_id;
+        std::vector<unsigned int> offsets;
+        struct gpiod_chip *chip;
+        struct gpiod_line_bulk bulk;
+        Mode mode;
+    };
 }
 
 #endif //UP_CORE_GPIO_H
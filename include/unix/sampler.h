@@ -0,0 +1,133 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_SAMPLER_H
+#define UP_CORE_SAMPLER_H
+
+#include "adc.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace adc {
+
+/**
+ * 采样配置
+ */
+    struct SamplerOptions {
+        std::vector<uint8_t> channels; // 采样的通道，样本中的值按此顺序排列
+        double rate_hz;                // 扫描频率：每秒读取 channels 的次数
+        size_t capacity;               // 环形缓冲区可容纳的样本数
+        uint32_t decimation;           // 每 decimation 次扫描取平均输出一个样本，1 表示不平均
+
+        SamplerOptions() : rate_hz(100), capacity(4096), decimation(1) {}
+    };
+
+/**
+ * 定频采样引擎
+ *
+ * 后台线程按绝对时间表（start 时刻 + n / rate_hz）扫描所选通道，每次扫描用 ADC::readChannels 一次 SPI 传输完成。
+ * 样本（时间戳 + 各通道的值）写入单生产者单消费者的无锁环形缓冲区：
+ *  - 时间戳为扫描开始时的 serial::monotonicNs；取平均时为窗口内首末两次扫描时间的中点
+ *  - 缓冲区满时丢弃新样本并计入 overruns()，不会覆盖尚未读取的样本，因此 peek() 返回的内存可以直接引用
+ *  - 错过的扫描时刻（上一次扫描超时）被跳过并计入 missed()，之后的扫描仍然对齐原时间表
+ *
+ * 同一时间只能有一个线程读取样本（read / peek / consume）。运行期间 ADC 由采样线程独占使用。
+ */
+    class Sampler {
+    public:
+        /**
+         * @throws ADCException 配置无效（没有通道、通道超出范围、频率或容量为 0）
+         */
+        Sampler(ADC &adc, const SamplerOptions &options);
+
+        ~Sampler();
+
+        Sampler(const Sampler &) = delete;
+
+        Sampler &operator=(const Sampler &) = delete;
+
+        void start();          // 启动采样线程，已在运行时不做任何事
+        void stop();           // 停止并等待采样线程退出，缓冲区中的样本保留
+        bool running() const;  // 采样线程是否在运行（读取出错时自动停止）
+
+        /**
+         * @brief 复制并取走最多 max 个样本
+         * @param times 时间戳，长度不小于 max
+         * @param values 各样本的通道值，长度不小于 max * channelCount()
+         * @return 取走的样本数
+         */
+        size_t read(uint64_t *times, uint16_t *values, size_t max);
+
+        /**
+         * @brief 可以直接引用的连续样本：timeData() + first 和 valueData() + first * channelCount() 开始的 n 个样本
+         *
+         * 在 consume 之前，采样线程不会改写这些样本。
+         * @return n，可能小于 available()（样本跨过缓冲区末尾时分两段）
+         */
+        size_t peek(size_t *first) const;
+
+        void consume(size_t count); // 取走 peek 返回的前 count 个样本
+        size_t available() const;   // 尚未取走的样本数
+
+        const uint64_t *timeData() const { return times_.data(); }
+
+        const uint16_t *valueData() const { return values_.data(); }
+
+        size_t channelCount() const { return options_.channels.size(); }
+
+        const SamplerOptions &getOptions() const { return options_; }
+
+        // 各通道原始读数（不经过平均）的最小值 / 最大值；还没有读数时分别为 65535 和 0
+        std::vector<uint16_t> minimum() const;
+
+        std::vector<uint16_t> maximum() const;
+
+        void resetStats(); // 从下一次扫描开始重新统计最小值 / 最大值
+
+        uint64_t scans() const { return scans_.load(std::memory_order_relaxed); }       // 完成的扫描次数
+        uint64_t overruns() const { return overruns_.load(std::memory_order_relaxed); } // 缓冲区满丢弃的样本数
+        uint64_t missed() const { return missed_.load(std::memory_order_relaxed); }     // 跳过的扫描时刻数
+
+        std::string lastError() const; // 采样线程因读取失败而停止时的错误信息
+
+    private:
+        void run();
+
+        void push(uint64_t time_ns, const uint16_t *sample);
+
+        ADC &adc_;
+        SamplerOptions options_;
+
+        // 环形缓冲区：head_ 只由采样线程增加，tail_ 只由读取方增加，均为累计样本数
+        std::vector<uint64_t> times_;
+        std::vector<uint16_t> values_;
+        std::atomic<uint64_t> head_{0};
+        std::atomic<uint64_t> tail_{0};
+
+        std::unique_ptr<std::atomic<uint16_t>[]> min_;
+        std::unique_ptr<std::atomic<uint16_t>[]> max_;
+        std::atomic<bool> reset_stats_{true};
+
+        std::atomic<uint64_t> scans_{0};
+        std::atomic<uint64_t> overruns_{0};
+        std::atomic<uint64_t> missed_{0};
+
+        // 只用于唤醒休眠中的采样线程和保存错误信息，不保护环形缓冲区
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stopping_{false};
+        std::atomic<bool> running_{false};
+        std::string error_;
+        std::thread thread_;
+    };
+
+}
+
+#endif //UP_CORE_SAMPLER_H
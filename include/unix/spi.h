@@ -28,12 +28,29 @@ namespace spi {
     public:
         SPI(const std::string &device, uint32_t speed, uint8_t mode, uint8_t bits_per_word);
 
-        ~SPI();
+        virtual ~SPI();
 
         void init(); // 初始化 SPI 设备
         void transfer(uint8_t *tx, uint8_t *rx, size_t length); // SPI 传输数据
+        void transferBatch(struct spi_ioc_transfer *transfers, size_t count); // 一次 ioctl 提交多段传输
         void close(); // 关闭 SPI 设备
 
+        uint32_t getSpeed() const { return speed; }
+
+        uint8_t getBitsPerWord() const { return bits_per_word; }
+
+        // 一次 SPI_IOC_MESSAGE 最多包含的传输段数（ioctl 参数大小的限制）
+        static const size_t MAX_TRANSFERS = 511;
+
+    protected:
+        /**
+         * @brief 把 count 段传输作为一条消息提交给 spidev，是唯一调用 SPI_IOC_MESSAGE 的地方
+         *
+         * 测试中的模拟 spidev 后端重写此函数，不需要真实设备（见 tests/mock_spidev.h）。
+         * @throws SPIException 设备未初始化或 ioctl 失败
+         */
+        virtual void message(struct spi_ioc_transfer *transfers, size_t count);
+
     private:
         std::string device;
         uint32_t speed;
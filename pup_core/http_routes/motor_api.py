@@ -23,9 +23,8 @@ async def motor(request: HttpRequest, serial_manager=Depends(get_serial_manager)
 
     # ff ff 01 07 03 06 00 00 00 00 ee
     # ff ff 00 07 03 06 00 00 00 00 ef
-    data_bytes = bytes(data)
-    # 将 bytes 转换为十六进制字符串
-    logger.info(f"Motor mode hex data: {binascii.hexlify(data_bytes).decode('utf-8')}")
+    # 构建函数直接返回 bytes
+    logger.info(f"Motor mode hex data: {binascii.hexlify(data).decode('utf-8')}")
 
     byte_buffer = await serial_manager.write_wait(request.serial_id, data)
     if byte_buffer is None:
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""把 up_core 二进制跟踪文件（trace::start 写出的 .uptr）转换为 CSV 或 Chrome trace JSON。
+
+格式见 include/trace.h，只依赖标准库，可以在没有安装 up_core 的电脑上分析跟踪文件：
+
+    python3 scripts/trace_decode.py bus.uptr                  # CSV 输出到标准输出
+    python3 scripts/trace_decode.py bus.uptr -f chrome -o bus.json
+
+Chrome trace JSON 可以在 chrome://tracing 或 https://ui.perfetto.dev 中打开：
+事务（TRANSACTION_BEGIN / END）显示为区间，其余事件显示为瞬时事件，按写入线程分行。
+"""
+import argparse
+import csv
+import json
+import struct
+import sys
+
+MAGIC = b"UPTR"
+FORMAT_VERSION = 1
+HEADER = struct.Struct("<4sHHQ")
+RECORD = struct.Struct("<QIHBBIIQ")
+
+EVENTS = {
+    1: "FRAME_TX",
+    2: "FRAME_RX",
+    3: "TRANSACTION_BEGIN",
+    4: "TRANSACTION_END",
+    5: "TIMEOUT",
+    6: "RETRY",
+    7: "ERROR",
+}
+
+
+def load(path):
+    """读取跟踪文件，返回 (开始时间 ns, 按时间排序的记录列表)，末尾不完整的记录被忽略。"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise ValueError("不是跟踪文件：%s" % path)
+    magic, version, record_size, start_ns = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError("不是跟踪文件：%s" % path)
+    if version != FORMAT_VERSION or record_size != RECORD.size:
+        raise ValueError("不支持的跟踪文件版本：%d" % version)
+
+    records = []
+    end = HEADER.size + (len(data) - HEADER.size) // RECORD.size * RECORD.size
+    for offset in range(HEADER.size, end, RECORD.size):
+        time_ns, thread, event, servo_id, flags, transaction, arg0, arg1 = RECORD.unpack_from(data, offset)
+        records.append({
+            "time_ns": time_ns,
+            "thread": thread,
+            "event": EVENTS.get(event, "UNKNOWN"),
+            "id": servo_id,
+            "flags": flags,
+            "transaction": transaction,
+            "arg0": arg0,
+            "arg1": arg1,
+        })
+    # 不同线程的记录按缓冲区整块写入，按时间重新排序
+    records.sort(key=lambda r: r["time_ns"])
+    return start_ns, records
+
+
+def frame_head(record):
+    """帧事件的 arg1 为帧开头的字节（小端存放），按 arg0 的长度截取为十六进制字符串。"""
+    size = min(record["arg0"], 8)
+    return record["arg1"].to_bytes(8, "little")[:size].hex(" ").upper()
+
+
+def write_csv(start_ns, records, out):
+    writer = csv.writer(out)
+    writer.writerow(["time_us", "thread", "event", "id", "flags", "transaction", "arg0", "arg1", "frame_head"])
+    for r in records:
+        is_frame = r["event"] in ("FRAME_TX", "FRAME_RX")
+        writer.writerow([
+            "%.3f" % ((r["time_ns"] - start_ns) / 1000.0),
+            r["thread"],
+            r["event"],
+            r["id"],
+            "0x%02X" % r["flags"],
+            r["transaction"],
+            r["arg0"],
+            r["arg1"],
+            frame_head(r) if is_frame else "",
+        ])
+
+
+def write_chrome(start_ns, records, out):
+    events = []
+    for r in records:
+        event = {
+            "name": r["event"],
+            "cat": "servo",
+            "ts": (r["time_ns"] - start_ns) / 1000.0,
+            "pid": 1,
+            "tid": r["thread"],
+            "args": {"id": r["id"], "flags": r["flags"], "transaction": r["transaction"],
+                     "arg0": r["arg0"], "arg1": r["arg1"]},
+        }
+        if r["event"] in ("TRANSACTION_BEGIN", "TRANSACTION_END"):
+            # 异步区间：同一事务 ID 的开始和结束配对，不要求在同一线程
+            event["name"] = "transaction"
+            event["cat"] = "transaction"
+            event["ph"] = "b" if r["event"] == "TRANSACTION_BEGIN" else "e"
+            event["id"] = r["transaction"]
+        else:
+            event["ph"] = "i"
+            event["s"] = "t"
+            if r["event"] in ("FRAME_TX", "FRAME_RX"):
+                event["args"]["frame_head"] = frame_head(r)
+        events.append(event)
+    json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="转换 up_core 二进制跟踪文件")
+    parser.add_argument("trace", help="跟踪文件")
+    parser.add_argument("-f", "--format", choices=("csv", "chrome"), default="csv", help="输出格式")
+    parser.add_argument("-o", "--output", help="输出文件，默认为标准输出")
+    args = parser.parse_args()
+
+    start_ns, records = load(args.trace)
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    try:
+        if args.format == "csv":
+            write_csv(start_ns, records, out)
+        else:
+            write_chrome(start_ns, records, out)
+    finally:
+        if out is not sys.stdout:
+            out.close()
+
+
+if __name__ == "__main__":
+    main()
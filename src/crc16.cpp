@@ -0,0 +1,86 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include "crc16.h"
+
+namespace crc16 {
+
+    namespace {
+        const uint16_t POLY = 0x1021;
+
+        /**
+         * 查表数据
+         *  table[0][b]：字节 b 处于最高位时，移位 8 次后对 CRC 的贡献
+         *  table[k][b]：字节 b 之后再跟 k 个 0 字节时对 CRC 的贡献
+         */
+        struct Tables {
+            uint16_t table[8][256];
+
+            Tables() {
+                for (int b = 0; b < 256; ++b) {
+                    uint16_t crc = static_cast<uint16_t>(b << 8);
+                    for (int i = 0; i < 8; ++i) {
+                        crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ POLY)
+                                             : static_cast<uint16_t>(crc << 1);
+                    }
+                    table[0][b] = crc;
+                }
+                for (int k = 1; k < 8; ++k) {
+                    for (int b = 0; b < 256; ++b) {
+                        uint16_t prev = table[k - 1][b];
+                        table[k][b] = static_cast<uint16_t>((prev << 8) ^ table[0][prev >> 8]);
+                    }
+                }
+            }
+        };
+
+        const Tables &tables() {
+            static const Tables instance;
+            return instance;
+        }
+    }
+
+    uint16_t xmodemBitwise(const uint8_t *data, size_t length, uint16_t crc) {
+        for (size_t n = 0; n < length; ++n) {
+            crc ^= static_cast<uint16_t>(data[n] << 8);
+            for (int i = 0; i < 8; ++i) {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ POLY)
+                                     : static_cast<uint16_t>(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    uint16_t xmodemTable(const uint8_t *data, size_t length, uint16_t crc) {
+        const uint16_t *t0 = tables().table[0];
+        for (size_t n = 0; n < length; ++n) {
+            crc = static_cast<uint16_t>((crc << 8) ^ t0[(crc >> 8) ^ data[n]]);
+        }
+        return crc;
+    }
+
+    uint16_t xmodemSlicing8(const uint8_t *data, size_t length, uint16_t crc) {
+        const Tables &t = tables();
+
+        // 当前 CRC 异或进本组前两个字节后，本组 8 个字节相互独立，
+        // 每个字节对结果的贡献只取决于它后面还剩几个字节
+        while (length >= 8) {
+            uint8_t b0 = static_cast<uint8_t>((crc >> 8) ^ data[0]);
+            uint8_t b1 = static_cast<uint8_t>((crc & 0xFF) ^ data[1]);
+            crc = static_cast<uint16_t>(t.table[7][b0] ^ t.table[6][b1] ^
+                                        t.table[5][data[2]] ^ t.table[4][data[3]] ^
+                                        t.table[3][data[4]] ^ t.table[2][data[5]] ^
+                                        t.table[1][data[6]] ^ t.table[0][data[7]]);
+            data += 8;
+            length -= 8;
+        }
+
+        // 剩余不足 8 字节的部分逐字节查表
+        return xmodemTable(data, length, crc);
+    }
+
+    uint16_t xmodem(const uint8_t *data, size_t length, uint16_t crc) {
+        return xmodemSlicing8(data, length, crc);
+    }
+}
@@ -0,0 +1,40 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include "crc32.h"
+
+namespace crc32 {
+
+    namespace {
+        const uint32_t POLY = 0xEDB88320;
+
+        struct Table {
+            uint32_t table[256];
+
+            Table() {
+                for (uint32_t b = 0; b < 256; ++b) {
+                    uint32_t crc = b;
+                    for (int i = 0; i < 8; ++i) {
+                        crc = (crc & 1) ? (crc >> 1) ^ POLY : crc >> 1;
+                    }
+                    table[b] = crc;
+                }
+            }
+        };
+
+        const Table &table() {
+            static const Table instance;
+            return instance;
+        }
+    }
+
+    uint32_t compute(const uint8_t *data, size_t length, uint32_t crc) {
+        const uint32_t *t = table().table;
+        crc = ~crc;
+        for (size_t n = 0; n < length; ++n) {
+            crc = t[(crc ^ data[n]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+}
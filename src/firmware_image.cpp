@@ -0,0 +1,174 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include "firmware_image.h"
+#include "crc16.h"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+FirmwareImage::~FirmwareImage() {
+    reset();
+}
+
+FirmwareImage::FirmwareImage(FirmwareImage &&other) noexcept {
+    *this = std::move(other);
+}
+
+FirmwareImage &FirmwareImage::operator=(FirmwareImage &&other) noexcept {
+    if (this != &other) {
+        reset();
+
+        owned_ = std::move(other.owned_);
+        mapping_ = other.mapping_;
+        mapping_size_ = other.mapping_size_;
+        size_ = other.size_;
+        // vector 移动后缓冲区地址不变，data_ 仍然有效
+        data_ = other.data_;
+
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapping_ = nullptr;
+        other.mapping_size_ = 0;
+    }
+    return *this;
+}
+
+void FirmwareImage::reset() {
+#ifndef _WIN32
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mapping_size_);
+    }
+#endif
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    owned_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+FirmwareImage FirmwareImage::fromFile(const std::string &path) {
+    FirmwareImage image;
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file");
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat file");
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size > 0) {
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to mmap file");
+        }
+        // 固件按顺序发送，提示内核预读
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+        image.mapping_ = mapping;
+        image.mapping_size_ = size;
+        image.data_ = static_cast<const uint8_t *>(mapping);
+        image.size_ = size;
+    }
+
+    // 映射建立后即可关闭文件描述符
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file");
+    }
+    image.owned_.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    image.data_ = image.owned_.data();
+    image.size_ = image.owned_.size();
+#endif
+
+    return image;
+}
+
+FirmwareImage FirmwareImage::fromBuffer(const uint8_t *data, size_t size) {
+    FirmwareImage image;
+    image.data_ = data;
+    image.size_ = size;
+    return image;
+}
+
+const size_t FirmwareFrameStream::BLOCK_SIZE;
+const size_t FirmwareFrameStream::BLOCK_SIZE_1K;
+const size_t FirmwareFrameStream::FRAME_SIZE;
+
+FirmwareFrameStream::FirmwareFrameStream(const uint8_t *data, size_t size, size_t block_size)
+        : data_(data), size_(size) {
+    setBlockSize(block_size);
+}
+
+FirmwareFrameStream::FirmwareFrameStream(const FirmwareImage &image, size_t block_size)
+        : FirmwareFrameStream(image.data(), image.size(), block_size) {
+}
+
+void FirmwareFrameStream::setBlockSize(size_t block_size) {
+    if (block_size != BLOCK_SIZE && block_size != BLOCK_SIZE_1K) {
+        throw std::invalid_argument("block size must be 128 or 1024");
+    }
+    block_size_ = block_size;
+    frame_.assign(block_size_ + 5, 0);
+}
+
+size_t FirmwareFrameStream::frameCount() const {
+    return (size_ + block_size_ - 1) / block_size_;
+}
+
+const std::vector<uint8_t> &FirmwareFrameStream::frame(size_t index) {
+    // 包序号从 1 开始计数，只取低 8 位
+    uint8_t packetNumber = static_cast<uint8_t>(index + 1);
+
+    // 帧头：类型标识（128 字节为 SOH，1K 为 STX）、包序号、包序号反码
+    frame_[0] = block_size_ == BLOCK_SIZE_1K ? 0x02 : 0x01;
+    frame_[1] = packetNumber;
+    frame_[2] = 255 - packetNumber;
+
+    // 最后一个包可能不足一个数据块，剩余部分补 0
+    size_t offset = index * block_size_;
+    size_t copySize = std::min(size_ - offset, block_size_);
+    std::memcpy(&frame_[3], data_ + offset, copySize);
+    if (copySize < block_size_) {
+        std::memset(&frame_[3 + copySize], 0, block_size_ - copySize);
+    }
+
+    // CRC 只覆盖实际数据部分，直接在帧缓冲区上计算，不再构造临时 vector
+    uint16_t crc = crc16::xmodem(&frame_[3], copySize);
+    frame_[block_size_ + 3] = crc >> 8;
+    frame_[block_size_ + 4] = crc & 0xFF;
+
+    return frame_;
+}
+
+void FirmwareFrameStream::setPrecomputedFrames(const uint8_t *frames, size_t block_size) {
+    precomputed_ = frames;
+    precomputed_block_size_ = block_size;
+}
+
+const uint8_t *FirmwareFrameStream::frameData(size_t index) {
+    if (precomputed_ != nullptr && precomputed_block_size_ == block_size_) {
+        return precomputed_ + index * frameSize();
+    }
+    return frame(index).data();
+}
@@ -0,0 +1,205 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include "firmware_package.h"
+#include "crc16.h"
+#include "crc32.h"
+
+namespace {
+    const uint8_t MAGIC[4] = {'U', 'P', 'F', 'W'};
+
+    // 包头各字段的偏移
+    const size_t OFFSET_FORMAT = 4;
+    const size_t OFFSET_HEADER_SIZE = 6;
+    const size_t OFFSET_MODEL = 8;
+    const size_t OFFSET_VERSION = 40;
+    const size_t OFFSET_IMAGE_SIZE = 56;
+    const size_t OFFSET_BLOCK_SIZE = 60;
+    const size_t OFFSET_BLOCK_COUNT = 64;
+    const size_t OFFSET_IMAGE_CRC = 68;
+    const size_t OFFSET_HEADER_CRC = 76;
+
+    void putU16(uint8_t *p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value);
+        p[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void putU32(uint8_t *p, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            p[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    uint16_t getU16(const uint8_t *p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t getU32(const uint8_t *p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    // 定长字段去掉末尾的 0
+    std::string getString(const uint8_t *p, size_t size) {
+        size_t length = 0;
+        while (length < size && p[length] != 0) {
+            ++length;
+        }
+        return std::string(reinterpret_cast<const char *>(p), length);
+    }
+
+    // 包头 CRC 覆盖 CRC 字段之前的包头及数据块 CRC 表
+    uint32_t headerCrc(const uint8_t *header, size_t table_size) {
+        uint32_t crc = crc32::compute(header, OFFSET_HEADER_CRC);
+        return crc32::compute(header + FirmwarePackage::HEADER_SIZE, table_size, crc);
+    }
+
+    void invalid(const std::string &reason) {
+        throw std::runtime_error("Invalid firmware package: " + reason);
+    }
+}
+
+const size_t FirmwarePackage::HEADER_SIZE;
+const size_t FirmwarePackage::MODEL_SIZE;
+const size_t FirmwarePackage::VERSION_SIZE;
+const uint16_t FirmwarePackage::FORMAT_VERSION;
+
+std::vector<uint8_t> FirmwarePackage::pack(const uint8_t *image, size_t size, const std::string &model,
+                                           const std::string &version, size_t block_size) {
+    if (block_size != FirmwareFrameStream::BLOCK_SIZE && block_size != FirmwareFrameStream::BLOCK_SIZE_1K) {
+        throw std::invalid_argument("block size must be 128 or 1024");
+    }
+    if (model.size() > MODEL_SIZE || version.size() > VERSION_SIZE) {
+        throw std::invalid_argument("model or version too long");
+    }
+
+    size_t block_count = (size + block_size - 1) / block_size;
+    size_t table_size = block_count * 2;
+    std::vector<uint8_t> package(HEADER_SIZE + table_size + size, 0);
+    uint8_t *header = package.data();
+
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    putU16(header + OFFSET_FORMAT, FORMAT_VERSION);
+    putU16(header + OFFSET_HEADER_SIZE, static_cast<uint16_t>(HEADER_SIZE));
+    std::memcpy(header + OFFSET_MODEL, model.data(), model.size());
+    std::memcpy(header + OFFSET_VERSION, version.data(), version.size());
+    putU32(header + OFFSET_IMAGE_SIZE, static_cast<uint32_t>(size));
+    putU32(header + OFFSET_BLOCK_SIZE, static_cast<uint32_t>(block_size));
+    putU32(header + OFFSET_BLOCK_COUNT, static_cast<uint32_t>(block_count));
+    putU32(header + OFFSET_IMAGE_CRC, crc32::compute(image, size));
+
+    // 数据块 CRC 与数据帧中的 CRC 一致：最后一块只覆盖实际数据，不含补零
+    uint8_t *table = header + HEADER_SIZE;
+    for (size_t i = 0; i < block_count; ++i) {
+        size_t offset = i * block_size;
+        putU16(table + i * 2, crc16::xmodem(image + offset, std::min(size - offset, block_size)));
+    }
+    putU32(header + OFFSET_HEADER_CRC, headerCrc(header, table_size));
+
+    if (size > 0) {
+        std::memcpy(table + table_size, image, size);
+    }
+    return package;
+}
+
+bool FirmwarePackage::isPackage(const uint8_t *data, size_t size) {
+    return size >= sizeof(MAGIC) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+FirmwarePackage FirmwarePackage::fromFile(const std::string &path) {
+    return fromImage(FirmwareImage::fromFile(path));
+}
+
+FirmwarePackage FirmwarePackage::fromImage(FirmwareImage &&image) {
+    FirmwarePackage package;
+    package.file_ = std::move(image);
+    package.load();
+    return package;
+}
+
+FirmwarePackage FirmwarePackage::fromBuffer(const uint8_t *data, size_t size) {
+    FirmwarePackage package;
+    package.buffer_.assign(data, data + size);
+    package.file_ = FirmwareImage::fromBuffer(package.buffer_.data(), package.buffer_.size());
+    package.load();
+    return package;
+}
+
+void FirmwarePackage::load() {
+    const uint8_t *data = file_.data();
+    size_t size = file_.size();
+
+    // 1. 包头
+    if (!isPackage(data, size) || size < HEADER_SIZE) {
+        invalid("bad magic");
+    }
+    if (getU16(data + OFFSET_FORMAT) != FORMAT_VERSION) {
+        invalid("unsupported format version " + std::to_string(getU16(data + OFFSET_FORMAT)));
+    }
+    if (getU16(data + OFFSET_HEADER_SIZE) != HEADER_SIZE) {
+        invalid("bad header size");
+    }
+
+    image_size_ = getU32(data + OFFSET_IMAGE_SIZE);
+    block_size_ = getU32(data + OFFSET_BLOCK_SIZE);
+    size_t block_count = getU32(data + OFFSET_BLOCK_COUNT);
+    if (block_size_ != FirmwareFrameStream::BLOCK_SIZE && block_size_ != FirmwareFrameStream::BLOCK_SIZE_1K) {
+        invalid("bad block size " + std::to_string(block_size_));
+    }
+    if (block_count != (image_size_ + block_size_ - 1) / block_size_) {
+        invalid("block count does not match image size");
+    }
+
+    size_t table_size = block_count * 2;
+    if (size != HEADER_SIZE + table_size + image_size_) {
+        invalid("expected " + std::to_string(HEADER_SIZE + table_size + image_size_) +
+                " bytes, got " + std::to_string(size));
+    }
+    if (getU32(data + OFFSET_HEADER_CRC) != headerCrc(data, table_size)) {
+        invalid("header CRC mismatch");
+    }
+
+    model_ = getString(data + OFFSET_MODEL, MODEL_SIZE);
+    version_ = getString(data + OFFSET_VERSION, VERSION_SIZE);
+    image_crc_ = getU32(data + OFFSET_IMAGE_CRC);
+    image_ = data + HEADER_SIZE + table_size;
+
+    // 2. 整个镜像
+    if (crc32::compute(image_, image_size_) != image_crc_) {
+        invalid("image CRC mismatch");
+    }
+
+    // 3. 逐块校验，同时组装数据帧；帧中的 CRC 直接使用包内的值
+    const uint8_t *table = data + HEADER_SIZE;
+    size_t frame_size = block_size_ + 5;
+    block_crcs_.resize(block_count);
+    frames_.assign(block_count * frame_size, 0);
+    for (size_t i = 0; i < block_count; ++i) {
+        size_t offset = i * block_size_;
+        size_t copySize = std::min(image_size_ - offset, block_size_);
+        uint16_t crc = getU16(table + i * 2);
+        if (crc16::xmodem(image_ + offset, copySize) != crc) {
+            invalid("CRC mismatch in block " + std::to_string(i));
+        }
+        block_crcs_[i] = crc;
+
+        uint8_t *frame = &frames_[i * frame_size];
+        uint8_t packetNumber = static_cast<uint8_t>(i + 1);
+        frame[0] = block_size_ == FirmwareFrameStream::BLOCK_SIZE_1K ? 0x02 : 0x01;
+        frame[1] = packetNumber;
+        frame[2] = 255 - packetNumber;
+        std::memcpy(frame + 3, image_ + offset, copySize);
+        frame[block_size_ + 3] = crc >> 8;
+        frame[block_size_ + 4] = crc & 0xFF;
+    }
+}
+
+FirmwareFrameStream FirmwarePackage::frameStream() const {
+    FirmwareFrameStream stream(image_, image_size_, block_size_);
+    stream.setPrecomputedFrames(frames_.data(), block_size_);
+    return stream;
+}
@@ -0,0 +1,185 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "firmware_rollout.h"
+#include "logger.h"
+
+FirmwareRollout::FirmwareRollout(int baud_rate, size_t max_workers)
+        : baud_rate(baud_rate), max_workers(max_workers) {
+}
+
+void FirmwareRollout::setRetry(int total_retry_, int handshake_threshold_, int frame_retry_count_,
+                               int sign_retry_count_) {
+    this->total_retry = total_retry_;
+    this->handshake_threshold = handshake_threshold_;
+    this->frame_retry_count = frame_retry_count_;
+    this->sign_retry_count = sign_retry_count_;
+}
+
+std::vector<RolloutResult>
+FirmwareRollout::runPath(const std::vector<RolloutTarget> &targets, const std::string &bin_path) {
+    FirmwareImage image;
+    FirmwarePackage package;
+    bool is_package = false;
+    try {
+        image = FirmwareImage::fromFile(bin_path);
+        // 固件包只校验一次，所有总线共用
+        is_package = FirmwarePackage::isPackage(image.data(), image.size());
+        if (is_package) {
+            package = FirmwarePackage::fromImage(std::move(image));
+        }
+    } catch (const std::exception &e) {
+        Logger::error("❌ 读取固件文件失败：" + std::string(e.what()));
+
+        // 固件无法读取或校验失败，所有目标均失败
+        std::vector<RolloutResult> results(targets.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            results[i].target = targets[i];
+            results[i].error = e.what();
+        }
+        return results;
+    }
+
+    if (is_package) {
+        return run(targets, package);
+    }
+    return run(targets, image.data(), image.size());
+}
+
+std::vector<RolloutResult>
+FirmwareRollout::run(const std::vector<RolloutTarget> &targets, const uint8_t *data, size_t size) {
+    return runAll(targets, data, size, nullptr);
+}
+
+std::vector<RolloutResult>
+FirmwareRollout::run(const std::vector<RolloutTarget> &targets, const FirmwarePackage &package) {
+    return runAll(targets, package.image(), package.imageSize(), &package);
+}
+
+std::vector<RolloutResult>
+FirmwareRollout::runAll(const std::vector<RolloutTarget> &targets, const uint8_t *data, size_t size,
+                        const FirmwarePackage *package) {
+    std::vector<RolloutResult> results(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        results[i].target = targets[i];
+    }
+
+    // 按串口分组，保持同一总线上舵机的原始顺序
+    std::vector<std::string> ports;
+    std::vector<std::vector<size_t> > buses;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        auto it = std::find(ports.begin(), ports.end(), targets[i].port);
+        if (it == ports.end()) {
+            ports.push_back(targets[i].port);
+            buses.emplace_back();
+            buses.back().push_back(i);
+        } else {
+            buses[it - ports.begin()].push_back(i);
+        }
+    }
+
+    size_t workers = buses.size();
+    if (max_workers > 0) {
+        workers = std::min(workers, max_workers);
+    }
+
+    Logger::info("开始批量升级：" + std::to_string(targets.size()) + " 个舵机，" +
+                 std::to_string(buses.size()) + " 条总线，" + std::to_string(workers) + " 个工作线程");
+
+    // 每个工作线程领取一条总线，处理完后继续领取下一条
+    std::atomic<size_t> next_bus{0};
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&] {
+            while (true) {
+                size_t bus = next_bus.fetch_add(1);
+                if (bus >= buses.size()) {
+                    break;
+                }
+                runBus(buses[bus], targets, data, size, package, results);
+            }
+        });
+    }
+
+    for (auto &thread: pool) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    size_t succeeded = std::count_if(results.begin(), results.end(),
+                                     [](const RolloutResult &result) { return result.success; });
+    Logger::info("批量升级完成：成功 " + std::to_string(succeeded) + " / " + std::to_string(results.size()));
+
+    return results;
+}
+
+void FirmwareRollout::runBus(const std::vector<size_t> &indices, const std::vector<RolloutTarget> &targets,
+                             const uint8_t *data, size_t size, const FirmwarePackage *package,
+                             std::vector<RolloutResult> &results) {
+    const std::string &port = targets[indices.front()].port;
+
+    // 整条总线共用一个串口，各舵机升级时只切换波特率
+    std::shared_ptr<serial::Serial> bus_serial;
+    std::string open_error;
+    try {
+        bus_serial = std::make_shared<serial::Serial>(port, baud_rate, serial::Timeout::simpleTimeout(1000));
+    } catch (const std::exception &e) {
+        open_error = e.what();
+        Logger::error("❌ 打开串口 " + port + " 失败：" + open_error);
+    }
+
+    for (size_t index: indices) {
+        RolloutResult &result = results[index];
+        auto start = std::chrono::steady_clock::now();
+
+        if (bus_serial) {
+            FirmwareUpdate update;
+            update.setTransferOptions(block_size, transfer_baud_rate);
+            update.setProgressCallback([this, index](size_t sent, size_t total) {
+                if (progressCallback) {
+                    std::lock_guard<std::mutex> lock(callback_mutex);
+                    progressCallback(index, sent, total);
+                }
+            });
+
+            try {
+                if (package != nullptr) {
+                    result.success = update.upgrade_serial(bus_serial, baud_rate, *package,
+                                                           targets[index].servo_id, total_retry,
+                                                           handshake_threshold, frame_retry_count,
+                                                           sign_retry_count);
+                } else {
+                    result.success = update.upgrade_serial(bus_serial, baud_rate, data, size,
+                                                           targets[index].servo_id, total_retry,
+                                                           handshake_threshold, frame_retry_count,
+                                                           sign_retry_count);
+                }
+                if (!result.success) {
+                    result.error = "upgrade failed";
+                }
+            } catch (const std::exception &e) {
+                result.success = false;
+                result.error = e.what();
+            }
+            result.metrics = update.getMetrics();
+        } else {
+            result.error = open_error;
+        }
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Logger::info(std::string(result.success ? "✅" : "❌") + " " + port + " 舵机 " +
+                     std::to_string(targets[index].servo_id) + " 升级" + (result.success ? "成功" : "失败"));
+
+        if (resultCallback) {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            resultCallback(index, result);
+        }
+    }
+}
@@ -6,11 +6,14 @@
 #if !defined(_WIN32)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sstream>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <sys/signal.h>
 #include <errno.h>
 #include <paths.h>
@@ -58,6 +61,7 @@ using serial::Serial;
 using serial::SerialException;
 using serial::PortNotOpenedException;
 using serial::IOException;
+using serial::LowLatencyInfo;
 
 
 MillisecondTimer::MillisecondTimer(const uint32_t millis)
@@ -153,8 +157,49 @@ Serial::SerialImpl::open() {
 
     reconfigurePort();
     is_open_ = true;
+
+    if (low_latency_)
+        applyLowLatency();
+}
+
+#if defined(__linux__)
+
+// USB 串口芯片（FTDI 等）的 latency_timer sysfs 节点，端口可以是 /dev/serial/by-id 下的链接
+static string
+latencyTimerPath(const string &port) {
+    char resolved[PATH_MAX];
+    string device = ::realpath(port.c_str(), resolved) != NULL ? string(resolved) : port;
+    string::size_type slash = device.rfind('/');
+    return "/sys/class/tty/" + device.substr(slash == string::npos ? 0 : slash + 1) + "/device/latency_timer";
 }
 
+static int
+readLatencyTimer(const string &path) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == NULL) {
+        return -1;
+    }
+    int value = -1;
+    if (fscanf(file, "%d", &value) != 1) {
+        value = -1;
+    }
+    fclose(file);
+    return value;
+}
+
+static bool
+writeLatencyTimer(const string &path, int value) {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == NULL) {
+        return false;
+    }
+    bool ok = fprintf(file, "%d", value) > 0;
+    // sysfs 在 fclose 时才真正写入，错误也在此时返回
+    return fclose(file) == 0 && ok;
+}
+
+#endif
+
 void
 Serial::SerialImpl::reconfigurePort() {
     if (fd_ == -1) {
@@ -518,10 +563,106 @@ Serial::SerialImpl::reconfigurePort() {
     }
 }
 
+LowLatencyInfo
+Serial::SerialImpl::setLowLatency(bool enabled) {
+    low_latency_ = enabled;
+    if (is_open_) {
+        if (enabled)
+            applyLowLatency();
+        else
+            restoreLowLatency();
+    } else {
+        low_latency_info_ = LowLatencyInfo();
+        low_latency_info_.enabled = enabled;
+        low_latency_info_.details = enabled ? "pending until the port is opened" : "";
+    }
+    return low_latency_info_;
+}
+
+LowLatencyInfo
+Serial::SerialImpl::getLowLatency() const {
+    return low_latency_info_;
+}
+
+void
+Serial::SerialImpl::applyLowLatency() {
+    LowLatencyInfo info;
+    info.enabled = true;
+    stringstream details;
+
+#if defined(__linux__) && defined(TIOCSSERIAL) && defined(ASYNC_LOW_LATENCY)
+    // 1. 驱动标志：收到数据后立即推送给 tty 层，ftdi_sio 同时把 latency_timer 设为 1 ms
+    struct serial_struct ser;
+    if (-1 == ioctl(fd_, TIOCGSERIAL, &ser)) {
+        details << "ASYNC_LOW_LATENCY unsupported (" << strerror(errno) << ")";
+    } else {
+        int was_set = (ser.flags & ASYNC_LOW_LATENCY) ? 1 : 0;
+        ser.flags |= ASYNC_LOW_LATENCY;
+        if (-1 == ioctl(fd_, TIOCSSERIAL, &ser)) {
+            details << "ASYNC_LOW_LATENCY rejected (" << strerror(errno) << ")";
+        } else {
+            if (saved_async_low_latency_ < 0)
+                saved_async_low_latency_ = was_set;
+            info.async_low_latency = true;
+            details << "ASYNC_LOW_LATENCY on";
+        }
+    }
+
+    // 2. USB 串口芯片的 latency timer
+    string path = latencyTimerPath(port_);
+    int current = readLatencyTimer(path);
+    if (current < 0) {
+        details << "; latency_timer unavailable";
+    } else if (current <= 1) {
+        info.latency_timer_ms = current;
+        details << "; latency_timer " << current << " ms";
+    } else if (writeLatencyTimer(path, 1)) {
+        if (saved_latency_timer_ < 0)
+            saved_latency_timer_ = current;
+        info.latency_timer_ms = readLatencyTimer(path);
+        details << "; latency_timer " << current << " -> " << info.latency_timer_ms << " ms";
+    } else {
+        info.latency_timer_ms = current;
+        details << "; latency_timer " << current << " ms, not writable (" << strerror(errno) << ")";
+    }
+    details << "; ";
+#endif
+
+    // 3. 读取不再按字节时间预先等待；VMIN / VTIME 已为 0 / 0，由 select 等待数据
+    info.immediate_read = true;
+    details << "immediate read, VMIN 0 VTIME 0";
+
+    info.details = details.str();
+    low_latency_info_ = info;
+}
+
+void
+Serial::SerialImpl::restoreLowLatency() {
+#if defined(__linux__) && defined(TIOCSSERIAL) && defined(ASYNC_LOW_LATENCY)
+    // 只清除由 applyLowLatency 置位的标志，原本已置位时保持不变
+    if (saved_async_low_latency_ == 0) {
+        struct serial_struct ser;
+        if (0 == ioctl(fd_, TIOCGSERIAL, &ser)) {
+            ser.flags &= ~ASYNC_LOW_LATENCY;
+            ioctl(fd_, TIOCSSERIAL, &ser);
+        }
+    }
+    saved_async_low_latency_ = -1;
+    if (saved_latency_timer_ >= 0) {
+        writeLatencyTimer(latencyTimerPath(port_), saved_latency_timer_);
+        saved_latency_timer_ = -1;
+    }
+#endif
+    low_latency_info_ = LowLatencyInfo();
+}
+
 void
 Serial::SerialImpl::close() {
     if (is_open_ == true) {
         if (fd_ != -1) {
+            if (low_latency_)
+                restoreLowLatency();
+
             int ret;
             ret = ::close(fd_);
             if (ret == 0) {
@@ -624,7 +765,7 @@ Serial::SerialImpl::read(uint8_t *buf, size_t size) {
             // If it's a fixed-length multi-byte read, insert a wait here so that
             // we can attempt to grab the whole thing in a single IO call. Skip
             // this wait if a non-max inter_byte_timeout is specified.
-            if (size > 1 && timeout_.inter_byte_timeout == Timeout::max()) {
+            if (size > 1 && timeout_.inter_byte_timeout == Timeout::max() && !low_latency_info_.immediate_read) {
                 size_t bytes_available = available();
                 if (bytes_available + bytes_read < size) {
                     waitByteTimes(size - (bytes_available + bytes_read));
@@ -666,6 +807,38 @@ Serial::SerialImpl::read(uint8_t *buf, size_t size) {
 
 size_t
 Serial::SerialImpl::write(const uint8_t *data, size_t length) {
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t *> (data);
+    iov.iov_len = length;
+    return writeVectored(&iov, 1, length);
+}
+
+size_t
+Serial::SerialImpl::writeBatch(const std::vector<std::vector<uint8_t> > &frames) {
+    std::vector<struct iovec> iov;
+    iov.reserve(frames.size());
+    size_t length = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (frames[i].empty()) {
+            continue;
+        }
+        struct iovec entry;
+        entry.iov_base = const_cast<uint8_t *> (frames[i].data());
+        entry.iov_len = frames[i].size();
+        iov.push_back(entry);
+        length += frames[i].size();
+    }
+    if (iov.empty()) {
+        if (is_open_ == false) {
+            throw PortNotOpenedException("Serial::writeBatch");
+        }
+        return 0;
+    }
+    return writeVectored(&iov[0], iov.size(), length);
+}
+
+size_t
+Serial::SerialImpl::writeVectored(struct iovec *iov, size_t count, size_t length) {
     if (is_open_ == false) {
         throw PortNotOpenedException("Serial::write");
     }
@@ -716,7 +889,7 @@ Serial::SerialImpl::write(const uint8_t *data, size_t length) {
             if (FD_ISSET (fd_, &writefds)) {
                 // This will write some
                 ssize_t bytes_written_now =
-                        ::write(fd_, data + bytes_written, length - bytes_written);
+                        ::writev(fd_, iov, static_cast<int> (std::min(count, static_cast<size_t> (IOV_MAX))));
 
                 // even though pselect returned readiness the call might still be
                 // interrupted. In that case simply retry.
@@ -741,6 +914,17 @@ Serial::SerialImpl::write(const uint8_t *data, size_t length) {
                 }
                 // Update bytes_written
                 bytes_written += static_cast<size_t> (bytes_written_now);
+                // Skip the buffers written completely and advance into a partially written one
+                size_t advance = static_cast<size_t> (bytes_written_now);
+                while (count > 0 && advance >= iov->iov_len) {
+                    advance -= iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+                if (count > 0) {
+                    iov->iov_base = static_cast<uint8_t *> (iov->iov_base) + advance;
+                    iov->iov_len -= advance;
+                }
                 // If bytes_written == size then we have written everything we need to
                 if (bytes_written == length) {
                     break;
@@ -774,6 +958,11 @@ Serial::SerialImpl::getPort() const {
     return port_;
 }
 
+int
+Serial::SerialImpl::getFd() const {
+    return is_open_ ? fd_ : -1;
+}
+
 void
 Serial::SerialImpl::setTimeout(serial::Timeout &timeout) {
     timeout_ = timeout;
@@ -19,6 +19,7 @@ using serial::flowcontrol_t;
 using serial::SerialException;
 using serial::PortNotOpenedException;
 using serial::IOException;
+using serial::LowLatencyInfo;
 
 inline wstring
 _prefix_port_if_needed(const wstring &input)
@@ -361,6 +362,20 @@ Serial::SerialImpl::write (const uint8_t *data, size_t length)
   return (size_t) (bytes_written);
 }
 
+size_t
+Serial::SerialImpl::writeBatch (const std::vector<std::vector<uint8_t> > &frames)
+{
+  // 没有 writev，合并为一次 WriteFile
+  std::vector<uint8_t> buffer;
+  for (size_t i = 0; i < frames.size (); ++i) {
+    buffer.insert (buffer.end (), frames[i].begin (), frames[i].end ());
+  }
+  if (buffer.empty ()) {
+    return 0;
+  }
+  return write (&buffer[0], buffer.size ());
+}
+
 void
 Serial::SerialImpl::setPort (const string &port)
 {
@@ -373,6 +388,22 @@ Serial::SerialImpl::getPort () const
   return string(port_.begin(), port_.end());
 }
 
+LowLatencyInfo
+Serial::SerialImpl::setLowLatency (bool enabled)
+{
+  // USB 串口驱动的 latency timer 只能在设备管理器中修改
+  low_latency_info_ = LowLatencyInfo();
+  low_latency_info_.enabled = enabled;
+  low_latency_info_.details = enabled ? "not supported on Windows" : "";
+  return low_latency_info_;
+}
+
+LowLatencyInfo
+Serial::SerialImpl::getLowLatency () const
+{
+  return low_latency_info_;
+}
+
 void
 Serial::SerialImpl::setTimeout (serial::Timeout &timeout)
 {
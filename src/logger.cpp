@@ -2,25 +2,309 @@
 // Created by noodles on 25-2-21.
 //
 
-#include <sstream>
-#include <iomanip>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 #include "logger.h"
 #include "servo_protocol.h"
 
+namespace {
+    // "YYYY-mm-dd HH:MM:SS.mmm"
+    const size_t TIME_LENGTH = 23;
+
+    // 格式化当前时间，同一秒内只调用一次 localtime / strftime，之后只填写毫秒
+    void formatCurrentTime(char *out) {
+        thread_local time_t cached_second = -1;
+        thread_local char cached[20];
+
+        auto now = std::chrono::system_clock::now();
+        long long milliseconds_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now.time_since_epoch()).count();
+        time_t second = static_cast<time_t>(milliseconds_since_epoch / 1000);
+        int milliseconds = static_cast<int>(milliseconds_since_epoch % 1000);
+
+        if (second != cached_second) {
+            std::tm tm{};
+#ifdef _WIN32
+            localtime_s(&tm, &second);
+#else
+            localtime_r(&second, &tm);
+#endif
+            std::strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", &tm);
+            cached_second = second;
+        }
+
+        std::memcpy(out, cached, 19);
+        out[19] = '.';
+        out[20] = static_cast<char>('0' + milliseconds / 100);
+        out[21] = static_cast<char>('0' + milliseconds / 10 % 10);
+        out[22] = static_cast<char>('0' + milliseconds % 10);
+    }
+
+    // 按输出格式追加一行日志
+    void appendLine(std::string &line, const char *time, const char *level, const std::string &message) {
+        line.append(time, TIME_LENGTH);
+        line.append(" [");
+        line.append(level);
+        line.append("] ");
+        line.append(message);
+        line.push_back('\n');
+    }
+
+    /**
+     * @brief 异步日志后端
+     *
+     * 有界多生产者队列（每个槽位带序号，生产者用 CAS 占位），单个后台线程消费：
+     * 取出当前队列中的全部日志，按输出目标拼接后一次写出并刷新。
+     */
+    class AsyncBackend {
+    public:
+        explicit AsyncBackend(const Logger::AsyncOptions &options)
+                : overflow_(options.overflow), flush_interval_ms_(options.flush_interval_ms) {
+            size_t capacity = 2;
+            while (capacity < options.capacity) {
+                capacity <<= 1;
+            }
+            mask_ = capacity - 1;
+            slots_.reset(new Slot[capacity]);
+            for (size_t i = 0; i < capacity; ++i) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            if (!options.path.empty()) {
+                file_ = std::fopen(options.path.c_str(), "a");
+                if (file_ == nullptr) {
+                    throw std::runtime_error("无法打开日志文件 " + options.path);
+                }
+            }
+            thread_ = std::thread(&AsyncBackend::run, this);
+        }
+
+        // 写完队列中的日志后停止后台线程
+        ~AsyncBackend() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_one();
+            thread_.join();
+            if (file_ != nullptr) {
+                std::fclose(file_);
+            }
+        }
+
+        void push(Logger::LogLevel level, const char *name, const char *time, const std::string &message) {
+            while (!tryPush(level, name, time, message)) {
+                if (overflow_ == Logger::DROP) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                wake_.notify_one();
+                std::this_thread::yield();
+            }
+            // 队列过半时提前唤醒后台线程，其余情况由后台线程按间隔取走
+            if (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed) > mask_ / 2) {
+                wake_.notify_one();
+            }
+        }
+
+        void flush() {
+            size_t target = head_.load(std::memory_order_acquire);
+            std::unique_lock<std::mutex> lock(mutex_);
+            flush_requested_ = true;
+            wake_.notify_one();
+            flushed_.wait(lock, [this, target] { return tail_.load(std::memory_order_acquire) >= target; });
+        }
+
+        uint64_t dropped() const {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            Logger::LogLevel level;
+            const char *name;
+            char time[TIME_LENGTH];
+            std::string text; // 槽位复用时保留容量，短日志不再分配内存
+        };
+
+        bool tryPush(Logger::LogLevel level, const char *name, const char *time, const std::string &message) {
+            size_t position = head_.load(std::memory_order_relaxed);
+            while (true) {
+                Slot &slot = slots_[position & mask_];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0) {
+                    if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.level = level;
+                        slot.name = name;
+                        std::memcpy(slot.time, time, TIME_LENGTH);
+                        slot.text.assign(message);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false; // 队列已满
+                } else {
+                    position = head_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 取出当前队列中的全部日志，返回条数
+        size_t drain() {
+            size_t count = 0;
+            size_t position = tail_.load(std::memory_order_relaxed);
+            while (true) {
+                Slot &slot = slots_[position & mask_];
+                if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                    break;
+                }
+                appendLine(outputFor(slot.level), slot.time, slot.name, slot.text);
+                slot.text.clear();
+                slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+                ++position;
+                ++count;
+            }
+            tail_.store(position, std::memory_order_release);
+
+            uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped != reported_dropped_) {
+                char time[TIME_LENGTH];
+                formatCurrentTime(time);
+                appendLine(outputFor(Logger::WARNING), time, "WARNING",
+                           "日志队列已满，丢弃了 " + std::to_string(dropped - reported_dropped_) + " 条日志");
+                reported_dropped_ = dropped;
+            }
+            return count;
+        }
+
+        void write() {
+            if (file_ != nullptr) {
+                if (!file_buffer_.empty()) {
+                    std::fwrite(file_buffer_.data(), 1, file_buffer_.size(), file_);
+                    std::fflush(file_);
+                    file_buffer_.clear();
+                }
+                return;
+            }
+            if (!out_buffer_.empty()) {
+                std::cout.write(out_buffer_.data(), static_cast<std::streamsize>(out_buffer_.size())).flush();
+                out_buffer_.clear();
+            }
+            if (!log_buffer_.empty()) {
+                std::clog.write(log_buffer_.data(), static_cast<std::streamsize>(log_buffer_.size())).flush();
+                log_buffer_.clear();
+            }
+            if (!err_buffer_.empty()) {
+                std::cerr.write(err_buffer_.data(), static_cast<std::streamsize>(err_buffer_.size())).flush();
+                err_buffer_.clear();
+            }
+        }
+
+        void run() {
+            while (true) {
+                drain();
+                write();
+
+                std::unique_lock<std::mutex> lock(mutex_);
+                flushed_.notify_all();
+                if (stopping_ && head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                if (!flush_requested_ && !stopping_) {
+                    wake_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_));
+                }
+                flush_requested_ = false;
+            }
+        }
+
+        // 与同步输出相同：ERROR 写入 cerr，INFO 写入 clog，其余写入 cout
+        std::string &outputFor(Logger::LogLevel level) {
+            if (file_ != nullptr) {
+                return file_buffer_;
+            }
+            if (level == Logger::ERROR) {
+                return err_buffer_;
+            }
+            return level == Logger::INFO ? log_buffer_ : out_buffer_;
+        }
+
+        Logger::OverflowPolicy overflow_;
+        uint32_t flush_interval_ms_;
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t mask_;
+
+        // 生产者与消费者的位置分开放在不同的缓存行
+        char pad0_[64];
+        std::atomic<size_t> head_{0};
+        char pad1_[64];
+        std::atomic<size_t> tail_{0};
+        char pad2_[64];
+
+        std::atomic<uint64_t> dropped_{0};
+        uint64_t reported_dropped_{0};
+
+        std::FILE *file_{nullptr};
+        std::string file_buffer_;
+        std::string out_buffer_;
+        std::string log_buffer_;
+        std::string err_buffer_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable flushed_;
+        bool flush_requested_{false};
+        bool stopping_{false};
+
+        std::thread thread_;
+    };
+
+    // 当前的异步后端；日志调用期间 in_flight 计数，切换后端时等待计数归零再释放
+    std::atomic<AsyncBackend *> async_backend{nullptr};
+    std::atomic<int> in_flight{0};
+    std::mutex async_mutex;
+    uint64_t retired_dropped = 0;
+
+    AsyncBackend *detachBackend() {
+        AsyncBackend *backend = async_backend.exchange(nullptr);
+        while (in_flight.load() > 0) {
+            std::this_thread::yield();
+        }
+        return backend;
+    }
+}
+
 // 初始化静态成员
-Logger::LogLevel Logger::logLevel_ = Logger::INFO;
+std::atomic<Logger::LogLevel> Logger::logLevel_{Logger::INFO};
 std::mutex Logger::mutex_;
 
+namespace {
+    // 进程退出时写完异步队列中的日志
+    struct AsyncShutdown {
+        ~AsyncShutdown() {
+            Logger::disableAsync();
+        }
+    } async_shutdown;
+}
+
 
 // 设置全局日志级别
 void Logger::setLogLevel(LogLevel level) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    logLevel_ = level;
+    logLevel_.store(level, std::memory_order_relaxed);
 }
 
 // 获取级别
 Logger::LogLevel Logger::getLogLevel() {
-    return logLevel_;
+    return logLevel_.load(std::memory_order_relaxed);
 }
 
 void Logger::debug(const std::string &message) {
@@ -39,36 +323,83 @@ void Logger::error(const std::string &message) {
     log(ERROR, message);
 }
 
+void Logger::enableAsync() {
+    enableAsync(AsyncOptions());
+}
+
+void Logger::enableAsync(const AsyncOptions &options) {
+    std::lock_guard<std::mutex> lock(async_mutex);
+    std::unique_ptr<AsyncBackend> backend(new AsyncBackend(options));
+    std::unique_ptr<AsyncBackend> old(detachBackend());
+    if (old) {
+        retired_dropped += old->dropped();
+    }
+    async_backend.store(backend.release());
+}
+
+void Logger::disableAsync() {
+    std::lock_guard<std::mutex> lock(async_mutex);
+    std::unique_ptr<AsyncBackend> old(detachBackend());
+    if (old) {
+        retired_dropped += old->dropped();
+    }
+}
+
+bool Logger::isAsync() {
+    return async_backend.load() != nullptr;
+}
+
+void Logger::flush() {
+    std::lock_guard<std::mutex> lock(async_mutex);
+    AsyncBackend *backend = async_backend.load();
+    if (backend != nullptr) {
+        backend->flush();
+    }
+}
+
+uint64_t Logger::droppedCount() {
+    std::lock_guard<std::mutex> lock(async_mutex);
+    AsyncBackend *backend = async_backend.load();
+    return retired_dropped + (backend != nullptr ? backend->dropped() : 0);
+}
+
 // 日志输出
 void Logger::log(Logger::LogLevel level, const std::string &message) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::string timestamp = getCurrentTime();
-    if (level >= logLevel_) {
-        if (level == ERROR) {
-            std::cerr << timestamp << " [" << logLevelToString(level) << "] " << message << std::endl;
-        } else if (level == INFO) {
-            std::clog << timestamp << " [" << logLevelToString(level) << "] " << message << std::endl;
-        } else {
-            std::cout << timestamp << " [" << logLevelToString(level) << "] " << message << std::endl;
-        }
+    // 先判断级别，被过滤的日志不取时间、不加锁
+    if (level < logLevel_.load(std::memory_order_relaxed)) {
+        return;
     }
-}
 
-std::string Logger::getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto time_point = std::chrono::system_clock::to_time_t(now);
-    std::tm tm = *std::localtime(&time_point);
+    char time[TIME_LENGTH];
+    formatCurrentTime(time);
 
-    std::stringstream ss;
-    ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+    in_flight.fetch_add(1);
+    AsyncBackend *backend = async_backend.load();
+    if (backend != nullptr) {
+        backend->push(level, logLevelToString(level), time, message);
+        in_flight.fetch_sub(1);
+        return;
+    }
+    in_flight.fetch_sub(1);
 
-    // 获取毫秒
-    auto duration = now.time_since_epoch();
-    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() % 1000;
+    std::string line;
+    line.reserve(TIME_LENGTH + 12 + message.size());
+    appendLine(line, time, logLevelToString(level), message);
 
-    ss << '.' << std::setw(3) << std::setfill('0') << milliseconds; // 补齐毫秒为三位数
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (level == ERROR) {
+        std::cerr << line << std::flush;
+    } else if (level == INFO) {
+        std::clog << line << std::flush;
+    } else {
+        std::cout << line << std::flush;
+    }
+}
 
-    return ss.str();
+std::string Logger::getCurrentTime() {
+    char time[TIME_LENGTH];
+    formatCurrentTime(time);
+    return std::string(time, TIME_LENGTH);
 }
 
 const char *Logger::logLevelToString(Logger::LogLevel level) {
@@ -0,0 +1,527 @@
+/* epoll 多串口事件循环，见 serial/reactor.h */
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <future>
+
+#include "serial/reactor.h"
+#include "serial/recorder.h"
+
+using serial::Reactor;
+using serial::Recorder;
+using serial::Serial;
+using serial::IOException;
+using serial::PortNotOpenedException;
+
+namespace {
+    // 每次从端口读取的最大字节数，超过后继续读直到内核缓冲区为空
+    const size_t READ_CHUNK = 4096;
+
+    // 每次 epoll_wait 最多处理的事件数
+    const int MAX_EVENTS = 64;
+}
+
+Reactor::Reactor() : read_buffer_(READ_CHUNK) {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        THROW (IOException, errno);
+    }
+
+    // eventfd 用于从其他线程唤醒 epoll_wait
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        int error = errno;
+        ::close(epoll_fd_);
+        THROW (IOException, error);
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) < 0) {
+        int error = errno;
+        ::close(wake_fd_);
+        ::close(epoll_fd_);
+        THROW (IOException, error);
+    }
+}
+
+Reactor::~Reactor() {
+    stop();
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+}
+
+void
+Reactor::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+    quit_ = false;
+    {
+        // 在线程启动前标记为运行中，之后其他线程的操作都交给事件循环执行
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+    }
+    thread_ = std::thread(&Reactor::run, this);
+}
+
+void
+Reactor::run() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+        loop_thread_ = std::this_thread::get_id();
+    }
+
+    epoll_event events[MAX_EVENTS];
+    while (!quit_) {
+        runPendingTasks();
+
+        int n = ::epoll_wait(epoll_fd_, events, MAX_EVENTS, nextTimeout());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                uint64_t value;
+                ssize_t r = ::read(wake_fd_, &value, sizeof(value));
+                (void) r;
+                continue;
+            }
+
+            // 同一批事件中，前面的回调可能已经移除了这个端口
+            auto it = handlers_.find(fd);
+            if (it == handlers_.end()) {
+                continue;
+            }
+            std::shared_ptr<Handler> handler = it->second;
+            handleEvent(handler, events[i].events);
+        }
+
+        runTimers();
+    }
+
+    // 退出后其他线程的操作直接在调用方线程中执行，先执行完已提交的任务
+    std::vector<std::function<void()> > tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = false;
+        running_ = false;
+        loop_thread_ = std::thread::id();
+        tasks.swap(tasks_);
+    }
+    for (auto &task: tasks) {
+        task();
+    }
+}
+
+void
+Reactor::stop() {
+    quit_ = true;
+    wakeup();
+    if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+        thread_.join();
+    }
+}
+
+bool
+Reactor::running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+bool
+Reactor::inLoopThread() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_ && loop_thread_ == std::this_thread::get_id();
+}
+
+uint64_t
+Reactor::readTimestamp() const {
+    return read_timestamp_;
+}
+
+void
+Reactor::post(std::function<void()> task) {
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ && loop_thread_ != std::this_thread::get_id()) {
+            tasks_.push_back(std::move(task));
+            queued = true;
+        }
+    }
+
+    if (queued) {
+        wakeup();
+    } else {
+        task();
+    }
+}
+
+void
+Reactor::runAndWait(std::function<void()> task) {
+    std::promise<void> done;
+    std::future<void> result = done.get_future();
+    post([&task, &done] {
+        try {
+            task();
+            done.set_value();
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    });
+    // 事件循环中抛出的异常在调用方线程中重新抛出
+    result.get();
+}
+
+void
+Reactor::wakeup() {
+    uint64_t value = 1;
+    ssize_t r = ::write(wake_fd_, &value, sizeof(value));
+    (void) r;
+}
+
+void
+Reactor::runPendingTasks() {
+    std::vector<std::function<void()> > tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks.swap(tasks_);
+    }
+    for (auto &task: tasks) {
+        task();
+    }
+}
+
+void
+Reactor::add(const std::shared_ptr<Serial> &serial, ReadCallback on_read, ErrorCallback on_error) {
+    int fd = serial ? serial->getFd() : -1;
+    if (fd < 0) {
+        throw PortNotOpenedException("Reactor::add");
+    }
+
+    auto handler = std::make_shared<Handler>();
+    handler->fd = fd;
+    handler->serial = serial;
+    handler->on_read = std::move(on_read);
+    handler->on_error = std::move(on_error);
+    handler->events = EPOLLIN;
+
+    runAndWait([this, &handler] {
+        epoll_event event{};
+        event.events = handler->events;
+        event.data.fd = handler->fd;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, handler->fd, &event) < 0) {
+            THROW (IOException, errno);
+        }
+        handlers_[handler->fd] = handler;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        registered_.insert(handler->serial.get());
+    });
+}
+
+void
+Reactor::remove(const std::shared_ptr<Serial> &serial) {
+    runAndWait([this, &serial] {
+        std::shared_ptr<Handler> handler = findSerial(serial.get());
+        if (handler) {
+            removeHandler(handler);
+        }
+    });
+}
+
+bool
+Reactor::send(const std::shared_ptr<Serial> &serial, const uint8_t *data, size_t size) {
+    return send(serial, std::vector<uint8_t>(data, data + size));
+}
+
+bool
+Reactor::send(const std::shared_ptr<Serial> &serial, std::vector<uint8_t> data) {
+    const Serial *key = serial.get();
+    auto task = [this, key, data = std::move(data)]() mutable {
+        std::shared_ptr<Handler> handler = findSerial(key);
+        if (!handler || data.empty()) {
+            return;
+        }
+        handler->out_bytes += data.size();
+        handler->out.push_back(std::move(data));
+        // 写队列原本为空时立即尝试写入，大多数情况下不需要等待 EPOLLOUT
+        if (handler->out.size() == 1) {
+            flushWrites(handler);
+        }
+    };
+
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (registered_.count(key) == 0) {
+            return false;
+        }
+        if (running_ && loop_thread_ != std::this_thread::get_id()) {
+            tasks_.push_back(std::move(task));
+            queued = true;
+        }
+    }
+
+    if (queued) {
+        wakeup();
+    } else {
+        task();
+    }
+    return true;
+}
+
+size_t
+Reactor::pending(const std::shared_ptr<Serial> &serial) {
+    size_t bytes = 0;
+    runAndWait([this, &serial, &bytes] {
+        std::shared_ptr<Handler> handler = findSerial(serial.get());
+        if (handler) {
+            bytes = handler->out_bytes;
+        }
+    });
+    return bytes;
+}
+
+void
+Reactor::addFd(int fd, uint32_t events, EventCallback on_event) {
+    auto handler = std::make_shared<Handler>();
+    handler->fd = fd;
+    handler->on_event = std::move(on_event);
+    handler->events = events;
+
+    runAndWait([this, &handler] {
+        epoll_event event{};
+        event.events = handler->events;
+        event.data.fd = handler->fd;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, handler->fd, &event) < 0) {
+            THROW (IOException, errno);
+        }
+        handlers_[handler->fd] = handler;
+    });
+}
+
+void
+Reactor::removeFd(int fd) {
+    runAndWait([this, fd] {
+        auto it = handlers_.find(fd);
+        if (it != handlers_.end()) {
+            std::shared_ptr<Handler> handler = it->second;
+            removeHandler(handler);
+        }
+    });
+}
+
+Reactor::TimerId
+Reactor::addTimer(uint32_t delay_ms, TimerCallback callback, uint32_t interval_ms) {
+    TimerId id = next_timer_id_++;
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(delay_ms);
+    post([this, id, deadline, callback, interval_ms] {
+        timers_[id] = TimerEntry{callback, std::chrono::milliseconds(interval_ms)};
+        timer_queue_.push(Timer{deadline, id});
+    });
+    return id;
+}
+
+void
+Reactor::cancelTimer(TimerId id) {
+    // 已在队列中的触发时间在到期时跳过
+    post([this, id] {
+        timers_.erase(id);
+    });
+}
+
+int
+Reactor::nextTimeout() const {
+    if (timer_queue_.empty()) {
+        return -1;
+    }
+    auto remaining = timer_queue_.top().deadline - Clock::now();
+    if (remaining <= Clock::duration::zero()) {
+        return 0;
+    }
+    // 向上取整，避免提前醒来后空转
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(remaining).count();
+    return static_cast<int>((us + 999) / 1000);
+}
+
+void
+Reactor::runTimers() {
+    Clock::time_point now = Clock::now();
+    while (!timer_queue_.empty() && timer_queue_.top().deadline <= now) {
+        Timer timer = timer_queue_.top();
+        timer_queue_.pop();
+
+        auto it = timers_.find(timer.id);
+        if (it == timers_.end()) {
+            continue;
+        }
+
+        TimerCallback callback = it->second.callback;
+        if (it->second.interval.count() > 0) {
+            // 按固定周期触发，错过的周期不补发
+            Clock::time_point next = timer.deadline + it->second.interval;
+            if (next <= now) {
+                next = now + it->second.interval;
+            }
+            timer_queue_.push(Timer{next, timer.id});
+        } else {
+            timers_.erase(it);
+        }
+
+        if (callback) {
+            callback();
+        }
+    }
+}
+
+std::shared_ptr<Reactor::Handler>
+Reactor::findSerial(const Serial *serial) const {
+    for (const auto &entry: handlers_) {
+        if (entry.second->serial.get() == serial) {
+            return entry.second;
+        }
+    }
+    return nullptr;
+}
+
+void
+Reactor::handleEvent(const std::shared_ptr<Handler> &handler, uint32_t events) {
+    if (handler->on_event) {
+        handler->on_event(events);
+        return;
+    }
+
+    if (events & EPOLLIN) {
+        handleRead(handler);
+    }
+    if (!handler->removed && (events & EPOLLOUT)) {
+        flushWrites(handler);
+    }
+    // 挂断前的最后一批数据已在上面读出；VMIN = 0 时挂断后的 read 可能返回 0 而不是错误
+    if (!handler->removed && (events & (EPOLLERR | EPOLLHUP))) {
+        fail(handler, EIO);
+    }
+}
+
+void
+Reactor::handleRead(const std::shared_ptr<Handler> &handler) {
+    while (true) {
+        ssize_t n = ::read(handler->fd, read_buffer_.data(), read_buffer_.size());
+        if (n > 0) {
+            read_timestamp_ = monotonicNs();
+            if (handler->serial) {
+                std::shared_ptr<Recorder> recorder = handler->serial->getRecorder();
+                if (recorder) {
+                    recorder->record(Recorder::RX, read_buffer_.data(), static_cast<size_t>(n), read_timestamp_,
+                                     handler->serial->getRecorderChannel());
+                }
+            }
+            if (handler->on_read) {
+                handler->on_read(read_buffer_.data(), static_cast<size_t>(n));
+            }
+            // 回调中可能移除了端口；没有读满说明内核缓冲区已空
+            if (handler->removed || static_cast<size_t>(n) < read_buffer_.size()) {
+                return;
+            }
+        } else if (n == 0) {
+            return;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        } else {
+            fail(handler, errno);
+            return;
+        }
+    }
+}
+
+void
+Reactor::flushWrites(const std::shared_ptr<Handler> &handler) {
+    while (!handler->out.empty()) {
+        const std::vector<uint8_t> &front = handler->out.front();
+        ssize_t n = ::write(handler->fd, front.data() + handler->out_offset, front.size() - handler->out_offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 内核发送缓冲区已满，等端口可写时继续
+                updateEvents(handler, EPOLLIN | EPOLLOUT);
+                return;
+            }
+            fail(handler, errno);
+            return;
+        }
+
+        if (handler->serial && n > 0) {
+            std::shared_ptr<Recorder> recorder = handler->serial->getRecorder();
+            if (recorder) {
+                recorder->record(Recorder::TX, front.data() + handler->out_offset, static_cast<size_t>(n),
+                                 monotonicNs(), handler->serial->getRecorderChannel());
+            }
+        }
+        handler->out_offset += static_cast<size_t>(n);
+        handler->out_bytes -= static_cast<size_t>(n);
+        if (handler->out_offset == front.size()) {
+            handler->out.pop_front();
+            handler->out_offset = 0;
+        }
+    }
+    updateEvents(handler, EPOLLIN);
+}
+
+void
+Reactor::updateEvents(const std::shared_ptr<Handler> &handler, uint32_t events) {
+    if (handler->events == events) {
+        return;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = handler->fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, handler->fd, &event) == 0) {
+        handler->events = events;
+    }
+}
+
+void
+Reactor::fail(const std::shared_ptr<Handler> &handler, int error) {
+    ErrorCallback on_error = handler->on_error;
+    removeHandler(handler);
+    if (on_error) {
+        on_error(error);
+    }
+}
+
+void
+Reactor::removeHandler(const std::shared_ptr<Handler> &handler) {
+    if (handler->removed) {
+        return;
+    }
+    handler->removed = true;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, handler->fd, nullptr);
+    handlers_.erase(handler->fd);
+    handler->out.clear();
+    handler->out_bytes = 0;
+
+    if (handler->serial) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        registered_.erase(handler->serial.get());
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "serial/recorder.h"
+#include "serial/serial.h"
+
+using serial::Recorder;
+using serial::Recording;
+using serial::IOException;
+
+namespace {
+    const uint8_t MAGIC[4] = {'U', 'P', 'R', 'C'};
+
+    void putU16(uint8_t *p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value);
+        p[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void putU64(uint8_t *p, uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            p[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    uint16_t getU16(const uint8_t *p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint64_t getU64(const uint8_t *p) {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) {
+            value = (value << 8) | p[i];
+        }
+        return value;
+    }
+}
+
+const size_t Recorder::FILE_HEADER_SIZE;
+const size_t Recorder::RECORD_HEADER_SIZE;
+const uint16_t Recorder::FORMAT_VERSION;
+
+Recorder::Recorder(const std::string &path, size_t buffer_size, uint32_t flush_interval_ms)
+        : buffer_size_(buffer_size), flush_interval_ms_(flush_interval_ms) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        THROW (IOException, errno);
+    }
+
+    start_ns_ = monotonicNs();
+    uint8_t header[FILE_HEADER_SIZE] = {0};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    putU16(header + 4, FORMAT_VERSION);
+    putU64(header + 8, start_ns_);
+    std::fwrite(header, 1, sizeof(header), file_);
+
+    front_.reserve(buffer_size_ * 2);
+    back_.reserve(buffer_size_ * 2);
+    thread_ = std::thread(&Recorder::run, this);
+}
+
+Recorder::~Recorder() {
+    close();
+}
+
+void
+Recorder::record(Direction direction, const uint8_t *data, size_t size, uint64_t timestamp_ns, uint8_t channel) {
+    uint64_t offset = timestamp_ns > start_ns_ ? timestamp_ns - start_ns_ : 0;
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        do {
+            size_t length = std::min(size, static_cast<size_t>(0xFFFF));
+            size_t old_size = front_.size();
+            front_.resize(old_size + RECORD_HEADER_SIZE + length);
+            uint8_t *header = &front_[old_size];
+            putU64(header, offset);
+            putU16(header + 8, static_cast<uint16_t>(length));
+            header[10] = direction;
+            header[11] = channel;
+            if (length > 0) {
+                std::memcpy(header + RECORD_HEADER_SIZE, data, length);
+            }
+            appended_ += RECORD_HEADER_SIZE + length;
+            data += length;
+            size -= length;
+            ++records_;
+            bytes_ += length;
+        } while (size > 0);
+        wake = front_.size() >= buffer_size_;
+    }
+    if (wake) {
+        wake_.notify_one();
+    }
+}
+
+void
+Recorder::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = appended_;
+    if (written_ >= target) {
+        return;
+    }
+    flush_requested_ = true;
+    wake_.notify_one();
+    flushed_.wait(lock, [this, target] { return written_ >= target || file_ == nullptr; });
+}
+
+void
+Recorder::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void
+Recorder::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_), [this] {
+            return closed_ || front_.size() >= buffer_size_ || flush_requested_;
+        });
+        flush_requested_ = false;
+
+        // 交换前后台缓冲区，写文件时不持有锁，调用方可以继续追加
+        std::swap(front_, back_);
+        bool closing = closed_;
+        uint64_t target = appended_;
+        lock.unlock();
+
+        if (!back_.empty()) {
+            std::fwrite(back_.data(), 1, back_.size(), file_);
+            std::fflush(file_);
+            back_.clear();
+        }
+
+        lock.lock();
+        written_ = target;
+        flushed_.notify_all();
+        if (closing && front_.empty()) {
+            break;
+        }
+    }
+
+    std::fclose(file_);
+    file_ = nullptr;
+    flushed_.notify_all();
+}
+
+Recording
+Recording::fromFile(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        THROW (IOException, errno);
+    }
+
+    std::vector<uint8_t> content;
+    uint8_t chunk[64 * 1024];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        content.insert(content.end(), chunk, chunk + n);
+    }
+    std::fclose(file);
+
+    if (content.size() < Recorder::FILE_HEADER_SIZE || std::memcmp(content.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Invalid recording: bad magic");
+    }
+    if (getU16(&content[4]) != Recorder::FORMAT_VERSION) {
+        throw std::runtime_error("Invalid recording: unsupported format version " +
+                                 std::to_string(getU16(&content[4])));
+    }
+
+    Recording recording;
+    recording.start_ns_ = getU64(&content[8]);
+    size_t offset = Recorder::FILE_HEADER_SIZE;
+    while (offset + Recorder::RECORD_HEADER_SIZE <= content.size()) {
+        const uint8_t *header = &content[offset];
+        size_t length = getU16(header + 8);
+        if (offset + Recorder::RECORD_HEADER_SIZE + length > content.size()) {
+            break;
+        }
+        Record record;
+        record.time_ns = getU64(header);
+        record.direction = header[10] == Recorder::TX ? Recorder::TX : Recorder::RX;
+        record.channel = header[11];
+        record.data.assign(header + Recorder::RECORD_HEADER_SIZE, header + Recorder::RECORD_HEADER_SIZE + length);
+        recording.records_.push_back(std::move(record));
+        offset += Recorder::RECORD_HEADER_SIZE + length;
+    }
+    return recording;
+}
@@ -0,0 +1,167 @@
+/* 录制文件回放，见 serial/replay.h */
+
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#endif
+
+#include "serial/replay.h"
+#include "serial/serial.h"
+
+using serial::Replayer;
+using serial::Recording;
+using serial::IOException;
+
+Replayer::Replayer(Recording recording) : recording_(std::move(recording)) {
+}
+
+void
+Replayer::setSpeed(double speed) {
+    if (speed < 0) {
+        throw std::invalid_argument("Replay speed must not be negative");
+    }
+    speed_ = speed;
+}
+
+void
+Replayer::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    wake_.notify_all();
+}
+
+size_t
+Replayer::run(const Sink &sink) {
+    uint64_t start_ns = monotonicNs();
+    size_t count = 0;
+    for (const Recording::Record &record: recording_.records()) {
+        if (stopped_) {
+            break;
+        }
+        if (channel_ >= 0 && record.channel != channel_) {
+            continue;
+        }
+        if ((record.direction == Recorder::RX && !rx_) || (record.direction == Recorder::TX && !tx_)) {
+            continue;
+        }
+
+        uint64_t due_ns = start_ns;
+        if (speed_ > 0) {
+            due_ns += static_cast<uint64_t>(static_cast<double>(record.time_ns) / speed_);
+            uint64_t now_ns = monotonicNs();
+            if (due_ns > now_ns) {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(due_ns - now_ns);
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (wake_.wait_until(lock, deadline, [this] { return stopped_.load(); })) {
+                    break;
+                }
+            }
+        } else {
+            due_ns = monotonicNs();
+        }
+
+        sink(record, due_ns);
+        ++count;
+    }
+    // 停止请求只作用于这一次回放
+    stopped_ = false;
+    return count;
+}
+
+#if defined(__linux__)
+
+using serial::ReplayPort;
+
+ReplayPort::ReplayPort() {
+    master_fd_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd_ < 0 || ::grantpt(master_fd_) != 0 || ::unlockpt(master_fd_) != 0) {
+        int error = errno;
+        if (master_fd_ >= 0) {
+            ::close(master_fd_);
+        }
+        THROW (IOException, error);
+    }
+    port_ = ::ptsname(master_fd_);
+    ::fcntl(master_fd_, F_SETFL, ::fcntl(master_fd_, F_GETFL) | O_NONBLOCK);
+
+    // 原样传输，不做换行转换和回显
+    struct termios options;
+    if (::tcgetattr(master_fd_, &options) == 0) {
+        ::cfmakeraw(&options);
+        ::tcsetattr(master_fd_, TCSANOW, &options);
+    }
+}
+
+ReplayPort::~ReplayPort() {
+    stop();
+    ::close(master_fd_);
+}
+
+void
+ReplayPort::start(const std::shared_ptr<Replayer> &replayer) {
+    stop();
+    replayer_ = replayer;
+    finished_ = false;
+    thread_ = std::thread([this] {
+        replayer_->run([this](const Recording::Record &record, uint64_t) {
+            writeAll(record.data.data(), record.data.size());
+        });
+        finished_ = true;
+    });
+}
+
+void
+ReplayPort::wait() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void
+ReplayPort::stop() {
+    // 已结束的回放不再请求停止，否则同一个 Replayer 的下一次 run() 会立即返回
+    if (replayer_ && !finished_) {
+        replayer_->stop();
+    }
+    wait();
+    replayer_.reset();
+}
+
+void
+ReplayPort::writeAll(const uint8_t *data, size_t size) {
+    uint8_t discard[256];
+    // 没有读取方时伪终端写满，停止回放后不再等待
+    while (size > 0 && !replayer_->stopped()) {
+        struct pollfd pfd = {master_fd_, POLLIN | POLLOUT, 0};
+        if (::poll(&pfd, 1, 100) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (pfd.revents & POLLIN) {
+            // 丢弃串口一侧写入的数据
+            while (::read(master_fd_, discard, sizeof(discard)) > 0) {}
+        }
+        if (pfd.revents & POLLOUT) {
+            ssize_t n = ::write(master_fd_, data, size);
+            if (n > 0) {
+                data += n;
+                size -= static_cast<size_t>(n);
+            } else if (n < 0 && errno != EINTR && errno != EAGAIN) {
+                return; // 串口一侧已关闭
+            }
+        }
+    }
+}
+
+#endif
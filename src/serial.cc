@@ -12,6 +12,7 @@
 #endif
 
 #include "serial/serial.h"
+#include "serial/recorder.h"
 
 #ifdef _WIN32
 #include "serial/impl/win.h"
@@ -36,6 +37,7 @@ using serial::bytesize_t;
 using serial::parity_t;
 using serial::stopbits_t;
 using serial::flowcontrol_t;
+using serial::LowLatencyInfo;
 
 class Serial::ScopedReadLock {
 public:
@@ -79,7 +81,9 @@ Serial::Serial(const string &port, uint32_t baudrate, serial::Timeout timeout,
                bytesize_t bytesize, parity_t parity, stopbits_t stopbits,
                flowcontrol_t flowcontrol)
         : pimpl_(new SerialImpl(port, baudrate, bytesize, parity,
-                                stopbits, flowcontrol)) {
+                                stopbits, flowcontrol)), read_pos_(0), buffered_(0),
+          read_appended_(0), read_consumed_(0), read_timestamp_(0), write_timestamp_(0),
+          recorder_channel_(0) {
     pimpl_->setTimeout(timeout);
 }
 
@@ -90,6 +94,13 @@ Serial::~Serial() {
 void
 Serial::open() {
     pimpl_->open();
+    // 丢弃上一次打开时未取走的数据
+    ScopedReadLock lock(this->pimpl_);
+    read_buffer_.clear();
+    read_pos_ = 0;
+    buffered_ = 0;
+    read_chunks_.clear();
+    read_appended_ = read_consumed_ = 0;
 }
 
 void
@@ -104,11 +115,14 @@ Serial::isOpen() const {
 
 size_t
 Serial::available() {
-    return pimpl_->available();
+    return buffered_ + pimpl_->available();
 }
 
 bool
 Serial::waitReadable() {
+    if (buffered_ > 0) {
+        return true;
+    }
     serial::Timeout timeout(pimpl_->getTimeout());
     return pimpl_->waitReadable(timeout.read_timeout_constant);
 }
@@ -118,51 +132,153 @@ Serial::waitByteTimes(size_t count) {
     pimpl_->waitByteTimes(count);
 }
 
+uint64_t
+Serial::getReadTimestamp() const {
+    return read_timestamp_;
+}
+
+uint64_t
+Serial::getWriteTimestamp() const {
+    return write_timestamp_;
+}
+
 size_t
 Serial::read_(uint8_t *buffer, size_t size) {
-    return this->pimpl_->read(buffer, size);
+    // 先取读缓冲区中的数据，不够时再从串口读取剩余部分
+    size_t bytes_read = std::min(size, static_cast<size_t>(buffered_));
+    if (bytes_read > 0) {
+        memcpy(buffer, &read_buffer_[read_pos_], bytes_read);
+        consumeReadBuffer_(bytes_read);
+    }
+    if (bytes_read < size) {
+        size_t bytes_read_now = this->pimpl_->read(buffer + bytes_read, size - bytes_read);
+        if (bytes_read_now > 0) {
+            read_timestamp_ = monotonicNs();
+            record_(false, buffer + bytes_read, bytes_read_now, read_timestamp_);
+        }
+        bytes_read += bytes_read_now;
+    }
+    return bytes_read;
+}
+
+size_t
+Serial::fillReadBuffer_() {
+    if (read_pos_ > 0) {
+        read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + read_pos_);
+        read_pos_ = 0;
+    }
+
+    size_t filled = 0;
+    size_t bytes_available = pimpl_->available();
+    if (bytes_available == 0) {
+        // 没有已到达的数据，按 read(1) 的超时等待第一个字节
+        bytes_available = 1;
+    }
+    while (bytes_available > 0) {
+        size_t old_size = read_buffer_.size();
+        read_buffer_.resize(old_size + bytes_available);
+        size_t bytes_read = 0;
+        try {
+            bytes_read = pimpl_->read(&read_buffer_[old_size], bytes_available);
+        } catch (...) {
+            read_buffer_.resize(old_size);
+            throw;
+        }
+        read_buffer_.resize(old_size + bytes_read);
+        filled += bytes_read;
+        if (bytes_read == 0) {
+            break;
+        }
+        uint64_t now = monotonicNs();
+        read_appended_ += bytes_read;
+        read_chunks_.push_back(std::make_pair(read_appended_, now));
+        record_(false, &read_buffer_[old_size], bytes_read, now);
+        // 等待期间到达的数据一并取走
+        bytes_available = filled == 1 ? pimpl_->available() : 0;
+    }
+    buffered_ = read_buffer_.size() - read_pos_;
+    return filled;
+}
+
+void
+Serial::consumeReadBuffer_(size_t size) {
+    // 取出的最后一个字节所在数据块的读出时间
+    read_consumed_ += size;
+    while (!read_chunks_.empty() && read_chunks_.front().first < read_consumed_) {
+        read_chunks_.pop_front();
+    }
+    if (!read_chunks_.empty()) {
+        read_timestamp_ = read_chunks_.front().second;
+        if (read_chunks_.front().first == read_consumed_) {
+            read_chunks_.pop_front();
+        }
+    }
+
+    read_pos_ += size;
+    if (read_pos_ == read_buffer_.size()) {
+        read_buffer_.clear();
+        read_pos_ = 0;
+    }
+    buffered_ = read_buffer_.size() - read_pos_;
+}
+
+size_t
+Serial::frame_(size_t size, const std::function<size_t(const uint8_t *, size_t)> &complete) {
+    while (true) {
+        size_t buffered = read_buffer_.size() - read_pos_;
+        size_t length = std::min(buffered, size);
+        if (length > 0) {
+            size_t frame = complete(&read_buffer_[read_pos_], length);
+            if (frame > 0) {
+                return std::min(frame, length);
+            }
+        }
+        if (buffered >= size) {
+            return size; // Reached the maximum read length
+        }
+        if (fillReadBuffer_() == 0) {
+            return length; // Timeout
+        }
+    }
 }
 
 size_t
 Serial::read(uint8_t *buffer, size_t size) {
     ScopedReadLock lock(this->pimpl_);
-    return this->pimpl_->read(buffer, size);
+    return this->read_(buffer, size);
 }
 
 size_t
 Serial::read(std::vector<uint8_t> &buffer, size_t size) {
     ScopedReadLock lock(this->pimpl_);
-    uint8_t *buffer_ = new uint8_t[size];
+    size_t old_size = buffer.size();
+    buffer.resize(old_size + size);
     size_t bytes_read = 0;
-
     try {
-        bytes_read = this->pimpl_->read(buffer_, size);
+        bytes_read = this->read_(buffer.data() + old_size, size);
     }
     catch (const std::exception &e) {
-        delete[] buffer_;
+        buffer.resize(old_size);
         throw;
     }
-
-    buffer.insert(buffer.end(), buffer_, buffer_ + bytes_read);
-    delete[] buffer_;
-
+    buffer.resize(old_size + bytes_read);
     return bytes_read;
 }
 
 size_t
 Serial::read(std::string &buffer, size_t size) {
     ScopedReadLock lock(this->pimpl_);
-    uint8_t *buffer_ = new uint8_t[size];
+    size_t old_size = buffer.size();
+    buffer.resize(old_size + size);
     size_t bytes_read = 0;
     try {
-        bytes_read = this->pimpl_->read(buffer_, size);
+        bytes_read = this->read_(reinterpret_cast<uint8_t *>(&buffer[old_size]), size);
     }
     catch (const std::exception &e) {
-        delete[] buffer_;
+        buffer.resize(old_size);
         throw;
     }
-    buffer.append(reinterpret_cast<const char *>(buffer_), bytes_read);
-    delete[] buffer_;
+    buffer.resize(old_size + bytes_read);
     return bytes_read;
 }
 
@@ -174,29 +290,63 @@ Serial::read(size_t size) {
 }
 
 size_t
-Serial::readline(string &buffer, size_t size, string eol) {
+Serial::readUntil(std::string &buffer, const std::string &delimiter, size_t size) {
     ScopedReadLock lock(this->pimpl_);
-    size_t eol_len = eol.length();
-    uint8_t *buffer_ = static_cast<uint8_t *>
-    (alloca (size * sizeof(uint8_t)));
-    size_t read_so_far = 0;
-    while (true) {
-        size_t bytes_read = this->read_(buffer_ + read_so_far, 1);
-        read_so_far += bytes_read;
-        if (bytes_read == 0) {
-            break; // Timeout occured on reading 1 byte
-        }
-        if (read_so_far < eol_len) continue;
-        if (string(reinterpret_cast<const char *>
-                   (buffer_ + read_so_far - eol_len), eol_len) == eol) {
-            break; // EOL found
+    const size_t delimiter_len = delimiter.length();
+    const uint8_t *pattern = reinterpret_cast<const uint8_t *>(delimiter.data());
+
+    // 已查找过的长度，新数据到达后只查找新增部分（加上可能跨越边界的分隔符前缀）
+    size_t scanned = 0;
+    size_t length = frame_(size, [&](const uint8_t *data, size_t available) -> size_t {
+        if (delimiter_len == 0) {
+            return 1;
         }
-        if (read_so_far == size) {
-            break; // Reached the maximum read length
+        size_t from = scanned + 1 > delimiter_len ? scanned + 1 - delimiter_len : 0;
+        scanned = available;
+        while (from + delimiter_len <= available) {
+            const uint8_t *found = static_cast<const uint8_t *>(
+                    memchr(data + from, pattern[0], available - from - delimiter_len + 1));
+            if (found == NULL) {
+                break;
+            }
+            size_t offset = static_cast<size_t>(found - data);
+            if (memcmp(found, pattern, delimiter_len) == 0) {
+                return offset + delimiter_len; // EOL found
+            }
+            from = offset + 1;
         }
+        return 0;
+    });
+
+    if (length > 0) {
+        buffer.append(reinterpret_cast<const char *>(&read_buffer_[read_pos_]), length);
+        consumeReadBuffer_(length);
     }
-    buffer.append(reinterpret_cast<const char *> (buffer_), read_so_far);
-    return read_so_far;
+    return length;
+}
+
+string
+Serial::readUntil(const std::string &delimiter, size_t size) {
+    std::string buffer;
+    this->readUntil(buffer, delimiter, size);
+    return buffer;
+}
+
+size_t
+Serial::readUntil(std::vector<uint8_t> &buffer, const std::function<size_t(const uint8_t *, size_t)> &complete,
+                  size_t size) {
+    ScopedReadLock lock(this->pimpl_);
+    size_t length = frame_(size, complete);
+    if (length > 0) {
+        buffer.insert(buffer.end(), read_buffer_.begin() + read_pos_, read_buffer_.begin() + read_pos_ + length);
+        consumeReadBuffer_(length);
+    }
+    return length;
+}
+
+size_t
+Serial::readline(string &buffer, size_t size, string eol) {
+    return this->readUntil(buffer, eol, size);
 }
 
 string
@@ -208,40 +358,20 @@ Serial::readline(size_t size, string eol) {
 
 vector<string>
 Serial::readlines(size_t size, string eol) {
-    ScopedReadLock lock(this->pimpl_);
     std::vector<std::string> lines;
-    size_t eol_len = eol.length();
-    uint8_t *buffer_ = static_cast<uint8_t *>
-    (alloca (size * sizeof(uint8_t)));
     size_t read_so_far = 0;
-    size_t start_of_line = 0;
     while (read_so_far < size) {
-        size_t bytes_read = this->read_(buffer_ + read_so_far, 1);
-        read_so_far += bytes_read;
+        std::string line;
+        size_t bytes_read = this->readUntil(line, eol, size - read_so_far);
         if (bytes_read == 0) {
-            if (start_of_line != read_so_far) {
-                lines.push_back(
-                        string(reinterpret_cast<const char *> (buffer_ + start_of_line),
-                               read_so_far - start_of_line));
-            }
-            break; // Timeout occured on reading 1 byte
-        }
-        if (read_so_far < eol_len) continue;
-        if (string(reinterpret_cast<const char *>
-                   (buffer_ + read_so_far - eol_len), eol_len) == eol) {
-            // EOL found
-            lines.push_back(
-                    string(reinterpret_cast<const char *> (buffer_ + start_of_line),
-                           read_so_far - start_of_line));
-            start_of_line = read_so_far;
+            break; // Timeout
         }
-        if (read_so_far == size) {
-            if (start_of_line != read_so_far) {
-                lines.push_back(
-                        string(reinterpret_cast<const char *> (buffer_ + start_of_line),
-                               read_so_far - start_of_line));
-            }
-            break; // Reached the maximum read length
+        read_so_far += bytes_read;
+        bool eol_found = line.size() >= eol.size() &&
+                         line.compare(line.size() - eol.size(), eol.size(), eol) == 0;
+        lines.push_back(std::move(line));
+        if (!eol_found) {
+            break; // Timeout or reached the maximum read length
         }
     }
     return lines;
@@ -266,9 +396,53 @@ Serial::write(const uint8_t *data, size_t size) {
     return this->write_(data, size);
 }
 
+size_t
+Serial::writeBatch(const std::vector<std::vector<uint8_t> > &frames) {
+    ScopedWriteLock lock(this->pimpl_);
+    size_t bytes_written = pimpl_->writeBatch(frames);
+    write_timestamp_ = monotonicNs();
+    // 每帧一条记录，回放时保留帧边界
+    for (size_t i = 0, offset = 0; i < frames.size() && offset < bytes_written; ++i) {
+        size_t length = std::min(frames[i].size(), bytes_written - offset);
+        record_(true, frames[i].data(), length, write_timestamp_);
+        offset += length;
+    }
+    return bytes_written;
+}
+
 size_t
 Serial::write_(const uint8_t *data, size_t length) {
-    return pimpl_->write(data, length);
+    size_t bytes_written = pimpl_->write(data, length);
+    write_timestamp_ = monotonicNs();
+    record_(true, data, bytes_written, write_timestamp_);
+    return bytes_written;
+}
+
+void
+Serial::setRecorder(const std::shared_ptr<Recorder> &recorder, uint8_t channel) {
+    recorder_channel_ = channel;
+    std::atomic_store(&recorder_, recorder);
+}
+
+std::shared_ptr<serial::Recorder>
+Serial::getRecorder() const {
+    return std::atomic_load(&recorder_);
+}
+
+uint8_t
+Serial::getRecorderChannel() const {
+    return recorder_channel_;
+}
+
+void
+Serial::record_(bool tx, const uint8_t *data, size_t size, uint64_t timestamp_ns) {
+    if (size == 0) {
+        return;
+    }
+    std::shared_ptr<Recorder> recorder = std::atomic_load(&recorder_);
+    if (recorder) {
+        recorder->record(tx ? Recorder::TX : Recorder::RX, data, size, timestamp_ns, recorder_channel_);
+    }
 }
 
 void
@@ -286,6 +460,27 @@ Serial::getPort() const {
     return pimpl_->getPort();
 }
 
+LowLatencyInfo
+Serial::setLowLatency(bool enabled) {
+    ScopedReadLock rlock(this->pimpl_);
+    ScopedWriteLock wlock(this->pimpl_);
+    return pimpl_->setLowLatency(enabled);
+}
+
+LowLatencyInfo
+Serial::getLowLatency() const {
+    return pimpl_->getLowLatency();
+}
+
+#if !defined(_WIN32)
+
+int
+Serial::getFd() const {
+    return pimpl_->getFd();
+}
+
+#endif
+
 void
 Serial::setTimeout(serial::Timeout &timeout) {
     pimpl_->setTimeout(timeout);
@@ -350,10 +545,17 @@ void Serial::flush() {
     ScopedReadLock rlock(this->pimpl_);
     ScopedWriteLock wlock(this->pimpl_);
     pimpl_->flush();
+    // 数据已发送完毕
+    write_timestamp_ = monotonicNs();
 }
 
 void Serial::flushInput() {
     ScopedReadLock lock(this->pimpl_);
+    read_buffer_.clear();
+    read_pos_ = 0;
+    buffered_ = 0;
+    read_chunks_.clear();
+    read_appended_ = read_consumed_ = 0;
     pimpl_->flushInput();
 }
 
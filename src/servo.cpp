@@ -5,6 +5,7 @@
 #include "servo.h"
 #include "logger.h"
 #include "servo_protocol_parse.h"
+#include "trace.h"
 #include <iostream>
 
 #ifdef __linux__
@@ -14,8 +15,14 @@
 #endif
 
 #include <algorithm>
+#include <cstring>
 #include <iomanip>
 
+namespace {
+    // sendWaitCommand 等待应答的最长时间，同时写入超时跟踪记录
+    const uint32_t WAIT_RESPONSE_TIMEOUT_MS = 5000;
+}
+
 //Servo::Servo(const gpio::GPIO &gpio, bool gpio_enabled,
 //             const std::string &port,
 //             uint32_t baudrate,
@@ -51,6 +58,29 @@ void Servo::init() {
     receive_thread.detach();
 }
 
+#ifdef __linux__
+
+/**
+ * @brief 初始化舵机，由事件循环接收数据
+ */
+void Servo::init(const std::shared_ptr<serial::Reactor> &reactor) {
+    if (gpio != nullptr)
+        gpio->init();
+
+    if (!serial->isOpen())
+        serial->open();
+
+    this->reactor = reactor;
+    serial::Reactor *loop = reactor.get();
+    reactor->add(serial, [this, loop](const uint8_t *data, size_t size) {
+        handleReceivedData(data, size, loop->readTimestamp());
+    }, [](int error) {
+        Logger::error("❌ 串口读写出错，已移出事件循环：" + std::string(strerror(error)));
+    });
+}
+
+#endif
+
 /**
  * @brief 关闭舵机
  */
@@ -59,6 +89,14 @@ void Servo::close() {
     if (receive_thread.joinable())
         receive_thread.join();
 
+#ifdef __linux__
+    // 返回后事件循环不会再调用 handleReceivedData
+    if (reactor != nullptr) {
+        reactor->remove(serial);
+        reactor.reset();
+    }
+#endif
+
     if (serial->isOpen())
         serial->close();
 
@@ -92,6 +130,10 @@ void Servo::disableBus() {
  * @brief 发送命令给舵机
  */
 bool Servo::sendCommand(const std::vector<uint8_t> &frame) {
+    return sendCommand(frame.data(), frame.size());
+}
+
+bool Servo::sendCommand(const uint8_t *frame, size_t size) {
     if (!serial->isOpen()) {
         Logger::error("❌ 串口未打开，无法发送数据！");
         return false;
@@ -101,19 +143,75 @@ bool Servo::sendCommand(const std::vector<uint8_t> &frame) {
     serial->flushInput();
 
     // ✅ 传递正确的参数给 `write()`
-    size_t bytes_written = serial->write(frame.data(), frame.size());
+    size_t bytes_written = serial->write(frame, size);
+    last_tx_ns = serial->getWriteTimestamp();
     disableBus();
+    UP_TRACE_FRAME(trace::FRAME_TX, frame, bytes_written, 0, last_tx_ns);
 
-    if (bytes_written != frame.size()) {
+    if (bytes_written != size) {
         Logger::error("sendCommand: Failed to write full frame. Expected: "
-                      + std::to_string(frame.size()) + ", Written: " + std::to_string(bytes_written));
+                      + std::to_string(size) + ", Written: " + std::to_string(bytes_written));
+        return false;
+    }
+
+#ifdef __linux__
+    // 由事件循环接收时，应答通过回调送达，这里不能再等待端口可读
+    if (reactor != nullptr)
+        return true;
+#endif
+
+    return serial->waitReadable();
+}
+
+/**
+ * @brief 批量发送命令给舵机
+ */
+bool Servo::sendCommands(const std::vector<std::vector<uint8_t> > &frames) {
+    if (!serial->isOpen()) {
+        Logger::error("❌ 串口未打开，无法发送数据！");
+        return false;
+    }
+
+    size_t total = 0;
+    for (const auto &frame: frames) {
+        total += frame.size();
+    }
+
+    // 与 sendWaitCommand 互斥，保证整批命令在同一个总线使能窗口内发出
+    std::lock_guard<std::mutex> lock(send_mutex);
+
+    enableBus();
+    serial->flushInput();
+    size_t bytes_written = serial->writeBatch(frames);
+    last_tx_ns = serial->getWriteTimestamp();
+    disableBus();
+    if (trace::enabled()) {
+        for (const auto &frame: frames) {
+            trace::emitFrame(trace::FRAME_TX, frame.data(), frame.size(), 0, last_tx_ns);
+        }
+    }
+
+    if (bytes_written != total) {
+        Logger::error("sendCommands: Failed to write all frames. Expected: "
+                      + std::to_string(total) + ", Written: " + std::to_string(bytes_written));
         return false;
     }
 
+#ifdef __linux__
+    if (reactor != nullptr)
+        return true;
+#endif
+
     return serial->waitReadable();
 }
 
 bool Servo::sendWaitCommand(const std::vector<uint8_t> &frame, std::vector<uint8_t> &response_data) {
+    FrameTimestamp timestamp;
+    return sendWaitCommand(frame, response_data, timestamp);
+}
+
+bool Servo::sendWaitCommand(const std::vector<uint8_t> &frame, std::vector<uint8_t> &response_data,
+                            FrameTimestamp &timestamp) {
     if (!serial->isOpen()) {
         Logger::error("❌ 串口未打开，无法发送数据！");
         return false;
@@ -135,12 +233,16 @@ bool Servo::sendWaitCommand(const std::vector<uint8_t> &frame, std::vector<uint8
     auto cv = std::make_unique<std::condition_variable>();
     message_conditions_[message_id] = std::move(cv);
 
+    UP_TRACE(trace::TRANSACTION_BEGIN, frame.size() > 2 ? frame[2] : 0, 0, message_id);
+
     enableBus();
     serial->flushInput();
 
     // ✅ 传递正确的参数给 `write()`
     size_t bytes_written = serial->write(frame_with_id.data(), frame_with_id.size());
+    last_tx_ns = serial->getWriteTimestamp();
     disableBus();
+    UP_TRACE_FRAME(trace::FRAME_TX, frame_with_id.data(), bytes_written, message_id, last_tx_ns);
 
     if (bytes_written != frame_with_id.size()) {
         Logger::error("sendCommand: Failed to write full frame. Expected: "
@@ -148,8 +250,8 @@ bool Servo::sendWaitCommand(const std::vector<uint8_t> &frame, std::vector<uint8
         return false;
     }
 
-    // 设置最大等待时间为 500 毫秒
-    auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(5000);
+    // 设置最大等待时间
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(WAIT_RESPONSE_TIMEOUT_MS);
 
     // 使用 wait_for，等待指定时间或条件变量被通知
     if (message_conditions_[message_id]->wait_until(wait_lock, timeout, [this, message_id] {
@@ -159,19 +261,24 @@ bool Servo::sendWaitCommand(const std::vector<uint8_t> &frame, std::vector<uint8
         // 取出对应的响应数据
         auto data = received_data_[message_id];
         received_data_.erase(message_id); // 删除已处理的响应
+        timestamp = received_times_[message_id];
+        received_times_.erase(message_id);
 
         message_conditions_.erase(message_id); // 删除对应的条件变量
 
 
         // 将数据传递到外部传递的 response_data
         response_data = data;
+        UP_TRACE(trace::TRANSACTION_END, data.size() > 2 ? data[2] : 0, data.size() > 4 ? data[4] : 0, message_id,
+                 static_cast<uint32_t>(data.size()));
 
-        Logger::info("发送命令后收到数据：" + bytesToHex(data));
+        UP_LOG_INFO("发送命令后收到数据：" + bytesToHex(data));
 
         return true;
     } else {
         // 超时，返回失败
         Logger::error("sendWaitCommand: Timeout waiting for response.");
+        UP_TRACE(trace::TIMEOUT, frame.size() > 2 ? frame[2] : 0, 0, message_id, WAIT_RESPONSE_TIMEOUT_MS);
         // 清理数据和条件变量
         message_conditions_.erase(message_id);
         return false; // 超时
@@ -183,8 +290,6 @@ bool Servo::performSerialData(const std::vector<uint8_t> &packet) {
 }
 
 void Servo::processSerialData() {
-    std::vector<uint8_t> buffer;
-
     while (running) {
         if (!serial->isOpen()) {
             Logger::error("❌ 串口未打开，无法读取数据！");
@@ -195,12 +300,12 @@ void Servo::processSerialData() {
         // 读取数据
         size_t available_bytes = serial->available();
         if (available_bytes == 0) {
-            Logger::debug("❌ 串口未读取到数据！");
+            UP_LOG_DEBUG("❌ 串口未读取到数据！");
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
             continue;
         }
 
-        Logger::debug("📌 串口已打开，尝试读取 " + std::to_string(available_bytes) + " 字节数据");
+        UP_LOG_DEBUG("📌 串口已打开，尝试读取 " + std::to_string(available_bytes) + " 字节数据");
 
         std::vector<uint8_t> temp_buffer;
         size_t bytes_read = serial->read(temp_buffer, available_bytes);
@@ -211,62 +316,95 @@ void Servo::processSerialData() {
             continue;
         }
 
-        buffer.insert(buffer.end(), temp_buffer.begin(), temp_buffer.end());
-
-        Logger::debug("接收到的数据 " + bytesToHex(buffer));
-
-        if (buffer.size() < 6) {
-            Logger::debug("❌ 数据包长度不足，丢弃数据");
-            buffer.clear();
+        if (!handleReceivedData(temp_buffer.data(), temp_buffer.size(), serial->getReadTimestamp())) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
             continue;
         }
 
-        // 解析数据包
-        static const std::vector<uint8_t> start_flag = {0xFF, 0xFF}; // 预定义搜索模式
+        // 避免 CPU 过载
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    UP_LOG_DEBUG("❌ 串口监听线程已停止！");
+}
 
-        auto it = std::search(buffer.begin(), buffer.end(), start_flag.begin(), start_flag.end());
+bool Servo::inject(const uint8_t *data, size_t size, uint64_t rx_ns) {
+    return handleReceivedData(data, size, rx_ns != 0 ? rx_ns : serial::monotonicNs());
+}
 
-        if (it == buffer.end()) {
-            //            Logger::debug("❌ 未找到数据包起始标志，丢弃数据");
-            buffer.clear();
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
-        }
+bool Servo::handleReceivedData(const uint8_t *data, size_t size, uint64_t rx_ns) {
+    std::vector<uint8_t> &buffer = receive_buffer;
+    buffer.insert(buffer.end(), data, data + size);
 
-        size_t start_index = std::distance(buffer.begin(), it);
-        Logger::debug("✅ 找到起始标志，位置：" + std::to_string(start_index));
+    UP_LOG_DEBUG("接收到的数据 " + bytesToHex(buffer));
 
-        std::vector<uint8_t> packet;
-        // 复制从 FF FF 开始的数据到 packet
-        packet.assign(it, buffer.end());
+    // 解析数据包
+    static const std::vector<uint8_t> start_flag = {0xFF, 0xFF}; // 预定义搜索模式
 
-        // 清空缓冲区，因为数据已经复制到 packet
-        buffer.clear();
+    // 一次读取可能只有半帧，也可能包含多帧：按长度字节切出完整的帧，不完整的尾部留到下次读取
+    bool parsed = false;
+    while (true) {
+        auto it = std::search(buffer.begin(), buffer.end(), start_flag.begin(), start_flag.end());
+        if (it == buffer.end()) {
+            // 末尾的 0xFF 可能是下一帧起始标志的第一个字节
+            bool keep_last = !buffer.empty() && buffer.back() == 0xFF;
+            buffer.erase(buffer.begin(), keep_last ? buffer.end() - 1 : buffer.end());
+            break;
+        }
+        buffer.erase(buffer.begin(), it);
 
-        //        Logger::debug("起始数据 " + bytesToHex(packet));
+        // FF FF ID LEN ...：读到长度字节才能知道帧长
+        if (buffer.size() < 4) {
+            break;
+        }
+        // ID 不会是 0xFF（连续的 FF 中起始标志从后一个开始），长度至少包含错误字节和校验和
+        if (buffer[2] == 0xFF || buffer[3] < 2) {
+            UP_LOG_DEBUG("❌ 数据包头无效，跳过一个字节");
+            buffer.erase(buffer.begin());
+            continue;
+        }
 
-        // 假设数据帧最后两个字节是消息 ID
-        //        uint32_t received_message_id = static_cast<uint32_t>(packet[packet.size() - 1]) |
-        //                                       (static_cast<uint32_t>(packet[packet.size() - 2]) << 8);
-        uint32_t received_message_id = message_counter;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
+        size_t frame_size = static_cast<size_t>(buffer[3]) + 4;
+        if (buffer.size() < frame_size) {
+            break;
+        }
 
-            // 将接收到的数据存入 map，使用消息 ID 作为键
-            received_data_[received_message_id] = packet;
+        std::vector<uint8_t> packet(buffer.begin(), buffer.begin() + frame_size);
+        buffer.erase(buffer.begin(), buffer.begin() + frame_size);
+        dispatchPacket(packet, rx_ns);
+        parsed = true;
+    }
+    return parsed;
+}
 
-            // 通知对应的线程，数据已经接收完毕
-            if (message_conditions_.count(received_message_id)) {
-                message_conditions_[received_message_id]->notify_one();
-            }
+void Servo::dispatchPacket(const std::vector<uint8_t> &packet, uint64_t rx_ns) {
+    //        Logger::debug("起始数据 " + bytesToHex(packet));
+
+    // 假设数据帧最后两个字节是消息 ID
+    //        uint32_t received_message_id = static_cast<uint32_t>(packet[packet.size() - 1]) |
+    //                                       (static_cast<uint32_t>(packet[packet.size() - 2]) << 8);
+    uint32_t received_message_id = message_counter;
+    FrameTimestamp timestamp;
+    timestamp.rx_ns = rx_ns;
+    timestamp.tx_ns = last_tx_ns;
+    if (trace::enabled()) {
+        trace::emitFrame(trace::FRAME_RX, packet.data(), packet.size(), received_message_id, rx_ns);
+        if (packet.size() > 4 && packet[4] != 0) {
+            trace::emit(trace::ERROR, packet[2], packet[4], received_message_id, 0, 0, rx_ns);
         }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
 
-        processDataPacket(packet);
+        // 将接收到的数据存入 map，使用消息 ID 作为键
+        received_data_[received_message_id] = packet;
+        received_times_[received_message_id] = timestamp;
 
-        // 避免 CPU 过载
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        // 通知对应的线程，数据已经接收完毕
+        if (message_conditions_.count(received_message_id)) {
+            message_conditions_[received_message_id]->notify_one();
+        }
     }
 
-    Logger::debug("❌ 串口监听线程已停止！");
+    processDataPacket(packet, timestamp);
 }
@@ -43,7 +43,7 @@ bool previewSerialData(const std::vector<uint8_t> &packet) {
     // 解析应答包
     // 检查数据包长度是否足够
     if (packet.size() < 6) {
-        Logger::debug("❌ 数据包长度不足，丢弃数据");
+        UP_LOG_DEBUG("❌ 数据包长度不足，丢弃数据");
         return false;
     }
 
@@ -56,7 +56,7 @@ bool previewSerialData(const std::vector<uint8_t> &packet) {
 
     // 校验失败，丢弃数据包
     if (checksum != packet.back()) {
-        Logger::debug("❌ 校验失败，丢弃数据包");
+        UP_LOG_DEBUG("❌ 校验失败，丢弃数据包");
         return false;
     }
 
@@ -71,7 +71,7 @@ bool previewSerialData(const std::vector<uint8_t> &packet) {
                         + " (" + errorInfo.description + ")");
     }
 
-    Logger::info("✅ 接收到数据包: " + bytesToHex(payload));
+    UP_LOG_INFO("✅ 接收到数据包: " + bytesToHex(payload));
 
     // 这里可以回调处理接收到的数据，例如存储 payload 供其他线程访问
     return errorInfo.error == servo::ServoError::NO_ERROR;
@@ -82,7 +82,7 @@ std::pair<bool, std::pair<int, int>> performExtractID(const std::vector<uint8_t>
     // 解析应答包
     // 检查数据包长度是否足够
     if (packet.size() < 6) {
-        Logger::debug("❌ 数据包长度不足，丢弃数据");
+        UP_LOG_DEBUG("❌ 数据包长度不足，丢弃数据");
         return std::make_pair(false, std::make_pair(0, 0));
     }
 
@@ -95,7 +95,7 @@ std::pair<bool, std::pair<int, int>> performExtractID(const std::vector<uint8_t>
 
     // 校验失败，丢弃数据包
     if (checksum != packet.back()) {
-        Logger::debug("❌ 校验失败，丢弃数据包");
+        UP_LOG_DEBUG("❌ 校验失败，丢弃数据包");
         return std::make_pair(false, std::make_pair(0, 0));
     }
 
@@ -202,7 +202,7 @@ namespace servo {
                 startPrinting = true;
             }
             if (startPrinting && dataIndex < data.size()) {
-                Logger::debug(eePROMValue(eepromField, data[dataIndex]));
+                UP_LOG_DEBUG(eePROMValue(eepromField, data[dataIndex]));
                 unorderedMap[eepromField] = data[dataIndex];
                 dataIndex++;
             }
@@ -321,7 +321,7 @@ namespace servo {
                 startPrinting = true;
             }
             if (startPrinting && dataIndex < data.size()) {
-                Logger::debug(ramValue(ramField, data[dataIndex]));
+                UP_LOG_DEBUG(ramValue(ramField, data[dataIndex]));
                 unorderedMap[ramField] = data[dataIndex];
                 dataIndex++;
             }
@@ -0,0 +1,263 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include "trace.h"
+#include "serial/serial.h"
+
+namespace trace {
+    namespace detail {
+        std::atomic<bool> enabled{false};
+    }
+}
+
+namespace {
+    const char MAGIC[4] = {'U', 'P', 'T', 'R'};
+
+    // 每个线程的记录缓冲区，只有本线程和 flush / stop 会加锁
+    struct ThreadBuffer {
+        std::mutex mutex;
+        uint32_t thread = 0;
+        uint64_t session = 0;
+        std::vector<trace::Record> records;
+    };
+
+    // 锁的顺序：mutex（缓冲区列表）-> ThreadBuffer::mutex -> file_mutex
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadBuffer *> buffers;
+        uint32_t next_thread = 0;
+
+        std::mutex file_mutex;
+        std::FILE *file = nullptr;
+        size_t buffer_records = 4096;
+        std::atomic<uint64_t> session{0};
+    };
+
+    // 不释放，线程退出和进程退出时的析构顺序不影响它
+    Registry &registry() {
+        static Registry *instance = new Registry();
+        return *instance;
+    }
+
+    // 调用方持有 buffer.mutex
+    void writeOut(ThreadBuffer &buffer) {
+        if (buffer.records.empty()) {
+            return;
+        }
+        Registry &r = registry();
+        {
+            std::lock_guard<std::mutex> lock(r.file_mutex);
+            if (r.file != nullptr && buffer.session == r.session.load()) {
+                std::fwrite(buffer.records.data(), sizeof(trace::Record), buffer.records.size(), r.file);
+            }
+        }
+        buffer.records.clear();
+    }
+
+    // 线程退出时写出剩余记录并注销缓冲区
+    struct ThreadBufferHolder {
+        ThreadBuffer *buffer = nullptr;
+
+        ~ThreadBufferHolder() {
+            if (buffer == nullptr) {
+                return;
+            }
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            {
+                std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+                writeOut(*buffer);
+            }
+            for (size_t i = 0; i < r.buffers.size(); ++i) {
+                if (r.buffers[i] == buffer) {
+                    r.buffers.erase(r.buffers.begin() + i);
+                    break;
+                }
+            }
+            delete buffer;
+        }
+    };
+
+    ThreadBuffer &threadBuffer() {
+        thread_local ThreadBufferHolder holder;
+        if (holder.buffer == nullptr) {
+            Registry &r = registry();
+            std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+            std::lock_guard<std::mutex> lock(r.mutex);
+            buffer->thread = ++r.next_thread;
+            r.buffers.push_back(buffer.get());
+            holder.buffer = buffer.release();
+        }
+        return *holder.buffer;
+    }
+
+    void flushAll(bool close) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (ThreadBuffer *buffer: r.buffers) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            writeOut(*buffer);
+        }
+        std::lock_guard<std::mutex> file_lock(r.file_mutex);
+        if (r.file != nullptr) {
+            std::fflush(r.file);
+            if (close) {
+                std::fclose(r.file);
+                r.file = nullptr;
+            }
+        }
+    }
+
+    // 进程退出时写出剩余记录
+    struct TraceShutdown {
+        ~TraceShutdown() {
+            trace::stop();
+        }
+    } trace_shutdown;
+}
+
+namespace trace {
+
+    void start(const std::string &path, size_t buffer_records) {
+        stop();
+
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("无法创建跟踪文件 " + path);
+        }
+
+        uint8_t header[FILE_HEADER_SIZE] = {0};
+        uint16_t version = FORMAT_VERSION;
+        uint16_t record_size = sizeof(Record);
+        uint64_t start_ns = serial::monotonicNs();
+        std::memcpy(header, MAGIC, sizeof(MAGIC));
+        std::memcpy(header + 4, &version, sizeof(version));
+        std::memcpy(header + 6, &record_size, sizeof(record_size));
+        std::memcpy(header + 8, &start_ns, sizeof(start_ns));
+        std::fwrite(header, 1, sizeof(header), file);
+
+        Registry &r = registry();
+        {
+            std::lock_guard<std::mutex> lock(r.file_mutex);
+            r.file = file;
+            r.buffer_records = buffer_records > 0 ? buffer_records : 1;
+            ++r.session;
+        }
+        detail::enabled = true;
+    }
+
+    void stop() {
+        detail::enabled = false;
+        flushAll(true);
+    }
+
+    void flush() {
+        flushAll(false);
+    }
+
+    void emit(Event event, uint8_t id, uint8_t flags, uint32_t transaction, uint32_t arg0, uint64_t arg1,
+              uint64_t time_ns) {
+        if (!enabled()) {
+            return;
+        }
+
+        ThreadBuffer &buffer = threadBuffer();
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+
+        // 上一次跟踪遗留的记录不写入新文件
+        uint64_t session = r.session.load();
+        if (buffer.session != session) {
+            buffer.records.clear();
+            buffer.records.reserve(r.buffer_records);
+            buffer.session = session;
+        }
+
+        Record record;
+        record.time_ns = time_ns != 0 ? time_ns : serial::monotonicNs();
+        record.thread = buffer.thread;
+        record.event = event;
+        record.id = id;
+        record.flags = flags;
+        record.transaction = transaction;
+        record.arg0 = arg0;
+        record.arg1 = arg1;
+        buffer.records.push_back(record);
+
+        if (buffer.records.size() >= r.buffer_records) {
+            writeOut(buffer);
+        }
+    }
+
+    void emitFrame(Event event, const uint8_t *frame, size_t size, uint32_t transaction, uint64_t time_ns) {
+        uint8_t id = size > 2 ? frame[2] : 0;
+        uint8_t flags = (event == FRAME_RX && size > 4) ? frame[4] : 0;
+        uint64_t head = 0;
+        for (size_t i = 0; i < size && i < 8; ++i) {
+            head |= static_cast<uint64_t>(frame[i]) << (8 * i);
+        }
+        emit(event, id, flags, transaction, static_cast<uint32_t>(size), head, time_ns);
+    }
+
+    std::vector<Record> load(const std::string &path, uint64_t *start_ns) {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            throw std::runtime_error("无法打开跟踪文件 " + path);
+        }
+
+        uint8_t header[FILE_HEADER_SIZE];
+        uint16_t version = 0;
+        uint16_t record_size = 0;
+        if (std::fread(header, 1, sizeof(header), file) != sizeof(header) ||
+            std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0) {
+            std::fclose(file);
+            throw std::runtime_error("不是跟踪文件：" + path);
+        }
+        std::memcpy(&version, header + 4, sizeof(version));
+        std::memcpy(&record_size, header + 6, sizeof(record_size));
+        if (version != FORMAT_VERSION || record_size != sizeof(Record)) {
+            std::fclose(file);
+            throw std::runtime_error("不支持的跟踪文件版本：" + std::to_string(version));
+        }
+        if (start_ns != nullptr) {
+            std::memcpy(start_ns, header + 8, sizeof(*start_ns));
+        }
+
+        std::vector<Record> records;
+        Record chunk[1024];
+        size_t n;
+        while ((n = std::fread(chunk, sizeof(Record), 1024, file)) > 0) {
+            records.insert(records.end(), chunk, chunk + n);
+        }
+        std::fclose(file);
+        return records;
+    }
+
+    const char *eventName(uint16_t event) {
+        switch (event) {
+            case FRAME_TX:
+                return "FRAME_TX";
+            case FRAME_RX:
+                return "FRAME_RX";
+            case TRANSACTION_BEGIN:
+                return "TRANSACTION_BEGIN";
+            case TRANSACTION_END:
+                return "TRANSACTION_END";
+            case TIMEOUT:
+                return "TIMEOUT";
+            case RETRY:
+                return "RETRY";
+            case ERROR:
+                return "ERROR";
+            default:
+                return "UNKNOWN";
+        }
+    }
+
+} // namespace trace
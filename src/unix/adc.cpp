@@ -4,6 +4,7 @@
 
 #include "unix/adc.h"
 #include <iostream>
+#include <string.h>
 
 namespace adc {
 /**
@@ -41,18 +42,84 @@ namespace adc {
     }
 
 /**
- * @brief 读取所有 ADC 通道
+ * @brief 读取所有 ADC 通道（一次 SPI 传输）
  * @return 各通道的 ADC 数据向量
  * @throws ADCException 读取失败时抛出异常
  */
     std::vector<uint16_t> ADC::readAll() {
         std::vector<uint16_t> values(channel_count);
+        readAll(values.data(), values.size());
+        return values;
+    }
 
-        for (uint8_t i = 0; i < channel_count; ++i) {
-            values[i] = readChannel(i);
+/**
+ * @brief 读取所有 ADC 通道到调用方的缓冲区
+ * @param values 结果缓冲区
+ * @param capacity 缓冲区长度
+ * @return 读取的通道数
+ * @throws ADCException 缓冲区小于通道数时抛出异常
+ */
+    size_t ADC::readAll(uint16_t *values, size_t capacity) {
+        if (capacity < channel_count) {
+            throw ADCException("缓冲区长度 " + std::to_string(capacity) + " 小于通道数 " +
+                               std::to_string(channel_count));
         }
 
-        return values;
+        uint8_t channels[256];
+        for (size_t i = 0; i < channel_count; ++i) {
+            channels[i] = static_cast<uint8_t>(i);
+        }
+        readChannels(channels, channel_count, values);
+        return channel_count;
+    }
+
+/**
+ * @brief 把多个通道的转换放进一条 SPI 消息
+ * @param channels 通道索引
+ * @param count 通道数
+ * @param values 结果缓冲区，长度不小于 count
+ * @throws ADCException 通道索引无效或通道数超出单条消息的限制时抛出异常
+ */
+    void ADC::readChannels(const uint8_t *channels, size_t count, uint16_t *values) {
+        if (count == 0) {
+            return;
+        }
+        if (count > spi::SPI::MAX_TRANSFERS) {
+            throw ADCException("一次读取的通道数过多: " + std::to_string(count));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (channels[i] >= channel_count) {
+                throw ADCException("无效的 ADC 通道索引: " + std::to_string(channels[i]));
+            }
+        }
+
+        // 传输段和收发缓冲区每次调用单独分配，多个线程（如 Python 线程和 Sampler）可以同时读取，
+        // 同一设备上的消息由 spidev 依次执行
+        std::vector<struct spi_ioc_transfer> transfers(count);
+        std::vector<uint8_t> tx_buffers(count * 3);
+        std::vector<uint8_t> rx_buffers(count * 3);
+
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t *tx = &tx_buffers[i * 3];
+            tx[0] = 0x01;
+            tx[1] = (uint8_t) ((0x80 | (channels[i] << 4)) & 0xF0);
+            tx[2] = 0x00;
+
+            struct spi_ioc_transfer &tr = transfers[i];
+            memset(&tr, 0, sizeof(tr));
+            tr.tx_buf = (unsigned long) tx;
+            tr.rx_buf = (unsigned long) &rx_buffers[i * 3];
+            tr.len = 3;
+            // 每次转换之后释放片选；最后一段的 cs_change 为 0，消息结束时照常释放
+            tr.cs_change = (i + 1 < count) ? 1 : 0;
+        }
+
+        spi.transferBatch(transfers.data(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t *rx = &rx_buffers[i * 3];
+            values[i] = ((rx[1] & 0x03) << 8) | rx[2];  // 提取有效数据
+        }
     }
 
-}
\ No newline at end of file
+}
@@ -3,6 +3,12 @@
 //
 
 #include "unix/gpio.h"
+#include "serial/reactor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
 
 namespace gpio {
 /**
@@ -70,4 +76,248 @@ namespace gpio {
         }
     }
 
-}
\ No newline at end of file
+/**
+ * @brief GPIO 引脚组构造函数
+ * @param chip_id  GPIO 控制器编号（如 `/dev/gpiochip0` 对应 chip_id=0）
+ * @param offsets  引脚编号，读写时的值按此顺序排列
+ * @throws GPIOException 引脚为空或超过 MAX_LINES 时抛出异常
+ */
+    GPIOLines::GPIOLines(int chip_id, const std::vector<unsigned int> &offsets)
+            : chip_id(chip_id), offsets(offsets), chip(nullptr), mode(NONE) {
+        if (offsets.empty() || offsets.size() > MAX_LINES) {
+            throw GPIOException("引脚数应为 1~" + std::to_string(MAX_LINES) + "，实际为 " +
+                                std::to_string(offsets.size()));
+        }
+        gpiod_line_bulk_init(&bulk);
+    }
+
+/**
+ * @brief GPIO 引脚组析构函数（确保资源释放）
+ */
+    GPIOLines::~GPIOLines() {
+        release();
+    }
+
+/**
+ * @brief 打开控制器并取得所有引脚，已经请求过时先释放
+ * @throws GPIOException 打开失败时抛出异常
+ */
+    void GPIOLines::open() {
+        release();
+
+        chip = gpiod_chip_open_by_number(chip_id);
+        if (!chip) {
+            throw GPIOException("无法打开 /dev/gpiochip" + std::to_string(chip_id));
+        }
+
+        if (gpiod_chip_get_lines(chip, offsets.data(), offsets.size(), &bulk) < 0) {
+            gpiod_chip_close(chip);
+            chip = nullptr;
+            throw GPIOException("无法获取 gpiochip" + std::to_string(chip_id) + " 的引脚");
+        }
+    }
+
+/**
+ * @brief 一次请求所有引脚为输出
+ * @param defaults 各引脚的初始电平，为空时全部为低电平
+ * @throws GPIOException 请求失败时抛出异常
+ */
+    void GPIOLines::requestOutput(const std::vector<int> &defaults) {
+        if (!defaults.empty() && defaults.size() != offsets.size()) {
+            throw GPIOException("初始电平的个数与引脚数不一致");
+        }
+        std::vector<int> values(defaults);
+        values.resize(offsets.size(), 0);
+
+        open();
+        if (gpiod_line_request_bulk_output(&bulk, "gpio_control", values.data()) < 0) {
+            int error = errno;
+            release();
+            throw GPIOException("无法设置引脚为输出模式: " + std::string(strerror(error)));
+        }
+        mode = OUTPUT;
+    }
+
+/**
+ * @brief 一次请求所有引脚为输入
+ * @throws GPIOException 请求失败时抛出异常
+ */
+    void GPIOLines::requestInput() {
+        open();
+        if (gpiod_line_request_bulk_input(&bulk, "gpio_control") < 0) {
+            int error = errno;
+            release();
+            throw GPIOException("无法设置引脚为输入模式: " + std::string(strerror(error)));
+        }
+        mode = INPUT;
+    }
+
+/**
+ * @brief 请求所有引脚为输入并监听边沿事件，事件文件描述符设为非阻塞
+ * @param edge 监听的边沿
+ * @throws GPIOException 请求失败时抛出异常
+ */
+    void GPIOLines::requestEvents(Edge edge) {
+        open();
+        int result;
+        if (edge == RISING) {
+            result = gpiod_line_request_bulk_rising_edge_events(&bulk, "gpio_control");
+        } else if (edge == FALLING) {
+            result = gpiod_line_request_bulk_falling_edge_events(&bulk, "gpio_control");
+        } else {
+            result = gpiod_line_request_bulk_both_edges_events(&bulk, "gpio_control");
+        }
+        if (result < 0) {
+            int error = errno;
+            release();
+            throw GPIOException("无法监听引脚的边沿事件: " + std::string(strerror(error)));
+        }
+        mode = EVENTS;
+
+        // 事件循环中一次取完所有事件，没有事件时 read 立即返回 EAGAIN
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            int fd = gpiod_line_event_get_fd(bulk.lines[i]);
+            int flags = fd < 0 ? -1 : fcntl(fd, F_GETFL);
+            if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+                release();
+                throw GPIOException("无法设置引脚 " + std::to_string(offsets[i]) + " 的事件文件描述符");
+            }
+        }
+    }
+
+/**
+ * @brief 检查引脚已被请求
+ * @param output 是否要求输出模式
+ * @throws GPIOException 未请求或模式不符时抛出异常
+ */
+    void GPIOLines::checkMode(bool output) const {
+        if (mode == NONE) {
+            throw GPIOException("GPIO 未初始化或已释放");
+        }
+        if (output && mode != OUTPUT) {
+            throw GPIOException("引脚不是输出模式");
+        }
+    }
+
+    void GPIOLines::setValues(const std::vector<int> &values) {
+        if (values.size() != offsets.size()) {
+            throw GPIOException("电平的个数与引脚数不一致");
+        }
+        setValues(values.data());
+    }
+
+/**
+ * @brief 一次设置所有引脚的电平
+ * @param values 各引脚的电平，长度为 size()
+ * @throws GPIOException 设置失败时抛出异常
+ */
+    void GPIOLines::setValues(const int *values) {
+        checkMode(true);
+        if (gpiod_line_set_value_bulk(&bulk, values) < 0) {
+            throw GPIOException("无法设置引脚的值: " + std::string(strerror(errno)));
+        }
+    }
+
+    std::vector<int> GPIOLines::getValues() {
+        std::vector<int> values(offsets.size());
+        getValues(values.data());
+        return values;
+    }
+
+/**
+ * @brief 一次读取所有引脚的电平
+ * @param values 各引脚的电平，长度为 size()
+ * @throws GPIOException 读取失败时抛出异常
+ */
+    void GPIOLines::getValues(int *values) {
+        checkMode(false);
+        if (gpiod_line_get_value_bulk(&bulk, values) < 0) {
+            throw GPIOException("无法读取引脚的值: " + std::string(strerror(errno)));
+        }
+    }
+
+    int GPIOLines::eventFd(size_t index) const {
+        if (mode != EVENTS) {
+            throw GPIOException("引脚未监听边沿事件");
+        }
+        if (index >= offsets.size()) {
+            throw GPIOException("无效的引脚索引: " + std::to_string(index));
+        }
+        return gpiod_line_event_get_fd(bulk.lines[index]);
+    }
+
+/**
+ * @brief 取出第 index 个引脚已发生的边沿事件
+ * @throws GPIOException 读取失败时抛出异常
+ */
+    size_t GPIOLines::readEvents(size_t index, LineEvent *events, size_t max) {
+        int fd = eventFd(index);
+        size_t count = 0;
+        while (count < max) {
+            struct gpiod_line_event event;
+            if (gpiod_line_event_read_fd(fd, &event) < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                throw GPIOException("无法读取引脚 " + std::to_string(offsets[index]) + " 的事件: " +
+                                    std::string(strerror(errno)));
+            }
+            events[count].offset = offsets[index];
+            events[count].rising = event.event_type == GPIOD_LINE_EVENT_RISING_EDGE;
+            events[count].time_ns = static_cast<uint64_t>(event.ts.tv_sec) * 1000000000ULL +
+                                    static_cast<uint64_t>(event.ts.tv_nsec);
+            ++count;
+        }
+        return count;
+    }
+
+/**
+ * @brief 在 reactor 中监听所有引脚的事件文件描述符
+ * @param reactor 事件循环
+ * @param on_event 事件回调，在事件循环线程中调用
+ * @throws GPIOException 引脚未监听边沿事件时抛出异常
+ */
+    void GPIOLines::watch(serial::Reactor &reactor, EventCallback on_event) {
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            reactor.addFd(eventFd(i), EPOLLIN, [this, i, on_event](uint32_t) {
+                LineEvent events[16];
+                size_t count;
+                do {
+                    try {
+                        count = readEvents(i, events, 16);
+                    } catch (const GPIOException &) {
+                        return; // 引脚已被释放，不让异常中断事件循环
+                    }
+                    for (size_t j = 0; j < count; ++j) {
+                        on_event(events[j]);
+                    }
+                } while (count == 16);
+            });
+        }
+    }
+
+    void GPIOLines::unwatch(serial::Reactor &reactor) {
+        if (mode != EVENTS) {
+            return;
+        }
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            reactor.removeFd(eventFd(i));
+        }
+    }
+
+/**
+ * @brief 释放引脚和控制器
+ */
+    void GPIOLines::release() {
+        if (mode != NONE) {
+            gpiod_line_release_bulk(&bulk);
+            mode = NONE;
+        }
+        gpiod_line_bulk_init(&bulk);
+        if (chip) {
+            gpiod_chip_close(chip);
+            chip = nullptr;
+        }
+    }
+
+}
@@ -0,0 +1,248 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include "unix/sampler.h"
+#include "serial/serial.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace adc {
+
+/**
+ * @brief 采样引擎构造函数，分配环形缓冲区，不启动线程
+ * @param adc ADC 对象，需要比采样引擎存活更久
+ * @param options 采样配置
+ * @throws ADCException 配置无效时抛出异常
+ */
+    Sampler::Sampler(ADC &adc, const SamplerOptions &options) : adc_(adc), options_(options) {
+        if (options_.channels.empty()) {
+            throw ADCException("没有指定采样通道");
+        }
+        if (options_.channels.size() > spi::SPI::MAX_TRANSFERS) {
+            throw ADCException("采样通道过多: " + std::to_string(options_.channels.size()));
+        }
+        for (uint8_t channel: options_.channels) {
+            if (channel >= adc_.getChannelCount()) {
+                throw ADCException("无效的 ADC 通道索引: " + std::to_string(channel));
+            }
+        }
+        if (!(options_.rate_hz > 0) || options_.rate_hz > 1e9) {
+            throw ADCException("无效的采样频率: " + std::to_string(options_.rate_hz));
+        }
+        if (options_.capacity == 0) {
+            throw ADCException("环形缓冲区容量不能为 0");
+        }
+        if (options_.decimation == 0) {
+            options_.decimation = 1;
+        }
+
+        times_.resize(options_.capacity);
+        values_.resize(options_.capacity * options_.channels.size());
+        min_.reset(new std::atomic<uint16_t>[options_.channels.size()]);
+        max_.reset(new std::atomic<uint16_t>[options_.channels.size()]);
+        for (size_t i = 0; i < options_.channels.size(); ++i) {
+            min_[i].store(0xFFFF, std::memory_order_relaxed);
+            max_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+/**
+ * @brief 析构时停止采样线程
+ */
+    Sampler::~Sampler() {
+        stop();
+    }
+
+/**
+ * @brief 启动采样线程
+ */
+    void Sampler::start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_.load()) {
+            return;
+        }
+        if (thread_.joinable()) {
+            thread_.join(); // 读取出错后自行退出的线程
+        }
+        stopping_ = false;
+        error_.clear();
+        running_.store(true);
+        thread_ = std::thread(&Sampler::run, this);
+    }
+
+/**
+ * @brief 停止采样线程，等待正在进行的扫描完成
+ */
+    void Sampler::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    bool Sampler::running() const {
+        return running_.load();
+    }
+
+    std::string Sampler::lastError() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return error_;
+    }
+
+/**
+ * @brief 采样线程：按时间表扫描、统计最小 / 最大值、取平均并写入环形缓冲区
+ */
+    void Sampler::run() {
+        const size_t channel_count = options_.channels.size();
+        const uint32_t decimation = options_.decimation;
+        const auto period = std::chrono::nanoseconds(
+                std::max<long long>(1, std::llround(1e9 / options_.rate_hz)));
+
+        std::vector<uint16_t> scan(channel_count);
+        std::vector<uint32_t> sums(channel_count, 0);
+        std::vector<uint16_t> sample(channel_count);
+        uint32_t accumulated = 0;
+        uint64_t window_start_ns = 0;
+
+        auto next = std::chrono::steady_clock::now();
+        try {
+            for (;;) {
+                uint64_t now_ns = serial::monotonicNs();
+                adc_.readChannels(options_.channels.data(), channel_count, scan.data());
+                scans_.fetch_add(1, std::memory_order_relaxed);
+
+                // 只有采样线程写入最小 / 最大值，读取方通过 reset_stats_ 请求重新统计
+                bool reset = reset_stats_.exchange(false, std::memory_order_acq_rel);
+                for (size_t i = 0; i < channel_count; ++i) {
+                    if (reset || scan[i] < min_[i].load(std::memory_order_relaxed)) {
+                        min_[i].store(scan[i], std::memory_order_relaxed);
+                    }
+                    if (reset || scan[i] > max_[i].load(std::memory_order_relaxed)) {
+                        max_[i].store(scan[i], std::memory_order_relaxed);
+                    }
+                }
+
+                if (decimation == 1) {
+                    push(now_ns, scan.data());
+                } else {
+                    if (accumulated == 0) {
+                        window_start_ns = now_ns;
+                    }
+                    for (size_t i = 0; i < channel_count; ++i) {
+                        sums[i] += scan[i];
+                    }
+                    if (++accumulated == decimation) {
+                        for (size_t i = 0; i < channel_count; ++i) {
+                            sample[i] = static_cast<uint16_t>((sums[i] + decimation / 2) / decimation);
+                            sums[i] = 0;
+                        }
+                        accumulated = 0;
+                        push(window_start_ns + (now_ns - window_start_ns) / 2, sample.data());
+                    }
+                }
+
+                // 下一个扫描时刻；已经错过的时刻直接跳过，保持与原时间表对齐
+                next += period;
+                auto now = std::chrono::steady_clock::now();
+                if (now >= next) {
+                    auto behind = (now - next) / period + 1;
+                    missed_.fetch_add(static_cast<uint64_t>(behind), std::memory_order_relaxed);
+                    next += behind * period;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (wake_.wait_until(lock, next, [this] { return stopping_; })) {
+                    break;
+                }
+            }
+        } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = e.what();
+        }
+        running_.store(false);
+    }
+
+/**
+ * @brief 写入一个样本，缓冲区满时丢弃
+ */
+    void Sampler::push(uint64_t time_ns, const uint16_t *sample) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= options_.capacity) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        size_t row = static_cast<size_t>(head % options_.capacity);
+        const size_t channel_count = options_.channels.size();
+        times_[row] = time_ns;
+        std::memcpy(&values_[row * channel_count], sample, channel_count * sizeof(uint16_t));
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    size_t Sampler::available() const {
+        return static_cast<size_t>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed));
+    }
+
+    size_t Sampler::peek(size_t *first) const {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        size_t count = static_cast<size_t>(head_.load(std::memory_order_acquire) - tail);
+        size_t row = static_cast<size_t>(tail % options_.capacity);
+        if (first != nullptr) {
+            *first = row;
+        }
+        return std::min(count, options_.capacity - row);
+    }
+
+    void Sampler::consume(size_t count) {
+        count = std::min(count, available());
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+/**
+ * @brief 复制并取走样本，跨过缓冲区末尾时分两段复制
+ */
+    size_t Sampler::read(uint64_t *times, uint16_t *values, size_t max) {
+        const size_t channel_count = options_.channels.size();
+        size_t total = 0;
+        while (total < max) {
+            size_t first = 0;
+            size_t count = std::min(peek(&first), max - total);
+            if (count == 0) {
+                break;
+            }
+            std::memcpy(times + total, &times_[first], count * sizeof(uint64_t));
+            std::memcpy(values + total * channel_count, &values_[first * channel_count],
+                        count * channel_count * sizeof(uint16_t));
+            consume(count);
+            total += count;
+        }
+        return total;
+    }
+
+    std::vector<uint16_t> Sampler::minimum() const {
+        std::vector<uint16_t> result(options_.channels.size());
+        for (size_t i = 0; i < result.size(); ++i) {
+            result[i] = min_[i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    std::vector<uint16_t> Sampler::maximum() const {
+        std::vector<uint16_t> result(options_.channels.size());
+        for (size_t i = 0; i < result.size(); ++i) {
+            result[i] = max_[i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    void Sampler::resetStats() {
+        reset_stats_.store(true, std::memory_order_release);
+    }
+
+}
@@ -9,6 +9,7 @@
 #include <sys/ioctl.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 
 namespace spi {
 
@@ -66,10 +67,6 @@ namespace spi {
  * @throws SPIException 传输失败时抛出异常
  */
     void SPI::transfer(uint8_t *tx, uint8_t *rx, size_t length) {
-        if (fd < 0) {
-            throw SPIException("SPI 设备未初始化");
-        }
-
         struct spi_ioc_transfer tr = {};
         memset(&tr, 0, sizeof(tr));
 
@@ -79,8 +76,48 @@ namespace spi {
         tr.speed_hz = speed;
         tr.bits_per_word = bits_per_word;
 
-        if (ioctl(fd, SPI_IOC_MESSAGE(1), &tr) < 0) {
-            throw SPIException("SPI 传输失败");
+        message(&tr, 1);
+    }
+
+/**
+ * @brief 一次 ioctl 提交多段传输，各段之间是否释放片选由 cs_change 决定
+ * @param transfers 传输段数组，speed_hz / bits_per_word 为 0 的段使用本对象的设置
+ * @param count 段数，不超过 MAX_TRANSFERS
+ * @throws SPIException 段数超出限制、设备未初始化或传输失败时抛出异常
+ */
+    void SPI::transferBatch(struct spi_ioc_transfer *transfers, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (count > MAX_TRANSFERS) {
+            throw SPIException("一次传输的段数过多: " + std::to_string(count));
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (transfers[i].speed_hz == 0) {
+                transfers[i].speed_hz = speed;
+            }
+            if (transfers[i].bits_per_word == 0) {
+                transfers[i].bits_per_word = bits_per_word;
+            }
+        }
+
+        message(transfers, count);
+    }
+
+/**
+ * @brief 通过 spidev 提交一条 SPI 消息
+ * @param transfers 传输段数组
+ * @param count 段数
+ * @throws SPIException 设备未初始化或传输失败时抛出异常
+ */
+    void SPI::message(struct spi_ioc_transfer *transfers, size_t count) {
+        if (fd < 0) {
+            throw SPIException("SPI 设备未初始化");
+        }
+
+        if (ioctl(fd, SPI_IOC_MESSAGE(count), transfers) < 0) {
+            throw SPIException("SPI 传输失败: " + std::string(strerror(errno)));
         }
     }
 
@@ -0,0 +1,61 @@
+//
+// Created by noodles on 26-10-18.
+// CRC16 与固件分帧性能测试
+//
+#include "crc16.h"
+#include "firmware_image.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace {
+    volatile uint32_t sink = 0;
+
+    double measure(const std::function<void()> &body, int iterations) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            body();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    void benchCRC(const char *name, uint16_t (*crc)(const uint8_t *, size_t, uint16_t),
+                  const std::vector<uint8_t> &data, size_t block, int iterations) {
+        double seconds = measure([&] {
+            for (size_t offset = 0; offset + block <= data.size(); offset += block) {
+                sink += crc(data.data() + offset, block, 0);
+            }
+        }, iterations);
+        double bytes = static_cast<double>(data.size() / block * block) * iterations;
+        std::printf("  %-10s block %5zu B: %9.1f MB/s\n", name, block, bytes / seconds / 1e6);
+    }
+}
+
+int main() {
+    // 64 KB 固件镜像
+    std::vector<uint8_t> image(64 * 1024);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i * 131 + 17);
+    }
+
+    std::printf("CRC-16/XMODEM 吞吐量\n");
+    for (size_t block: {static_cast<size_t>(128), static_cast<size_t>(1024), image.size()}) {
+        benchCRC("bitwise", crc16::xmodemBitwise, image, block, 20);
+        benchCRC("table", crc16::xmodemTable, image, block, 200);
+        benchCRC("slicing8", crc16::xmodemSlicing8, image, block, 200);
+    }
+
+    // 组装整个镜像的所有帧
+    const int iterations = 200;
+    double seconds = measure([&] {
+        FirmwareFrameStream frames(image.data(), image.size());
+        for (size_t i = 0; i < frames.frameCount(); ++i) {
+            sink += frames.frame(i)[132];
+        }
+    }, iterations);
+    std::printf("64 KB 镜像全部分帧：%.1f us/次\n", seconds / iterations * 1e6);
+
+    return 0;
+}
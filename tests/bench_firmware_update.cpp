@@ -0,0 +1,61 @@
+//
+// Created by noodles on 26-10-18.
+// 固件升级端到端吞吐量测试（模拟 Bootloader，按波特率模拟线路时间）
+//
+#include "bootloader_sim.h"
+#include "firmware_update.h"
+#include "logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    void benchUpgrade(const std::vector<uint8_t> &image, size_t block_size, uint32_t transfer_baud_rate,
+                      const BootloaderSimOptions &options = BootloaderSimOptions()) {
+        BootloaderSimulator simulator(options);
+
+        FirmwareUpdate update;
+        update.setTransferOptions(block_size, transfer_baud_rate);
+
+        auto start = std::chrono::steady_clock::now();
+        bool success = update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        UpgradeMetrics metrics = update.getMetrics();
+        std::printf("  block %5zu B, baud %7u: %s %7.2f s, %8.0f B/s (实际块 %zu B, 波特率 %u, "
+                    "握手 %.2f s, 传输 %.2f s, 重发 %zu)\n",
+                    block_size, transfer_baud_rate == 0 ? 9600 : transfer_baud_rate,
+                    success ? "OK  " : "FAIL", seconds, image.size() / seconds,
+                    simulator.blockSize(), simulator.baudrate(),
+                    metrics.handshake_seconds, metrics.transfer_seconds, metrics.frames_retried);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // 镜像大小（KB），默认 8 KB，9600 波特率下 128 字节分帧约 9 秒
+    size_t kilobytes = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 8;
+    std::vector<uint8_t> image(kilobytes * 1024);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i * 131 + 17);
+    }
+
+    Logger::setLogLevel(Logger::OFF);
+
+    std::printf("固件升级吞吐量（%zu KB 镜像）\n", kilobytes);
+    benchUpgrade(image, 128, 0);
+    benchUpgrade(image, 1024, 0);
+    benchUpgrade(image, 128, 115200);
+    benchUpgrade(image, 1024, 115200);
+    benchUpgrade(image, 1024, 460800);
+
+    // 噪声总线：每 10 帧一次 NAK，每 25 帧丢一次应答
+    BootloaderSimOptions noisy;
+    noisy.nak_every = 10;
+    noisy.drop_every = 25;
+    std::printf("噪声总线（NAK 1/10，丢帧 1/25）\n");
+    benchUpgrade(image, 128, 115200, noisy);
+    benchUpgrade(image, 1024, 115200, noisy);
+
+    return 0;
+}
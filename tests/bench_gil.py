@@ -0,0 +1,88 @@
+"""
+阻塞调用期间释放 GIL 的效果：多个线程同时在串口上等待数据，主线程运行纯 Python 计算。
+
+使用伪终端（os.openpty），不需要真实串口，仅在 Linux 上运行：
+    python tests/bench_gil.py [线程数] [每个线程的读取次数] [读超时毫秒]
+
+阻塞调用释放 GIL 时：
+  - 多个线程的等待相互重叠，总耗时约为 读取次数 x 超时，而不是再乘以线程数
+  - 主线程的计算速度与没有其他线程时接近
+"""
+import os
+import sys
+import threading
+import time
+
+import up_core as up
+
+
+def python_work(stop):
+    # 纯 Python 计算，统计循环次数
+    count = 0
+    while not stop.is_set():
+        for _ in range(1000):
+            count += 1
+    return count
+
+
+def measure_idle(seconds):
+    stop = threading.Event()
+    timer = threading.Timer(seconds, stop.set)
+    timer.start()
+    start = time.perf_counter()
+    count = python_work(stop)
+    return count / (time.perf_counter() - start)
+
+
+def main():
+    threads = int(sys.argv[1]) if len(sys.argv) > 1 else 4
+    reads = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+    timeout_ms = int(sys.argv[3]) if len(sys.argv) > 3 else 50
+
+    # 每个线程一个伪终端，主端不写数据，从端的每次读取都等到超时
+    ports = []
+    masters = []
+    for _ in range(threads):
+        master, slave = os.openpty()
+        masters.append(master)
+        port = up.Serial(os.ttyname(slave), 115200, up.Timeout.simpleTimeout(timeout_ms))
+        os.close(slave)
+        ports.append(port)
+
+    idle_rate = measure_idle(0.5)
+
+    def reader(port):
+        for _ in range(reads):
+            port.read(1)
+
+    workers = [threading.Thread(target=reader, args=(port,)) for port in ports]
+    stop = threading.Event()
+    result = {}
+    compute = threading.Thread(target=lambda: result.update(count=python_work(stop)))
+
+    start = time.perf_counter()
+    compute.start()
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
+    elapsed = time.perf_counter() - start
+    stop.set()
+    compute.join()
+    busy_rate = result["count"] / (time.perf_counter() - start)
+
+    serial_time = threads * reads * timeout_ms / 1000.0
+    overlap_time = reads * timeout_ms / 1000.0
+    print(f"{threads} 个线程各读取 {reads} 次（超时 {timeout_ms} ms）：总耗时 {elapsed:.2f} s "
+          f"（完全并发 {overlap_time:.2f} s，逐个执行 {serial_time:.2f} s）")
+    print(f"主线程 Python 计算：空闲时 {idle_rate / 1e6:.1f} M 次/s，读取期间 {busy_rate / 1e6:.1f} M 次/s "
+          f"（{busy_rate / idle_rate * 100:.0f}%）")
+
+    for port in ports:
+        port.close()
+    for master in masters:
+        os.close(master)
+
+
+if __name__ == "__main__":
+    main()
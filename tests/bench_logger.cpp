@@ -0,0 +1,76 @@
+//
+// Created by noodles on 26-10-18.
+// 日志调用开销：被过滤的级别、同步输出、异步输出（控制台 / 文件）
+//
+// INFO 日志写入 clog（stderr），运行时把 stderr 重定向，只看统计结果：
+//   logger_bench 2>/dev/null
+//
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char *LOG_PATH = "/tmp/up_core_logger_bench.log";
+
+    // threads 个线程各写 count 条日志，统计单次调用耗时
+    void bench(const char *label, Logger::LogLevel level, int threads, int count) {
+        std::vector<std::vector<double> > costs(threads);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::string message = "舵机 " + std::to_string(t) + " 位置 2048 速度 100 负载 12";
+                costs[t].reserve(count);
+                for (int i = 0; i < count; ++i) {
+                    auto begin = std::chrono::steady_clock::now();
+                    if (level == Logger::DEBUG) {
+                        Logger::debug(message);
+                    } else {
+                        Logger::info(message);
+                    }
+                    auto end = std::chrono::steady_clock::now();
+                    costs[t].push_back(std::chrono::duration<double, std::nano>(end - begin).count());
+                }
+            });
+        }
+        for (std::thread &worker: workers) {
+            worker.join();
+        }
+        Logger::flush();
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<double> all;
+        for (const std::vector<double> &cost: costs) {
+            all.insert(all.end(), cost.begin(), cost.end());
+        }
+        std::sort(all.begin(), all.end());
+        std::printf("  %-24s %d 线程 x %d 条：p50 %7.0f ns, p99 %8.0f ns, max %9.0f ns, 总计 %7.1f ms\n", label, threads,
+                    count, all[all.size() / 2], all[all.size() * 99 / 100], all.back(), elapsed_ms);
+    }
+}
+
+int main() {
+    const int count = 20000;
+    Logger::setLogLevel(Logger::INFO);
+
+    for (int threads: {1, 4}) {
+        bench("过滤的 DEBUG", Logger::DEBUG, threads, count);
+        bench("同步 INFO", Logger::INFO, threads, count);
+
+        Logger::enableAsync();
+        bench("异步 INFO（控制台，丢弃）", Logger::INFO, threads, count);
+        std::printf("    丢弃 %llu 条\n", static_cast<unsigned long long>(Logger::droppedCount()));
+
+        Logger::AsyncOptions options;
+        options.overflow = Logger::BLOCK;
+        options.path = LOG_PATH;
+        Logger::enableAsync(options);
+        bench("异步 INFO（文件，阻塞）", Logger::INFO, threads, count);
+        Logger::disableAsync();
+        std::remove(LOG_PATH);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+//
+// Created by noodles on 26-10-18.
+// 录制 / 回放性能测试：
+//  - Recorder::record 的单次开销（调用方线程只做缓冲区追加）
+//  - 回放录制文件驱动 Servo 解析路径的吞吐量，结果可重复，可用于比较解析 / 回调的改动
+//
+// 传入录制文件时回放该文件，否则生成一段舵机应答流量：
+//   replay_bench [recording.uprc]
+//
+#include "serial/recorder.h"
+#include "serial/replay.h"
+#include "servo.h"
+#include "pty_pair.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    const char *DEFAULT_PATH = "/tmp/up_core_replay_bench.uprc";
+
+    // 生成 count 个指令 / 应答对，应答在指令后 1 ms，指令间隔 5 ms
+    void benchRecord(const std::string &path, size_t count) {
+        std::vector<uint8_t> command = servo::ServoProtocol(1).buildPingPacket();
+        std::vector<uint8_t> response = {0xFF, 0xFF, 0x01, 0x02, 0x00, 0xFC};
+
+        serial::Recorder recorder(path);
+        std::vector<double> cost_ns;
+        cost_ns.reserve(count * 2);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t tx_ns = recorder.startTime() + i * 5000000ULL;
+            uint64_t start = serial::monotonicNs();
+            recorder.record(serial::Recorder::TX, command.data(), command.size(), tx_ns);
+            uint64_t middle = serial::monotonicNs();
+            recorder.record(serial::Recorder::RX, response.data(), response.size(), tx_ns + 1000000ULL);
+            uint64_t end = serial::monotonicNs();
+            cost_ns.push_back(static_cast<double>(middle - start));
+            cost_ns.push_back(static_cast<double>(end - middle));
+        }
+        recorder.close();
+
+        std::sort(cost_ns.begin(), cost_ns.end());
+        std::printf("录制 %zu 条记录：record() p50 %.0f ns, p99 %.0f ns, max %.0f ns\n", cost_ns.size(),
+                    cost_ns[cost_ns.size() / 2], cost_ns[cost_ns.size() * 99 / 100], cost_ns.back());
+    }
+
+    void benchReplay(const serial::Recording &recording, double speed, size_t rounds) {
+        PtyPair pty;
+        Servo servo(pty.open());
+        size_t packets = 0;
+        servo.setDataCallback([&](const std::vector<uint8_t> &) { ++packets; });
+
+        serial::Replayer replayer(recording);
+        replayer.setSpeed(speed);
+        uint64_t start = serial::monotonicNs();
+        size_t records = 0;
+        for (size_t i = 0; i < rounds; ++i) {
+            records += replayer.run([&](const serial::Recording::Record &record, uint64_t now_ns) {
+                servo.inject(record.data.data(), record.data.size(), now_ns);
+            });
+        }
+        double elapsed_s = static_cast<double>(serial::monotonicNs() - start) / 1e9;
+        std::printf("回放 speed %-4g: %zu 条 RX 记录，%zu 个数据包，%.3f s，%.0f 记录/s\n", speed, records, packets,
+                    elapsed_s, static_cast<double>(records) / elapsed_s);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Logger::setLogLevel(Logger::OFF);
+
+    std::string path = argc > 1 ? argv[1] : DEFAULT_PATH;
+    if (argc <= 1) {
+        benchRecord(path, 100000);
+    }
+
+    serial::Recording recording = serial::Recording::fromFile(path);
+    std::printf("录制文件 %s：%zu 条记录，时长 %.3f s\n", path.c_str(), recording.records().size(),
+                static_cast<double>(recording.duration()) / 1e9);
+
+    benchReplay(recording, 0, 3);
+    // 加速回放，检验按时序回放的开销
+    benchReplay(recording, 1000, 1);
+    return 0;
+}
@@ -0,0 +1,130 @@
+//
+// Created by noodles on 26-10-18.
+// 串口往返延迟测试：开启 / 关闭低延迟模式时 ping 的往返时间
+//
+// 默认使用伪终端回环，对端线程把收到的数据原样发回；
+// 传入串口路径（TX / RX 短接的 USB 串口）时测量真实适配器：
+//   serial_latency_bench /dev/ttyUSB0 [baudrate]
+//
+#include "pty_pair.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+    // 伪终端对端：收到数据后原样发回，split_us > 0 时分两半发回，模拟 USB 串口按包上报
+    class EchoPeer {
+    public:
+        EchoPeer(const PtyPair &pty, uint32_t split_us) : pty_(pty), split_us_(split_us) {
+            running_ = true;
+            thread_ = std::thread(&EchoPeer::run, this);
+        }
+
+        ~EchoPeer() {
+            running_ = false;
+            thread_.join();
+        }
+
+    private:
+        void run() {
+            uint8_t buffer[256];
+            while (running_) {
+                struct pollfd pfd = {pty_.master_fd, POLLIN, 0};
+                if (::poll(&pfd, 1, 10) <= 0) {
+                    continue;
+                }
+                ssize_t n = ::read(pty_.master_fd, buffer, sizeof(buffer));
+                if (n <= 0) {
+                    continue;
+                }
+                size_t half = split_us_ > 0 ? static_cast<size_t>(n) / 2 : static_cast<size_t>(n);
+                ::write(pty_.master_fd, buffer, half);
+                if (half < static_cast<size_t>(n)) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(split_us_));
+                    ::write(pty_.master_fd, buffer + half, static_cast<size_t>(n) - half);
+                }
+            }
+        }
+
+        const PtyPair &pty_;
+        uint32_t split_us_;
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+    };
+
+    void benchPing(serial::Serial &port, size_t size, bool low_latency, const char *label, size_t count = 500) {
+        serial::LowLatencyInfo info = port.setLowLatency(low_latency);
+
+        std::vector<uint8_t> ping(size), pong(size);
+        for (size_t i = 0; i < size; ++i) {
+            ping[i] = static_cast<uint8_t>(i * 7 + 1);
+        }
+
+        std::vector<double> rtt_us;
+        size_t lost = 0;
+        port.flushInput();
+        for (size_t i = 0; i < count; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            port.write(ping.data(), ping.size());
+            size_t n = port.read(pong.data(), pong.size());
+            auto end = std::chrono::steady_clock::now();
+            if (n != size) {
+                ++lost;
+                port.flushInput();
+                continue;
+            }
+            rtt_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        if (rtt_us.empty()) {
+            std::printf("  %-10s %4zu B, low latency %-3s: 全部超时\n", label, size, low_latency ? "on" : "off");
+            return;
+        }
+        std::sort(rtt_us.begin(), rtt_us.end());
+        std::printf("  %-10s %4zu B, low latency %-3s: min %8.1f us, p50 %8.1f us, p99 %8.1f us, 超时 %zu\n",
+                    label, size, low_latency ? "on" : "off", rtt_us.front(), rtt_us[rtt_us.size() / 2],
+                    rtt_us[rtt_us.size() * 99 / 100], lost);
+        if (low_latency) {
+            std::printf("             applied: %s\n", info.details.c_str());
+        }
+    }
+
+    void benchPty(uint32_t split_us) {
+        PtyPair pty;
+        EchoPeer peer(pty, split_us);
+        serial::Serial port(pty.port, 115200, serial::Timeout::simpleTimeout(100));
+
+        const char *label = split_us > 0 ? "pty split" : "pty";
+        for (size_t size: {8, 64}) {
+            benchPing(port, size, false, label);
+            benchPing(port, size, true, label);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Logger::setLogLevel(Logger::OFF);
+
+    if (argc > 1) {
+        uint32_t baudrate = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 115200;
+        serial::Serial port(argv[1], baudrate, serial::Timeout::simpleTimeout(200));
+        std::printf("串口回环 %s @ %u\n", argv[1], baudrate);
+        for (size_t size: {8, 64}) {
+            benchPing(port, size, false, "loopback", 200);
+            benchPing(port, size, true, "loopback", 200);
+        }
+        port.setLowLatency(false);
+        return 0;
+    }
+
+    std::printf("伪终端回环（115200）\n");
+    benchPty(0);
+    // 对端分两次发回，间隔 200 us
+    benchPty(200);
+    return 0;
+}
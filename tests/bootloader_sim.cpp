@@ -0,0 +1,286 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#include <chrono>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include "bootloader_sim.h"
+#include "crc16.h"
+
+namespace {
+    const uint8_t SOH = 0x01;
+    const uint8_t STX = 0x02;
+    const uint8_t EOT = 0x04;
+    const uint8_t ACK = 0x06;
+    const uint8_t NAK = 0x15;
+    const uint8_t CAN = 0x18;
+    const uint8_t HANDSHAKE_REQUEST = 0x64;
+    const uint8_t HANDSHAKE_REPLY = 0x43;
+    const uint8_t BAUD_SWITCH = 0x62;
+    const uint8_t SERVO_HEADER = 0xFF;
+
+    // 最后一块的 CRC 只覆盖实际数据，补零长度未知，逐个尝试去掉末尾的 0
+    bool crcMatches(const uint8_t *data, size_t size, uint16_t crc) {
+        if (crc16::xmodem(data, size) == crc) {
+            return true;
+        }
+        while (size > 0 && data[size - 1] == 0) {
+            --size;
+            if (crc16::xmodem(data, size) == crc) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+BootloaderSimulator::BootloaderSimulator(const BootloaderSimOptions &options) : options_(options) {
+    char name[128] = {0};
+    if (::openpty(&master_fd_, &slave_fd_, name, nullptr, nullptr) != 0) {
+        throw std::runtime_error("openpty failed");
+    }
+    port_ = name;
+
+    // 从设备保持打开，串口关闭重开时主设备不会收到挂断
+    struct termios options_tty;
+    ::tcgetattr(slave_fd_, &options_tty);
+    ::cfmakeraw(&options_tty);
+    ::tcsetattr(slave_fd_, TCSANOW, &options_tty);
+
+    running_ = true;
+    thread_ = std::thread(&BootloaderSimulator::run, this);
+}
+
+BootloaderSimulator::~BootloaderSimulator() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ::close(master_fd_);
+    ::close(slave_fd_);
+}
+
+std::vector<uint8_t> BootloaderSimulator::image() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return image_;
+}
+
+bool BootloaderSimulator::waitCompleted(int timeout_ms) const {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!completed_) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+void BootloaderSimulator::run() {
+    while (running_) {
+        uint8_t byte = 0;
+        if (!readExact(&byte, 1, 20)) {
+            continue;
+        }
+
+        if (byte == SERVO_HEADER) {
+            handleServoPacket();
+            continue;
+        }
+        if (!in_bootloader_) {
+            continue;
+        }
+
+        switch (byte) {
+            case HANDSHAKE_REQUEST:
+                pace(1);
+                if (!options_.allow_resume) {
+                    resetSession();
+                }
+                reply(HANDSHAKE_REPLY);
+                break;
+            case SOH:
+                handleFrame(128);
+                break;
+            case STX:
+                handleFrame(1024);
+                break;
+            case BAUD_SWITCH:
+                handleBaudSwitch();
+                break;
+            case EOT:
+                pace(1);
+                completed_ = true;
+                reply(ACK);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool BootloaderSimulator::readExact(uint8_t *data, size_t size, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    size_t received = 0;
+    while (received < size) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        struct pollfd pfd = {master_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>(remaining)) <= 0) {
+            continue;
+        }
+        ssize_t n = ::read(master_fd_, data + received, size - received);
+        if (n > 0) {
+            received += static_cast<size_t>(n);
+        }
+    }
+    return true;
+}
+
+void BootloaderSimulator::reply(uint8_t byte) {
+    if (options_.reply_delay_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(options_.reply_delay_ms));
+    }
+    pace(1);
+    if (::write(master_fd_, &byte, 1) != 1) {
+        return;
+    }
+    if (byte == NAK) {
+        ++naks_sent_;
+    }
+}
+
+void BootloaderSimulator::pace(size_t bytes) {
+    if (!options_.pace) {
+        return;
+    }
+    // 8N1：每字节 10 位
+    auto us = static_cast<long long>(bytes) * 10 * 1000000LL / baudrate_;
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void BootloaderSimulator::resetSession() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    image_.clear();
+    next_block_ = 0;
+    completed_ = false;
+}
+
+void BootloaderSimulator::handleServoPacket() {
+    // 舵机指令包：[0xFF] [0xFF] [ID] [长度] [指令 + 参数 + 校验和（共“长度”字节）]
+    uint8_t head[3];
+    if (!readExact(head, sizeof(head), 100) || head[0] != SERVO_HEADER) {
+        return;
+    }
+    std::vector<uint8_t> rest(head[2]);
+    if (!readExact(rest.data(), rest.size(), 100)) {
+        return;
+    }
+
+    // 应答一个状态包，然后“重启”进入 Bootloader
+    uint8_t id = head[1];
+    uint8_t status[] = {0xFF, 0xFF, id, 0x02, 0x00, static_cast<uint8_t>(~(id + 0x02))};
+    if (::write(master_fd_, status, sizeof(status)) != static_cast<ssize_t>(sizeof(status))) {
+        return;
+    }
+
+    resetSession();
+    ++resets_;
+    in_bootloader_ = true;
+    baudrate_ = 9600;
+}
+
+void BootloaderSimulator::handleFrame(size_t block_size) {
+    if (block_size == 1024 && !options_.support_1k) {
+        // 不支持 1K 的 Bootloader 把后面的数据当作噪声丢弃，然后要求重发
+        uint8_t discard[256];
+        while (readExact(discard, 1, 20)) {
+        }
+        reply(NAK);
+        return;
+    }
+
+    std::vector<uint8_t> body(block_size + 4);
+    bool complete = readExact(body.data(), body.size(), 2000);
+    pace(1 + body.size());
+    if (!complete) {
+        reply(NAK);
+        return;
+    }
+
+    // 故障注入
+    size_t reception = ++frames_received_;
+    if (options_.cancel_at > 0 && reception == options_.cancel_at) {
+        uint8_t cancel[] = {CAN, CAN};
+        if (::write(master_fd_, cancel, sizeof(cancel)) != static_cast<ssize_t>(sizeof(cancel))) {
+            return;
+        }
+        resetSession();
+        return;
+    }
+    if ((options_.drop_every > 0 && reception % options_.drop_every == 0) ||
+        (options_.drop_from > 0 && reception >= options_.drop_from &&
+         reception < options_.drop_from + options_.drop_count)) {
+        return;
+    }
+    if (options_.nak_every > 0 && reception % options_.nak_every == 0) {
+        reply(NAK);
+        return;
+    }
+
+    uint8_t packet_number = body[0];
+    const uint8_t *data = &body[2];
+    uint16_t crc = static_cast<uint16_t>((body[block_size + 2] << 8) | body[block_size + 3]);
+    if (static_cast<uint8_t>(packet_number + body[1]) != 0xFF || !crcMatches(data, block_size, crc)) {
+        reply(NAK);
+        return;
+    }
+
+    block_size_ = block_size;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (packet_number == static_cast<uint8_t>(next_block_ + 1)) {
+            image_.insert(image_.end(), data, data + block_size);
+            ++next_block_;
+        } else if (packet_number != static_cast<uint8_t>(next_block_)) {
+            // 既不是下一块也不是重发的上一块
+            reply(NAK);
+            return;
+        }
+    }
+
+    if (options_.flash_write_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(options_.flash_write_us));
+    }
+    ++frames_accepted_;
+    reply(ACK);
+}
+
+void BootloaderSimulator::handleBaudSwitch() {
+    // [0x62] [波特率 4 字节，高位在前] [CRC 高字节] [CRC 低字节]
+    uint8_t body[6];
+    bool complete = readExact(body, sizeof(body), 500);
+    pace(1 + sizeof(body));
+    if (!complete || !options_.support_baud_switch) {
+        return;
+    }
+
+    uint16_t crc = static_cast<uint16_t>((body[4] << 8) | body[5]);
+    if (crc16::xmodem(body, 4) != crc) {
+        reply(NAK);
+        return;
+    }
+
+    reply(ACK);
+    baudrate_ = (static_cast<uint32_t>(body[0]) << 24) | (static_cast<uint32_t>(body[1]) << 16) |
+                (static_cast<uint32_t>(body[2]) << 8) | body[3];
+}
@@ -0,0 +1,128 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_BOOTLOADER_SIM_H
+#define UP_CORE_BOOTLOADER_SIM_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * 模拟 Bootloader 的行为选项
+ */
+struct BootloaderSimOptions {
+    bool support_1k = true;             // 是否接受 XMODEM-1K 数据帧
+    bool support_baud_switch = true;    // 是否响应切换波特率请求
+    bool allow_resume = true;           // 重新握手后是否保留已接收的数据（支持续传）
+    bool pace = true;                   // 是否按当前波特率模拟线路传输时间
+    uint32_t flash_write_us = 0;        // 每个数据块写入 Flash 的耗时（微秒）
+
+    // 故障注入，按收到的数据帧计数（从 1 开始，含重发）
+    size_t nak_every = 0;               // 每收到第 N 帧应答 NAK，0 表示不注入
+    size_t drop_every = 0;              // 每收到第 N 帧不应答（模拟丢帧），0 表示不注入
+    size_t drop_from = 0;               // 从第 N 帧开始连续 drop_count 帧不应答，0 表示不注入
+    size_t drop_count = 0;
+    size_t cancel_at = 0;               // 收到第 N 帧时发送 CAN CAN 取消传输，0 表示不注入
+    uint32_t reply_delay_ms = 0;        // 每次应答前额外等待的时间（毫秒）
+};
+
+/**
+ * 基于伪终端的舵机 Bootloader 模拟器
+ *
+ * 打开一对 pty，FirmwareUpdate 通过 port() 返回的从设备名打开串口，
+ * 模拟器在后台线程中读写主设备：
+ *  - 收到舵机指令包（0xFF 0xFF 开头）时应答并进入 Bootloader 模式
+ *  - 握手请求 0x64 应答 0x43
+ *  - 校验 128 字节（SOH）/ 1K（STX）数据帧的包序号和 CRC，应答 ACK / NAK
+ *  - 切换波特率请求 0x62 校验后应答 ACK，之后按新波特率计时
+ *  - 结束标志 0x04 应答 ACK
+ *
+ * 可按 BootloaderSimOptions 注入 NAK、丢帧、取消和应答延迟，并按波特率模拟线路传输时间。
+ */
+class BootloaderSimulator {
+public:
+    explicit BootloaderSimulator(const BootloaderSimOptions &options);
+
+    BootloaderSimulator() : BootloaderSimulator(BootloaderSimOptions()) {}
+
+    ~BootloaderSimulator();
+
+    BootloaderSimulator(const BootloaderSimulator &) = delete;
+
+    BootloaderSimulator &operator=(const BootloaderSimulator &) = delete;
+
+    /** @brief 供串口打开的从设备名，如 /dev/pts/3 */
+    const std::string &port() const { return port_; }
+
+    /** @brief 已接收的固件数据（最后一块包含补零） */
+    std::vector<uint8_t> image() const;
+
+    /** @brief 是否收到了结束标志 */
+    bool completed() const { return completed_; }
+
+    /** @brief 等待收到结束标志，超时返回 false */
+    bool waitCompleted(int timeout_ms) const;
+
+    /** @brief 收到的数据帧数（含重发和注入故障的帧） */
+    size_t framesReceived() const { return frames_received_; }
+
+    size_t framesAccepted() const { return frames_accepted_; }
+
+    size_t naksSent() const { return naks_sent_; }
+
+    /** @brief 收到复位指令（进入 Bootloader）的次数 */
+    size_t resets() const { return resets_; }
+
+    /** @brief 最近一帧的数据块大小 */
+    size_t blockSize() const { return block_size_; }
+
+    /** @brief 当前 Bootloader 通信波特率 */
+    uint32_t baudrate() const { return baudrate_; }
+
+private:
+    BootloaderSimOptions options_;
+    int master_fd_{-1};
+    int slave_fd_{-1};
+    std::string port_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex mutex_;
+    std::vector<uint8_t> image_;
+    bool in_bootloader_{false};
+    size_t next_block_{0};
+
+    std::atomic<bool> completed_{false};
+    std::atomic<size_t> frames_received_{0};
+    std::atomic<size_t> frames_accepted_{0};
+    std::atomic<size_t> naks_sent_{0};
+    std::atomic<size_t> resets_{0};
+    std::atomic<size_t> block_size_{0};
+    std::atomic<uint32_t> baudrate_{9600};
+
+    void run();
+
+    /** @brief 读取 size 字节，timeout_ms 内读不满返回 false */
+    bool readExact(uint8_t *data, size_t size, int timeout_ms);
+
+    void reply(uint8_t byte);
+
+    /** @brief 按当前波特率等待 bytes 字节在线路上的传输时间 */
+    void pace(size_t bytes);
+
+    void resetSession();
+
+    void handleServoPacket();
+
+    void handleFrame(size_t block_size);
+
+    void handleBaudSwitch();
+};
+
+#endif //UP_CORE_BOOTLOADER_SIM_H
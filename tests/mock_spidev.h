@@ -0,0 +1,62 @@
+//
+// Created by noodles on 26-10-18.
+//
+
+#ifndef UP_CORE_MOCK_SPIDEV_H
+#define UP_CORE_MOCK_SPIDEV_H
+
+#include "unix/spi.h"
+#include <vector>
+#include <stdint.h>
+
+/**
+ * 模拟 spidev 后端：重写 SPI::message，不打开设备文件，在任何 Linux 机器上都能运行
+ *
+ * 按 MCP3008 的协议应答：每段传输的第 2 个字节高 4 位为 0x80 | (通道 << 4)，
+ * 应答的第 2、3 个字节是该通道的 10 位采样值 values[通道]。
+ * 记录每次提交的消息，供测试检查段数、长度和片选设置。
+ */
+class MockSpidev : public spi::SPI {
+public:
+    explicit MockSpidev(uint8_t channel_count)
+            : spi::SPI("/dev/mock-spidev", 1000000, 0, 8), values(channel_count, 0) {
+    }
+
+    std::vector<uint16_t> values;         // 各通道的采样值（10 位）
+    uint16_t step = 0;                    // 每条消息之后各通道的采样值增加 step（模拟变化的信号）
+    bool fail = false;                    // 为 true 时模拟 ioctl 失败
+    size_t messages = 0;                  // 提交的消息数（即 ioctl 调用次数）
+    std::vector<struct spi_ioc_transfer> last; // 最近一次消息的传输段
+
+protected:
+    void message(struct spi_ioc_transfer *transfers, size_t count) override {
+        ++messages;
+        if (fail) {
+            throw spi::SPIException("SPI 传输失败: 模拟错误");
+        }
+        last.assign(transfers, transfers + count);
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t *tx = reinterpret_cast<const uint8_t *>(static_cast<uintptr_t>(transfers[i].tx_buf));
+            uint8_t *rx = reinterpret_cast<uint8_t *>(static_cast<uintptr_t>(transfers[i].rx_buf));
+            if (rx == nullptr) {
+                continue;
+            }
+            for (size_t j = 0; j < transfers[i].len; ++j) {
+                rx[j] = 0xFF; // 未驱动的 MISO
+            }
+            if (tx == nullptr || transfers[i].len < 3 || tx[0] != 0x01 || (tx[1] & 0x80) == 0) {
+                continue;
+            }
+            uint8_t channel = (tx[1] >> 4) & 0x07;
+            uint16_t value = channel < values.size() ? values[channel] : 0;
+            rx[0] = 0x00;
+            rx[1] = static_cast<uint8_t>(0xF8 | ((value >> 8) & 0x03)); // 高位填充无关位，验证掩码
+            rx[2] = static_cast<uint8_t>(value & 0xFF);
+        }
+        for (uint16_t &value: values) {
+            value = static_cast<uint16_t>((value + step) & 0x3FF);
+        }
+    }
+};
+
+#endif //UP_CORE_MOCK_SPIDEV_H
@@ -0,0 +1,79 @@
+//
+// Created by noodles on 26-10-18.
+// 测试和性能测试共用的伪终端对
+//
+
+#ifndef UP_CORE_PTY_PAIR_H
+#define UP_CORE_PTY_PAIR_H
+
+#include "serial/serial.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+// 一对伪终端，串口打开从设备，测试直接读写主设备
+class PtyPair {
+public:
+    PtyPair() {
+        char name[128] = {0};
+        if (::openpty(&master_fd, &slave_fd, name, nullptr, nullptr) != 0) {
+            throw std::runtime_error("openpty failed");
+        }
+        port = name;
+
+        struct termios options;
+        ::tcgetattr(slave_fd, &options);
+        ::cfmakeraw(&options);
+        ::tcsetattr(slave_fd, TCSANOW, &options);
+    }
+
+    ~PtyPair() {
+        closeMaster();
+        ::close(slave_fd);
+    }
+
+    std::shared_ptr<serial::Serial> open() const {
+        return std::make_shared<serial::Serial>(port, 115200, serial::Timeout::simpleTimeout(100));
+    }
+
+    bool write(const std::string &data) const {
+        return ::write(master_fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    }
+
+    // 从主设备读取 size 字节，超时返回已读到的数据
+    std::string read(size_t size, int timeout_ms = 1000) const {
+        std::string data;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (data.size() < size && std::chrono::steady_clock::now() < deadline) {
+            struct pollfd pfd = {master_fd, POLLIN, 0};
+            if (::poll(&pfd, 1, 10) <= 0) {
+                continue;
+            }
+            char buffer[256];
+            ssize_t n = ::read(master_fd, buffer, std::min(sizeof(buffer), size - data.size()));
+            if (n > 0) {
+                data.append(buffer, static_cast<size_t>(n));
+            }
+        }
+        return data;
+    }
+
+    void closeMaster() {
+        if (master_fd >= 0) {
+            ::close(master_fd);
+            master_fd = -1;
+        }
+    }
+
+    std::string port;
+    int master_fd{-1};
+    int slave_fd{-1};
+};
+
+#endif //UP_CORE_PTY_PAIR_H
@@ -0,0 +1,269 @@
+//
+// Created by noodles on 26-10-18.
+// ADC 批量读取和定频采样测试：使用模拟 spidev 后端，不需要真实设备
+//
+#include "unix/adc.h"
+#include "unix/sampler.h"
+#include "mock_spidev.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace {
+    MockSpidev *makeSpi(uint8_t channels) {
+        MockSpidev *spi = new MockSpidev(channels);
+        for (uint8_t i = 0; i < channels; ++i) {
+            spi->values[i] = static_cast<uint16_t>(1023 - i * 100);
+        }
+        return spi;
+    }
+}
+
+TEST(ADCBatchTest, ReadAllUsesSingleMessage) {
+    std::unique_ptr<MockSpidev> spi(makeSpi(8));
+    adc::ADC adc(*spi, 8);
+
+    uint16_t values[8] = {0};
+    EXPECT_EQ(8u, adc.readAll(values, 8));
+    EXPECT_EQ(1u, spi->messages);
+    for (uint8_t i = 0; i < 8; ++i) {
+        EXPECT_EQ(spi->values[i], values[i]) << "通道 " << int(i);
+    }
+
+    // 每个通道一段 3 字节的传输，段之间释放片选，使用 SPI 对象的速度和位宽
+    ASSERT_EQ(8u, spi->last.size());
+    for (size_t i = 0; i < spi->last.size(); ++i) {
+        EXPECT_EQ(3u, spi->last[i].len);
+        EXPECT_EQ(i + 1 < spi->last.size() ? 1 : 0, spi->last[i].cs_change);
+        EXPECT_EQ(spi->getSpeed(), spi->last[i].speed_hz);
+        EXPECT_EQ(spi->getBitsPerWord(), spi->last[i].bits_per_word);
+    }
+
+    // 返回 vector 的接口同样只提交一条消息
+    std::vector<uint16_t> all = adc.readAll();
+    EXPECT_EQ(2u, spi->messages);
+    EXPECT_EQ(std::vector<uint16_t>(spi->values.begin(), spi->values.end()), all);
+}
+
+TEST(ADCBatchTest, ReadChannelsInRequestedOrder) {
+    std::unique_ptr<MockSpidev> spi(makeSpi(8));
+    adc::ADC adc(*spi, 8);
+
+    const uint8_t channels[] = {7, 0, 3, 3};
+    uint16_t values[4] = {0};
+    adc.readChannels(channels, 4, values);
+    EXPECT_EQ(1u, spi->messages);
+    EXPECT_EQ(spi->values[7], values[0]);
+    EXPECT_EQ(spi->values[0], values[1]);
+    EXPECT_EQ(spi->values[3], values[2]);
+    EXPECT_EQ(spi->values[3], values[3]);
+
+    // 与逐通道读取的结果一致
+    EXPECT_EQ(spi->values[7], adc.readChannel(7));
+    EXPECT_EQ(2u, spi->messages);
+}
+
+TEST(ADCBatchTest, ErrorsBeforeAndDuringTransfer) {
+    std::unique_ptr<MockSpidev> spi(makeSpi(4));
+    adc::ADC adc(*spi, 4);
+
+    // 无效通道和过小的缓冲区在提交之前报错
+    const uint8_t channels[] = {1, 4};
+    uint16_t values[4] = {0};
+    EXPECT_THROW(adc.readChannels(channels, 2, values), adc::ADCException);
+    EXPECT_THROW(adc.readAll(values, 3), adc::ADCException);
+    EXPECT_EQ(0u, spi->messages);
+
+    spi->fail = true;
+    EXPECT_THROW(adc.readAll(values, 4), spi::SPIException);
+    EXPECT_EQ(1u, spi->messages);
+}
+
+TEST(ADCBatchTest, UninitializedDeviceThrows) {
+    spi::SPI spi("/dev/does-not-exist", 1000000, 0, 8);
+    adc::ADC adc(spi, 2);
+    uint16_t values[2];
+    EXPECT_THROW(adc.readAll(values, 2), spi::SPIException);
+}
+
+TEST(SPIBatchTest, PerSegmentSettings) {
+    MockSpidev spi(1);
+    uint8_t tx[4] = {1, 2, 3, 4};
+    uint8_t rx[4] = {0};
+    struct spi_ioc_transfer transfers[2] = {};
+    transfers[0].tx_buf = (unsigned long) tx;
+    transfers[0].len = 2;
+    transfers[0].speed_hz = 500000;
+    transfers[0].cs_change = 1;
+    transfers[1].tx_buf = (unsigned long) (tx + 2);
+    transfers[1].rx_buf = (unsigned long) rx;
+    transfers[1].len = 2;
+    spi.transferBatch(transfers, 2);
+
+    // 指定的速度保留，未指定的使用 SPI 对象的设置
+    ASSERT_EQ(1u, spi.messages);
+    ASSERT_EQ(2u, spi.last.size());
+    EXPECT_EQ(500000u, spi.last[0].speed_hz);
+    EXPECT_EQ(1, spi.last[0].cs_change);
+    EXPECT_EQ(spi.getSpeed(), spi.last[1].speed_hz);
+    EXPECT_EQ(spi.getBitsPerWord(), spi.last[1].bits_per_word);
+
+    spi.transferBatch(transfers, 0);
+    EXPECT_EQ(1u, spi.messages);
+    std::vector<struct spi_ioc_transfer> many(spi::SPI::MAX_TRANSFERS + 1);
+    EXPECT_THROW(spi.transferBatch(many.data(), many.size()), spi::SPIException);
+}
+
+TEST(SamplerTest, FixedRateTimestampedSamples) {
+    std::unique_ptr<MockSpidev> spi(makeSpi(8));
+    adc::ADC adc(*spi, 8);
+
+    adc::SamplerOptions options;
+    options.channels = {2, 5};
+    options.rate_hz = 1000;
+    adc::Sampler sampler(adc, options);
+    sampler.start();
+    EXPECT_TRUE(sampler.running());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    sampler.stop();
+    EXPECT_FALSE(sampler.running());
+    EXPECT_TRUE(sampler.lastError().empty());
+
+    // 每次扫描一条 SPI 消息；扫描次数按时间表计算，错过的时刻不补扫
+    EXPECT_EQ(sampler.scans(), spi->messages);
+    EXPECT_GE(sampler.scans() + sampler.missed(), 150u);
+    EXPECT_LE(sampler.scans(), 210u);
+
+    size_t count = sampler.available();
+    ASSERT_EQ(sampler.scans(), count);
+    std::vector<uint64_t> times(count);
+    std::vector<uint16_t> values(count * 2);
+    ASSERT_EQ(count, sampler.read(times.data(), values.data(), count));
+    EXPECT_EQ(0u, sampler.available());
+
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(spi->values[2], values[i * 2]);
+        EXPECT_EQ(spi->values[5], values[i * 2 + 1]);
+        if (i > 0) {
+            EXPECT_GT(times[i], times[i - 1]);
+        }
+    }
+    // 平均间隔接近 1 ms
+    double mean_ms = (times.back() - times.front()) / 1e6 / (count - 1);
+    EXPECT_NEAR(1.0, mean_ms * count / (count + sampler.missed()), 0.2);
+}
+
+TEST(SamplerTest, DecimationAndMinMax) {
+    std::unique_ptr<MockSpidev> spi(new MockSpidev(4));
+    spi->values = {100, 200, 300, 400};
+    spi->step = 1;
+    adc::ADC adc(*spi, 4);
+
+    adc::SamplerOptions options;
+    options.channels = {0, 3};
+    options.rate_hz = 2000;
+    options.decimation = 4;
+    adc::Sampler sampler(adc, options);
+    sampler.start();
+    while (sampler.available() < 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sampler.stop();
+
+    // 第 k 个样本平均第 4k .. 4k+3 次扫描：v + 4k + 1.5，四舍五入为 v + 4k + 2
+    size_t first = 0;
+    size_t count = sampler.peek(&first);
+    ASSERT_EQ(0u, first);
+    ASSERT_GE(count, 10u);
+    const uint16_t *values = sampler.valueData();
+    for (size_t k = 0; k < count; ++k) {
+        EXPECT_EQ(100 + 4 * k + 2, values[k * 2]);
+        EXPECT_EQ(400 + 4 * k + 2, values[k * 2 + 1]);
+    }
+    EXPECT_EQ(count, sampler.scans() / 4);
+
+    // 最小 / 最大值统计原始读数
+    EXPECT_EQ(std::vector<uint16_t>({100, 400}), sampler.minimum());
+    EXPECT_EQ(std::vector<uint16_t>({static_cast<uint16_t>(100 + sampler.scans() - 1),
+                                     static_cast<uint16_t>(400 + sampler.scans() - 1)}), sampler.maximum());
+
+    sampler.consume(count);
+    EXPECT_EQ(0u, sampler.available());
+}
+
+TEST(SamplerTest, OverrunKeepsUnreadSamples) {
+    std::unique_ptr<MockSpidev> spi(new MockSpidev(2));
+    spi->step = 1;
+    adc::ADC adc(*spi, 2);
+
+    adc::SamplerOptions options;
+    options.channels = {0};
+    options.rate_hz = 5000;
+    options.capacity = 8;
+    adc::Sampler sampler(adc, options);
+    sampler.start();
+    while (sampler.overruns() < 5) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 缓冲区满后保留最早的 8 个样本，peek 返回的内存不会被改写
+    EXPECT_EQ(8u, sampler.available());
+    size_t first = 0;
+    ASSERT_EQ(8u, sampler.peek(&first));
+    std::vector<uint16_t> snapshot(sampler.valueData(), sampler.valueData() + 8);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(snapshot, std::vector<uint16_t>(sampler.valueData(), sampler.valueData() + 8));
+    for (size_t i = 1; i < snapshot.size(); ++i) {
+        EXPECT_EQ(snapshot[i - 1] + 1, snapshot[i]);
+    }
+
+    // 取走一部分后继续写入，新样本跨过缓冲区末尾
+    sampler.consume(5);
+    while (sampler.available() < 8) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sampler.stop();
+    uint64_t times[8];
+    uint16_t values[8];
+    ASSERT_EQ(8u, sampler.read(times, values, 8));
+    EXPECT_EQ(snapshot[5], values[0]);
+    EXPECT_EQ(snapshot[7], values[2]);
+    EXPECT_GT(values[3], values[2]);
+}
+
+TEST(SamplerTest, InvalidOptionsAndReadErrors) {
+    std::unique_ptr<MockSpidev> spi(makeSpi(4));
+    adc::ADC adc(*spi, 4);
+
+    adc::SamplerOptions options;
+    EXPECT_THROW(adc::Sampler(adc, options), adc::ADCException);
+    options.channels = {4};
+    EXPECT_THROW(adc::Sampler(adc, options), adc::ADCException);
+    options.channels = {0};
+    options.rate_hz = 0;
+    EXPECT_THROW(adc::Sampler(adc, options), adc::ADCException);
+    options.rate_hz = 100;
+    options.capacity = 0;
+    EXPECT_THROW(adc::Sampler(adc, options), adc::ADCException);
+
+    // 读取失败时采样线程停止并保存错误信息
+    options.capacity = 16;
+    adc::Sampler sampler(adc, options);
+    spi->fail = true;
+    sampler.start();
+    while (sampler.running()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_NE(std::string::npos, sampler.lastError().find("SPIException"));
+    EXPECT_EQ(0u, sampler.available());
+
+    // 可以重新启动
+    spi->fail = false;
+    sampler.start();
+    while (sampler.available() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sampler.stop();
+    EXPECT_TRUE(sampler.lastError().empty());
+}
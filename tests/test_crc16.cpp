@@ -0,0 +1,108 @@
+//
+// Created by noodles on 26-10-18.
+//
+#include "crc16.h"
+#include "firmware_image.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <vector>
+
+TEST(CRC16Test, CheckValue) {
+    // CRC-16/XMODEM 标准校验值
+    const char *check = "123456789";
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(check);
+    size_t length = std::strlen(check);
+
+    EXPECT_EQ(0x31C3, crc16::xmodemBitwise(data, length));
+    EXPECT_EQ(0x31C3, crc16::xmodemTable(data, length));
+    EXPECT_EQ(0x31C3, crc16::xmodemSlicing8(data, length));
+    EXPECT_EQ(0x31C3, crc16::xmodem(data, length));
+}
+
+TEST(CRC16Test, ImplementationsAgree) {
+    std::mt19937 rng(12345);
+    std::vector<uint8_t> data(1031);
+    for (auto &byte: data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    // 覆盖各种长度和非 8 字节对齐的尾部
+    for (size_t length = 0; length <= data.size(); length += 7) {
+        uint16_t expected = crc16::xmodemBitwise(data.data(), length);
+        EXPECT_EQ(expected, crc16::xmodemTable(data.data(), length)) << "length " << length;
+        EXPECT_EQ(expected, crc16::xmodemSlicing8(data.data(), length)) << "length " << length;
+    }
+}
+
+TEST(CRC16Test, Incremental) {
+    std::vector<uint8_t> data(300);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    uint16_t whole = crc16::xmodem(data.data(), data.size());
+    uint16_t part = crc16::xmodem(data.data(), 123);
+    part = crc16::xmodem(data.data() + 123, data.size() - 123, part);
+    EXPECT_EQ(whole, part);
+}
+
+TEST(FirmwareFrameStreamTest, BuildFrames) {
+    // 两个完整块加一个 10 字节的尾块
+    std::vector<uint8_t> image(128 * 2 + 10);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i);
+    }
+
+    FirmwareFrameStream frames(image.data(), image.size());
+    ASSERT_EQ(3u, frames.frameCount());
+
+    for (size_t index = 0; index < frames.frameCount(); ++index) {
+        const std::vector<uint8_t> &frame = frames.frame(index);
+        ASSERT_EQ(FirmwareFrameStream::FRAME_SIZE, frame.size());
+
+        uint8_t packetNumber = static_cast<uint8_t>(index + 1);
+        EXPECT_EQ(0x01, frame[0]);
+        EXPECT_EQ(packetNumber, frame[1]);
+        EXPECT_EQ(255 - packetNumber, frame[2]);
+
+        size_t offset = index * 128;
+        size_t copySize = std::min<size_t>(image.size() - offset, 128);
+        EXPECT_EQ(0, std::memcmp(&frame[3], &image[offset], copySize));
+        for (size_t i = 3 + copySize; i < 131; ++i) {
+            EXPECT_EQ(0, frame[i]) << "padding byte " << i;
+        }
+
+        // CRC 只覆盖实际数据部分
+        uint16_t crc = crc16::xmodemBitwise(&image[offset], copySize);
+        EXPECT_EQ(crc >> 8, frame[131]);
+        EXPECT_EQ(crc & 0xFF, frame[132]);
+    }
+}
+
+TEST(FirmwareFrameStreamTest, BuildFrames1K) {
+    std::vector<uint8_t> image(1024 + 300);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    FirmwareFrameStream frames(image.data(), image.size(), FirmwareFrameStream::BLOCK_SIZE_1K);
+    ASSERT_EQ(2u, frames.frameCount());
+    ASSERT_EQ(1029u, frames.frameSize());
+
+    const std::vector<uint8_t> &last = frames.frame(1);
+    ASSERT_EQ(1029u, last.size());
+    EXPECT_EQ(0x02, last[0]);
+    EXPECT_EQ(2, last[1]);
+    EXPECT_EQ(253, last[2]);
+    EXPECT_EQ(0, std::memcmp(&last[3], &image[1024], 300));
+    uint16_t crc = crc16::xmodemBitwise(&image[1024], 300);
+    EXPECT_EQ(crc >> 8, last[1027]);
+    EXPECT_EQ(crc & 0xFF, last[1028]);
+
+    // 回退到 128 字节后帧序号重新划分
+    frames.setBlockSize(FirmwareFrameStream::BLOCK_SIZE);
+    ASSERT_EQ(11u, frames.frameCount());
+    EXPECT_EQ(0x01, frames.frame(0)[0]);
+    EXPECT_EQ(FirmwareFrameStream::FRAME_SIZE, frames.frame(10).size());
+}
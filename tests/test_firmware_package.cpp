@@ -0,0 +1,106 @@
+//
+// Created by noodles on 26-10-18.
+//
+#include "crc32.h"
+#include "firmware_package.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    std::vector<uint8_t> makeImage(size_t size) {
+        std::vector<uint8_t> image(size);
+        for (size_t i = 0; i < size; ++i) {
+            image[i] = static_cast<uint8_t>(i * 131 + 17);
+        }
+        return image;
+    }
+}
+
+TEST(CRC32Test, CheckValue) {
+    // CRC-32/IEEE 标准校验值
+    const char *check = "123456789";
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(check);
+
+    EXPECT_EQ(0xCBF43926u, crc32::compute(data, 9));
+    EXPECT_EQ(0xCBF43926u, crc32::compute(data + 4, 5, crc32::compute(data, 4)));
+}
+
+TEST(FirmwarePackageTest, RoundTrip) {
+    std::vector<uint8_t> image = makeImage(128 * 5 + 37);
+    std::vector<uint8_t> packed = FirmwarePackage::pack(image.data(), image.size(), "CDS5516", "1.0");
+    ASSERT_EQ(FirmwarePackage::HEADER_SIZE + 6 * 2 + image.size(), packed.size());
+    EXPECT_TRUE(FirmwarePackage::isPackage(packed.data(), packed.size()));
+    EXPECT_FALSE(FirmwarePackage::isPackage(image.data(), image.size()));
+
+    FirmwarePackage package = FirmwarePackage::fromBuffer(packed.data(), packed.size());
+    EXPECT_EQ("CDS5516", package.model());
+    EXPECT_EQ("1.0", package.version());
+    EXPECT_EQ(128u, package.blockSize());
+    EXPECT_EQ(6u, package.frameCount());
+    EXPECT_EQ(crc32::compute(image.data(), image.size()), package.imageCrc());
+    ASSERT_EQ(image.size(), package.imageSize());
+    EXPECT_EQ(0, std::memcmp(image.data(), package.image(), image.size()));
+
+    // 预组装的帧与逐帧组装的结果一致
+    FirmwareFrameStream expected(image.data(), image.size());
+    FirmwareFrameStream frames = package.frameStream();
+    ASSERT_EQ(expected.frameCount(), frames.frameCount());
+    for (size_t i = 0; i < frames.frameCount(); ++i) {
+        const std::vector<uint8_t> &frame = expected.frame(i);
+        EXPECT_EQ(0, std::memcmp(frame.data(), frames.frameData(i), frame.size())) << "frame " << i;
+        EXPECT_EQ(0, std::memcmp(frame.data(), package.frames() + i * frame.size(), frame.size()));
+    }
+
+    // 切换到包外的数据块大小时逐帧组装
+    FirmwareFrameStream expected1k(image.data(), image.size(), FirmwareFrameStream::BLOCK_SIZE_1K);
+    frames.setBlockSize(FirmwareFrameStream::BLOCK_SIZE_1K);
+    ASSERT_EQ(1u, frames.frameCount());
+    EXPECT_EQ(0, std::memcmp(expected1k.frame(0).data(), frames.frameData(0), frames.frameSize()));
+}
+
+TEST(FirmwarePackageTest, RoundTrip1K) {
+    std::vector<uint8_t> image = makeImage(1024 * 2 + 1);
+    std::vector<uint8_t> packed = FirmwarePackage::pack(image.data(), image.size(), "CDS5516", "1.1",
+                                                        FirmwareFrameStream::BLOCK_SIZE_1K);
+
+    FirmwarePackage package = FirmwarePackage::fromBuffer(packed.data(), packed.size());
+    EXPECT_EQ(1024u, package.blockSize());
+    ASSERT_EQ(3u, package.frameCount());
+
+    FirmwareFrameStream expected(image.data(), image.size(), FirmwareFrameStream::BLOCK_SIZE_1K);
+    FirmwareFrameStream frames = package.frameStream();
+    for (size_t i = 0; i < frames.frameCount(); ++i) {
+        EXPECT_EQ(0, std::memcmp(expected.frame(i).data(), frames.frameData(i), frames.frameSize()));
+    }
+}
+
+TEST(FirmwarePackageTest, RejectsCorruption) {
+    std::vector<uint8_t> image = makeImage(128 * 3);
+    std::vector<uint8_t> packed = FirmwarePackage::pack(image.data(), image.size(), "CDS5516", "1.0");
+
+    // 镜像数据、数据块 CRC 表、包头字段、魔数任意一处损坏都在加载时被拒绝
+    std::vector<size_t> offsets = {packed.size() - 1, FirmwarePackage::HEADER_SIZE + 2 * 3 + 200,
+                                   FirmwarePackage::HEADER_SIZE + 1, 56, 8, 0};
+    for (size_t offset: offsets) {
+        std::vector<uint8_t> corrupted = packed;
+        corrupted[offset] ^= 0x5A;
+        EXPECT_THROW(FirmwarePackage::fromBuffer(corrupted.data(), corrupted.size()), std::runtime_error)
+                            << "offset " << offset;
+    }
+
+    // 截断或多出数据
+    EXPECT_THROW(FirmwarePackage::fromBuffer(packed.data(), packed.size() - 1), std::runtime_error);
+    EXPECT_THROW(FirmwarePackage::fromBuffer(packed.data(), 40), std::runtime_error);
+    std::vector<uint8_t> extended = packed;
+    extended.push_back(0);
+    EXPECT_THROW(FirmwarePackage::fromBuffer(extended.data(), extended.size()), std::runtime_error);
+}
+
+TEST(FirmwarePackageTest, RejectsBadArguments) {
+    std::vector<uint8_t> image = makeImage(10);
+    EXPECT_THROW(FirmwarePackage::pack(image.data(), image.size(), "CDS5516", "1.0", 256), std::invalid_argument);
+    EXPECT_THROW(FirmwarePackage::pack(image.data(), image.size(), std::string(33, 'M'), "1.0"),
+                 std::invalid_argument);
+}
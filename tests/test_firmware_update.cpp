@@ -0,0 +1,253 @@
+//
+// Created by noodles on 26-10-18.
+// 固件升级端到端测试：FirmwareUpdate 通过伪终端与模拟 Bootloader 通信
+//
+#include "bootloader_sim.h"
+#include "firmware_update.h"
+#include "firmware_rollout.h"
+#include "logger.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+    std::vector<uint8_t> makeImage(size_t size) {
+        std::vector<uint8_t> image(size);
+        for (size_t i = 0; i < size; ++i) {
+            image[i] = static_cast<uint8_t>(i * 131 + 17);
+        }
+        return image;
+    }
+
+    // 模拟器收到的数据去掉补零后应与固件一致
+    void expectImage(const std::vector<uint8_t> &expected, const BootloaderSimulator &simulator) {
+        std::vector<uint8_t> received = simulator.image();
+        ASSERT_GE(received.size(), expected.size());
+        EXPECT_EQ(0, std::memcmp(received.data(), expected.data(), expected.size()));
+        for (size_t i = expected.size(); i < received.size(); ++i) {
+            EXPECT_EQ(0, received[i]) << "padding byte " << i;
+        }
+    }
+
+    // 单元测试不需要模拟线路时间
+    BootloaderSimOptions fastOptions() {
+        BootloaderSimOptions options;
+        options.pace = false;
+        return options;
+    }
+
+    class FirmwareUpdateTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            level = Logger::getLogLevel();
+            Logger::setLogLevel(Logger::OFF);
+        }
+
+        void TearDown() override {
+            Logger::setLogLevel(level);
+        }
+
+        Logger::LogLevel level{Logger::INFO};
+    };
+}
+
+TEST_F(FirmwareUpdateTest, UpgradeStream) {
+    BootloaderSimulator simulator(fastOptions());
+    std::vector<uint8_t> image = makeImage(128 * 10 + 37);
+
+    FirmwareUpdate update;
+    ASSERT_TRUE(update.upgrade_stream(simulator.port(), 115200, image, 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    UpgradeMetrics metrics = update.getMetrics();
+    EXPECT_EQ(UpgradePhase::Done, metrics.phase);
+    EXPECT_EQ(11u, metrics.frames_acked);
+    EXPECT_EQ(11u, metrics.frames_sent);
+    EXPECT_EQ(image.size(), metrics.bytes_acked);
+    EXPECT_EQ(0u, metrics.frames_retried);
+}
+
+TEST_F(FirmwareUpdateTest, NegotiatesBlockSizeAndBaudrate) {
+    BootloaderSimulator simulator(fastOptions());
+    std::vector<uint8_t> image = makeImage(1024 * 3 + 100);
+
+    FirmwareUpdate update;
+    update.setTransferOptions(1024, 115200);
+    ASSERT_TRUE(update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    EXPECT_EQ(1024u, simulator.blockSize());
+    EXPECT_EQ(115200u, simulator.baudrate());
+    UpgradeMetrics metrics = update.getMetrics();
+    EXPECT_EQ(4u, metrics.frames_acked);
+    EXPECT_EQ(115200u, metrics.baud_rate);
+}
+
+TEST_F(FirmwareUpdateTest, FallsBackTo128And9600) {
+    BootloaderSimOptions options = fastOptions();
+    options.support_1k = false;
+    options.support_baud_switch = false;
+    BootloaderSimulator simulator(options);
+    std::vector<uint8_t> image = makeImage(2000);
+
+    FirmwareUpdate update;
+    update.setTransferOptions(1024, 115200);
+    ASSERT_TRUE(update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    EXPECT_EQ(128u, simulator.blockSize());
+    EXPECT_EQ(9600u, simulator.baudrate());
+    UpgradeMetrics metrics = update.getMetrics();
+    EXPECT_EQ(128u, metrics.block_size);
+    EXPECT_EQ(9600u, metrics.baud_rate);
+}
+
+TEST_F(FirmwareUpdateTest, RetransmitsOnNak) {
+    BootloaderSimOptions options = fastOptions();
+    options.nak_every = 3;
+    BootloaderSimulator simulator(options);
+    std::vector<uint8_t> image = makeImage(128 * 12);
+
+    FirmwareUpdate update;
+    ASSERT_TRUE(update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    UpgradeMetrics metrics = update.getMetrics();
+    EXPECT_EQ(simulator.naksSent(), metrics.nak_count);
+    EXPECT_GT(metrics.nak_count, 0u);
+    EXPECT_EQ(metrics.frames_acked + metrics.frames_retried, metrics.frames_sent);
+}
+
+TEST_F(FirmwareUpdateTest, RetransmitsOnDroppedReply) {
+    BootloaderSimOptions options = fastOptions();
+    options.drop_every = 4;
+    BootloaderSimulator simulator(options);
+    std::vector<uint8_t> image = makeImage(128 * 8);
+
+    FirmwareUpdate update;
+    update.setAckTimeoutMargin(20);
+    ASSERT_TRUE(update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    EXPECT_GT(update.getMetrics().timeout_count, 0u);
+}
+
+TEST_F(FirmwareUpdateTest, ResumesFromLastAcknowledgedFrame) {
+    // 第 5 帧起连续 5 帧不应答，用完单帧重试次数后重新握手续传
+    BootloaderSimOptions options = fastOptions();
+    options.drop_from = 5;
+    options.drop_count = 5;
+    BootloaderSimulator simulator(options);
+    std::vector<uint8_t> image = makeImage(128 * 10);
+
+    FirmwareUpdate update;
+    update.setAckTimeoutMargin(20);
+    ASSERT_TRUE(update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    UpgradeMetrics metrics = update.getMetrics();
+    EXPECT_EQ(1u, metrics.resumes);
+    EXPECT_EQ(0u, metrics.bootloader_failures);
+    // 前 4 帧确认 + 第 5 帧超时 5 次 + 续传发送剩余 6 帧，已确认的帧不再重发
+    EXPECT_EQ(4u + 5u + 6u, metrics.frames_sent);
+}
+
+TEST_F(FirmwareUpdateTest, RestartsWhenResumeIsNotSupported) {
+    BootloaderSimOptions options = fastOptions();
+    options.allow_resume = false;
+    options.drop_from = 5;
+    options.drop_count = 5;
+    BootloaderSimulator simulator(options);
+    std::vector<uint8_t> image = makeImage(128 * 10);
+
+    FirmwareUpdate update;
+    update.setAckTimeoutMargin(20);
+    ASSERT_TRUE(update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    UpgradeMetrics metrics = update.getMetrics();
+    EXPECT_GE(metrics.round, 3);
+}
+
+TEST_F(FirmwareUpdateTest, RestartsAfterCancel) {
+    BootloaderSimOptions options = fastOptions();
+    options.cancel_at = 3;
+    BootloaderSimulator simulator(options);
+    std::vector<uint8_t> image = makeImage(128 * 6);
+
+    FirmwareUpdate update;
+    ASSERT_TRUE(update.upgrade_buffer(simulator.port(), 115200, image.data(), image.size(), 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+
+    UpgradeMetrics metrics = update.getMetrics();
+    EXPECT_EQ(1u, metrics.cancel_count);
+    EXPECT_EQ(0u, metrics.resumes);
+    EXPECT_EQ(2, metrics.round);
+}
+
+TEST_F(FirmwareUpdateTest, RolloutAcrossBuses) {
+    BootloaderSimulator first(fastOptions());
+    BootloaderSimulator second(fastOptions());
+    std::vector<uint8_t> image = makeImage(128 * 5 + 3);
+
+    FirmwareRollout rollout(115200);
+    std::vector<RolloutTarget> targets = {RolloutTarget(first.port(), 1), RolloutTarget(second.port(), 2)};
+    std::vector<RolloutResult> results = rollout.run(targets, image.data(), image.size());
+
+    ASSERT_EQ(2u, results.size());
+    for (const RolloutResult &result: results) {
+        EXPECT_TRUE(result.success) << result.target.port << " " << result.error;
+        EXPECT_EQ(6u, result.metrics.frames_acked);
+    }
+    ASSERT_TRUE(first.waitCompleted(1000));
+    ASSERT_TRUE(second.waitCompleted(1000));
+    expectImage(image, first);
+    expectImage(image, second);
+}
+
+TEST_F(FirmwareUpdateTest, UpgradePackage) {
+    BootloaderSimulator simulator(fastOptions());
+    std::vector<uint8_t> image = makeImage(1024 * 2 + 300);
+    std::vector<uint8_t> packed = FirmwarePackage::pack(image.data(), image.size(), "CDS5516", "1.0",
+                                                        FirmwareFrameStream::BLOCK_SIZE_1K);
+    FirmwarePackage package = FirmwarePackage::fromBuffer(packed.data(), packed.size());
+
+    FirmwareUpdate update;
+    update.setTransferOptions(1024, 115200);
+    ASSERT_TRUE(update.upgrade_package(simulator.port(), 115200, package, 1));
+    ASSERT_TRUE(simulator.waitCompleted(1000));
+    expectImage(image, simulator);
+    EXPECT_EQ(1024u, simulator.blockSize());
+    EXPECT_EQ(3u, update.getMetrics().frames_acked);
+}
+
+TEST_F(FirmwareUpdateTest, RejectsCorruptedPackageBeforeBootloader) {
+    BootloaderSimulator simulator(fastOptions());
+    std::vector<uint8_t> image = makeImage(128 * 4);
+    std::vector<uint8_t> packed = FirmwarePackage::pack(image.data(), image.size(), "CDS5516", "1.0");
+    packed[packed.size() - 10] ^= 0xFF;
+
+    std::string path = "/tmp/up_core_corrupted_" + std::to_string(::getpid()) + ".upk";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(packed.data()), static_cast<std::streamsize>(packed.size()));
+    }
+
+    FirmwareUpdate update;
+    EXPECT_FALSE(update.upgrade_path(simulator.port(), 115200, path, 1));
+    std::remove(path.c_str());
+
+    // 舵机没有被复位到 Bootloader
+    EXPECT_EQ(0u, simulator.resets());
+    EXPECT_EQ(0u, simulator.framesReceived());
+}
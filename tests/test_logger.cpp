@@ -0,0 +1,172 @@
+//
+// Created by noodles on 26-10-18.
+// 日志测试：异步写入（多线程、格式、溢出策略）与延迟构造的日志
+//
+#include "logger.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::vector<std::string> readLines(const std::string &path) {
+        std::vector<std::string> lines;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // 测试期间使用 DEBUG 级别，结束时恢复同步模式和原级别
+    class AsyncLoggerTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            level_ = Logger::getLogLevel();
+            Logger::setLogLevel(Logger::DEBUG);
+            path_ = "/tmp/up_core_logger_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                    ".log";
+            std::remove(path_.c_str());
+        }
+
+        void TearDown() override {
+            Logger::disableAsync();
+            Logger::setLogLevel(level_);
+            std::remove(path_.c_str());
+        }
+
+        Logger::LogLevel level_;
+        std::string path_;
+    };
+}
+
+TEST_F(AsyncLoggerTest, ManyProducers) {
+    Logger::AsyncOptions options;
+    options.capacity = 256;
+    options.overflow = Logger::BLOCK;
+    options.path = path_;
+    Logger::enableAsync(options);
+    ASSERT_TRUE(Logger::isAsync());
+
+    const int threads = 4;
+    const int messages = 2000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < messages; ++i) {
+                Logger::info("thread " + std::to_string(t) + " message " + std::to_string(i));
+            }
+        });
+    }
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+    Logger::flush();
+
+    std::vector<std::string> lines = readLines(path_);
+    ASSERT_EQ(static_cast<size_t>(threads * messages), lines.size());
+    std::set<std::string> unique;
+    for (const std::string &line: lines) {
+        // "YYYY-mm-dd HH:MM:SS.mmm [ INFO  ] ..."
+        ASSERT_GT(line.size(), 34u);
+        EXPECT_EQ('.', line[19]);
+        EXPECT_EQ(" [ INFO  ] ", line.substr(23, 11));
+        unique.insert(line.substr(34));
+    }
+    EXPECT_EQ(lines.size(), unique.size());
+}
+
+TEST_F(AsyncLoggerTest, LevelFilterAndFlushOnDisable) {
+    Logger::AsyncOptions options;
+    options.path = path_;
+    options.flush_interval_ms = 1000;
+    Logger::enableAsync(options);
+
+    Logger::setLogLevel(Logger::WARNING);
+    Logger::debug("filtered");
+    Logger::info("filtered");
+    Logger::warning("kept warning");
+    Logger::error("kept error");
+
+    // 关闭异步模式时写完队列中的日志，不等待刷新间隔
+    Logger::disableAsync();
+    EXPECT_FALSE(Logger::isAsync());
+
+    std::vector<std::string> lines = readLines(path_);
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("[WARNING] kept warning"));
+    EXPECT_NE(std::string::npos, lines[1].find("[ ERROR ] kept error"));
+}
+
+TEST_F(AsyncLoggerTest, DropWhenFull) {
+    Logger::AsyncOptions options;
+    options.capacity = 4;
+    options.overflow = Logger::DROP;
+    options.flush_interval_ms = 1000;
+    options.path = path_;
+    uint64_t dropped_before = Logger::droppedCount();
+    Logger::enableAsync(options);
+
+    // 后台线程按间隔取走日志，连续写入时队列很快写满
+    const int messages = 10000;
+    for (int i = 0; i < messages; ++i) {
+        Logger::debug("message " + std::to_string(i));
+    }
+    Logger::disableAsync();
+
+    uint64_t dropped = Logger::droppedCount() - dropped_before;
+    EXPECT_GT(dropped, 0u);
+
+    // 写出的日志加上丢弃的条数等于写入的条数，另有丢弃提示
+    size_t written = 0;
+    size_t notices = 0;
+    for (const std::string &line: readLines(path_)) {
+        if (line.find("[ DEBUG ] message ") != std::string::npos) {
+            ++written;
+        } else if (line.find("[WARNING]") != std::string::npos) {
+            ++notices;
+        }
+    }
+    EXPECT_EQ(static_cast<uint64_t>(messages), written + dropped);
+    EXPECT_GE(notices, 1u);
+}
+
+TEST_F(AsyncLoggerTest, LazyMessagesAreBuiltOnlyWhenEnabled) {
+    Logger::AsyncOptions options;
+    options.path = path_;
+    Logger::enableAsync(options);
+
+    int built = 0;
+    auto build = [&built](const std::string &text) {
+        ++built;
+        return text;
+    };
+
+    Logger::setLogLevel(Logger::INFO);
+    UP_LOG_DEBUG(build("debug"));
+    Logger::lazy(Logger::DEBUG, [&] { return build("lazy debug"); });
+    EXPECT_EQ(0, built);
+    EXPECT_FALSE(Logger::isEnabled(Logger::DEBUG));
+    EXPECT_TRUE(Logger::isEnabled(Logger::ERROR));
+
+    UP_LOG_INFO(build("info"));
+    Logger::lazy(Logger::WARNING, [&] { return build("lazy warning"); });
+    EXPECT_EQ(2, built);
+
+    // 宏可以用在不带花括号的 if / else 中
+    if (built == 2)
+        UP_LOG_ERROR(build("error"));
+    else
+        UP_LOG_ERROR(build("unreachable"));
+    EXPECT_EQ(3, built);
+
+    Logger::disableAsync();
+    std::vector<std::string> lines = readLines(path_);
+    ASSERT_EQ(3u, lines.size());
+    EXPECT_NE(std::string::npos, lines[0].find("[ INFO  ] info"));
+    EXPECT_NE(std::string::npos, lines[1].find("[WARNING] lazy warning"));
+    EXPECT_NE(std::string::npos, lines[2].find("[ ERROR ] error"));
+}
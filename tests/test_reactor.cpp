@@ -0,0 +1,335 @@
+//
+// Created by noodles on 26-10-18.
+// 事件循环测试：多个串口（伪终端）由一个 Reactor 线程服务
+//
+#include "pty_pair.h"
+#include "wait_for.h"
+#include "serial/reactor.h"
+#include "servo.h"
+#include "logger.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace {
+    // 回调在事件循环线程中写入，测试线程读取
+    class Received {
+    public:
+        serial::Reactor::ReadCallback callback() {
+            return [this](const uint8_t *data, size_t size) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                data_.append(reinterpret_cast<const char *>(data), size);
+            };
+        }
+
+        std::string data() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return data_;
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        std::string data_;
+    };
+}
+
+TEST(ReactorTest, ReadAndSend) {
+    PtyPair pty;
+    auto port = pty.open();
+    serial::Reactor reactor;
+    reactor.start();
+    ASSERT_TRUE(reactor.running());
+
+    Received received;
+    reactor.add(port, received.callback());
+
+    ASSERT_TRUE(pty.write("hello"));
+    EXPECT_TRUE(waitFor([&] { return received.data() == "hello"; }));
+
+    std::string message = "world";
+    EXPECT_TRUE(reactor.send(port, reinterpret_cast<const uint8_t *>(message.data()), message.size()));
+    EXPECT_EQ("world", pty.read(message.size()));
+    EXPECT_TRUE(waitFor([&] { return reactor.pending(port) == 0; }));
+
+    reactor.stop();
+    EXPECT_FALSE(reactor.running());
+}
+
+TEST(ReactorTest, ManyPortsOneThread) {
+    const size_t count = 4;
+    std::vector<std::unique_ptr<PtyPair> > ptys;
+    std::vector<std::shared_ptr<serial::Serial> > ports;
+    std::vector<std::unique_ptr<Received> > received;
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    serial::Reactor reactor;
+    reactor.start();
+    for (size_t i = 0; i < count; ++i) {
+        ptys.emplace_back(new PtyPair());
+        ports.push_back(ptys[i]->open());
+        received.emplace_back(new Received());
+
+        serial::Reactor::ReadCallback record = received[i]->callback();
+        reactor.add(ports[i], [&, record](const uint8_t *data, size_t size) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            record(data, size);
+        });
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_TRUE(ptys[i]->write("port" + std::to_string(i)));
+        reactor.send(ports[i], std::vector<uint8_t>(64, static_cast<uint8_t>('a' + i)));
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_TRUE(waitFor([&] { return received[i]->data() == "port" + std::to_string(i); })) << "port " << i;
+        EXPECT_EQ(std::string(64, static_cast<char>('a' + i)), ptys[i]->read(64)) << "port " << i;
+    }
+
+    // 所有端口的回调都在同一个事件循环线程中
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(1u, threads.size());
+    EXPECT_NE(std::this_thread::get_id(), *threads.begin());
+}
+
+TEST(ReactorTest, RemoveStopsCallbacks) {
+    PtyPair pty;
+    auto port = pty.open();
+    serial::Reactor reactor;
+    reactor.start();
+
+    Received received;
+    reactor.add(port, received.callback());
+    ASSERT_TRUE(pty.write("a"));
+    ASSERT_TRUE(waitFor([&] { return received.data() == "a"; }));
+
+    reactor.remove(port);
+    EXPECT_FALSE(reactor.send(port, std::vector<uint8_t>(1, 'x')));
+
+    ASSERT_TRUE(pty.write("b"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ("a", received.data());
+
+    // 移出后可以直接读取串口
+    EXPECT_EQ("b", port->read(1));
+}
+
+TEST(ReactorTest, Timers) {
+    serial::Reactor reactor;
+    reactor.start();
+
+    std::atomic<int> once{0};
+    std::atomic<int> periodic{0};
+    std::atomic<int> cancelled{0};
+
+    reactor.addTimer(10, [&] { ++once; });
+    serial::Reactor::TimerId id = reactor.addTimer(5, [&] { ++periodic; }, 5);
+    serial::Reactor::TimerId cancel_id = reactor.addTimer(30, [&] { ++cancelled; });
+    reactor.cancelTimer(cancel_id);
+
+    EXPECT_TRUE(waitFor([&] { return periodic >= 5; }));
+    reactor.cancelTimer(id);
+    int fired = periodic;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(1, once);
+    EXPECT_EQ(0, cancelled);
+    // 取消时可能已有一次触发在途
+    EXPECT_LE(periodic, fired + 1);
+}
+
+TEST(ReactorTest, AddFd) {
+    int fds[2];
+    ASSERT_EQ(0, ::pipe2(fds, O_NONBLOCK));
+
+    serial::Reactor reactor;
+    reactor.start();
+
+    std::atomic<int> events{0};
+    reactor.addFd(fds[0], EPOLLIN, [&](uint32_t mask) {
+        if (mask & EPOLLIN) {
+            char buffer[16];
+            while (::read(fds[0], buffer, sizeof(buffer)) > 0) {}
+            ++events;
+        }
+    });
+
+    ASSERT_EQ(1, ::write(fds[1], "x", 1));
+    EXPECT_TRUE(waitFor([&] { return events == 1; }));
+
+    reactor.removeFd(fds[0]);
+    ASSERT_EQ(1, ::write(fds[1], "y", 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(1, events);
+
+    reactor.stop();
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(ReactorTest, HangupReportsError) {
+    PtyPair pty;
+    auto port = pty.open();
+    serial::Reactor reactor;
+    reactor.start();
+
+    std::atomic<int> error{0};
+    Received received;
+    reactor.add(port, received.callback(), [&](int e) { error = e; });
+
+    pty.closeMaster();
+    EXPECT_TRUE(waitFor([&] { return error != 0; }));
+
+    // 出错的端口已被移出事件循环
+    EXPECT_FALSE(reactor.send(port, std::vector<uint8_t>(1, 'x')));
+}
+
+TEST(ReactorTest, ServoReceivesThroughReactor) {
+    Logger::LogLevel level = Logger::getLogLevel();
+    Logger::setLogLevel(Logger::OFF);
+
+    PtyPair pty;
+    auto reactor = std::make_shared<serial::Reactor>();
+    reactor->start();
+
+    std::mutex mutex;
+    std::vector<uint8_t> packet;
+    {
+        Servo servo(pty.open());
+        servo.setDataCallback([&](const std::vector<uint8_t> &data) {
+            std::lock_guard<std::mutex> lock(mutex);
+            packet = data;
+        });
+        servo.init(reactor);
+
+        // 舵机 1 的状态应答
+        EXPECT_TRUE(pty.write(std::string("\xFF\xFF\x01\x02\x00\xFC", 6)));
+        EXPECT_TRUE(waitFor([&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return packet.size() == 6;
+        }));
+    }
+
+    Logger::setLogLevel(level);
+}
+
+// 一次读取只有半帧：保留在缓冲区中，与下一次读取拼成完整的帧
+TEST(ReactorTest, ServoReassemblesSplitFrame) {
+    Logger::LogLevel level = Logger::getLogLevel();
+    Logger::setLogLevel(Logger::OFF);
+
+    PtyPair pty;
+    auto reactor = std::make_shared<serial::Reactor>();
+    reactor->start();
+
+    std::mutex mutex;
+    std::vector<std::vector<uint8_t> > packets;
+    {
+        Servo servo(pty.open());
+        servo.setDataCallback([&](const std::vector<uint8_t> &data) {
+            std::lock_guard<std::mutex> lock(mutex);
+            packets.push_back(data);
+        });
+        servo.init(reactor);
+
+        EXPECT_TRUE(pty.write(std::string("\xFF\xFF\x01", 3)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_TRUE(pty.write(std::string("\x02\x00\xFC", 3)));
+        EXPECT_TRUE(waitFor([&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return !packets.empty();
+        }));
+    }
+
+    ASSERT_EQ(1u, packets.size());
+    EXPECT_EQ(std::vector<uint8_t>({0xFF, 0xFF, 0x01, 0x02, 0x00, 0xFC}), packets[0]);
+
+    Logger::setLogLevel(level);
+}
+
+// 一次读取包含上一帧的尾部和下一整帧：按长度字节切成两个数据包
+TEST(ReactorTest, ServoSplitsFramesInOneRead) {
+    Logger::LogLevel level = Logger::getLogLevel();
+    Logger::setLogLevel(Logger::OFF);
+
+    PtyPair pty;
+    auto reactor = std::make_shared<serial::Reactor>();
+    reactor->start();
+
+    std::mutex mutex;
+    std::vector<std::vector<uint8_t> > packets;
+    {
+        Servo servo(pty.open());
+        servo.setDataCallback([&](const std::vector<uint8_t> &data) {
+            std::lock_guard<std::mutex> lock(mutex);
+            packets.push_back(data);
+        });
+        servo.init(reactor);
+
+        // 舵机 1 和舵机 2 的状态应答，前面有一个干扰字节
+        EXPECT_TRUE(pty.write(std::string("\x00\xFF\xFF\x01", 4)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_TRUE(pty.write(std::string("\x02\x00\xFC\xFF\xFF\x02\x02\x00\xFB", 9)));
+        EXPECT_TRUE(waitFor([&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return packets.size() >= 2;
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    ASSERT_EQ(2u, packets.size());
+    EXPECT_EQ(std::vector<uint8_t>({0xFF, 0xFF, 0x01, 0x02, 0x00, 0xFC}), packets[0]);
+    EXPECT_EQ(std::vector<uint8_t>({0xFF, 0xFF, 0x02, 0x02, 0x00, 0xFB}), packets[1]);
+
+    Logger::setLogLevel(level);
+}
+
+TEST(ReactorTest, ServoResponseTimestamps) {
+    Logger::LogLevel level = Logger::getLogLevel();
+    Logger::setLogLevel(Logger::OFF);
+
+    PtyPair pty;
+    auto reactor = std::make_shared<serial::Reactor>();
+    reactor->start();
+
+    std::mutex mutex;
+    std::vector<FrameTimestamp> timestamps;
+    {
+        Servo servo(pty.open());
+        servo.setTimedDataCallback([&](const std::vector<uint8_t> &, const FrameTimestamp &timestamp) {
+            std::lock_guard<std::mutex> lock(mutex);
+            timestamps.push_back(timestamp);
+        });
+        servo.init(reactor);
+
+        // 对端收到 PING 后 10 ms 应答
+        EXPECT_TRUE(servo.sendCommand(servo::ServoProtocol(1).buildPingPacket()));
+        EXPECT_EQ(6u, pty.read(6).size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_TRUE(pty.write(std::string("\xFF\xFF\x01\x02\x00\xFC", 6)));
+
+        EXPECT_TRUE(waitFor([&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return !timestamps.empty();
+        }));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(1u, timestamps.size());
+    EXPECT_GT(timestamps[0].tx_ns, 0u);
+    EXPECT_GE(timestamps[0].responseUs(), 10000.0);
+    EXPECT_LT(timestamps[0].responseUs(), 1000000.0);
+
+    Logger::setLogLevel(level);
+}
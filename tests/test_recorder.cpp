@@ -0,0 +1,279 @@
+//
+// Created by noodles on 26-10-18.
+// 串口流量录制与回放测试
+//
+#include "pty_pair.h"
+#include "wait_for.h"
+#include "serial/recorder.h"
+#include "serial/replay.h"
+#include "servo.h"
+#include "logger.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    // 测试结束时删除录制文件
+    class TempFile {
+    public:
+        TempFile() {
+            char name[] = "/tmp/up_core_recording_XXXXXX";
+            int fd = ::mkstemp(name);
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            path = name;
+        }
+
+        ~TempFile() {
+            std::remove(path.c_str());
+        }
+
+        std::string path;
+    };
+
+    const std::vector<uint8_t> STATUS_FRAME = {0xFF, 0xFF, 0x01, 0x02, 0x00, 0xFC};
+
+    // 三个舵机应答，间隔 20 ms
+    serial::Recording makeRecording(const std::string &path) {
+        {
+            serial::Recorder recorder(path);
+            for (uint64_t i = 0; i < 3; ++i) {
+                recorder.record(serial::Recorder::TX, STATUS_FRAME.data(), STATUS_FRAME.size(),
+                                recorder.startTime() + i * 20000000ULL);
+                recorder.record(serial::Recorder::RX, STATUS_FRAME.data(), STATUS_FRAME.size(),
+                                recorder.startTime() + i * 20000000ULL + 1000000ULL, 1);
+            }
+        }
+        return serial::Recording::fromFile(path);
+    }
+}
+
+TEST(RecorderTest, RecordsSerialTraffic) {
+    TempFile file;
+    PtyPair pty;
+    auto port = pty.open();
+    auto recorder = std::make_shared<serial::Recorder>(file.path);
+    port->setRecorder(recorder, 3);
+
+    EXPECT_EQ(4u, port->write("ping"));
+    EXPECT_EQ("ping", pty.read(4));
+    ASSERT_TRUE(pty.write("pong"));
+    EXPECT_EQ("pong", port->read(4));
+    port->writeBatch({{'a', 'b'}, {'c'}});
+    EXPECT_EQ("abc", pty.read(3));
+
+    port->setRecorder(nullptr);
+    port->write("not recorded");
+    recorder->flush();
+
+    serial::Recording recording = serial::Recording::fromFile(file.path);
+    EXPECT_EQ(recorder->startTime(), recording.startTime());
+    const std::vector<serial::Recording::Record> &records = recording.records();
+    ASSERT_EQ(4u, records.size());
+    EXPECT_EQ(serial::Recorder::TX, records[0].direction);
+    EXPECT_EQ("ping", std::string(records[0].data.begin(), records[0].data.end()));
+    EXPECT_EQ(serial::Recorder::RX, records[1].direction);
+    EXPECT_EQ("pong", std::string(records[1].data.begin(), records[1].data.end()));
+    EXPECT_EQ(std::vector<uint8_t>({'a', 'b'}), records[2].data);
+    EXPECT_EQ(std::vector<uint8_t>({'c'}), records[3].data);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(3, records[i].channel);
+        if (i > 0) {
+            EXPECT_GE(records[i].time_ns, records[i - 1].time_ns);
+        }
+    }
+    // 读出时间与串口的读时间戳一致
+    EXPECT_EQ(port->getReadTimestamp() - recorder->startTime(), records[1].time_ns);
+}
+
+TEST(RecorderTest, SplitsLargeRecordsAndIgnoresTruncatedTail) {
+    TempFile file;
+    std::vector<uint8_t> data(70000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    {
+        serial::Recorder recorder(file.path, 1024, 10);
+        recorder.record(serial::Recorder::RX, data.data(), data.size(), serial::monotonicNs());
+        EXPECT_EQ(2u, recorder.records());
+        EXPECT_EQ(data.size(), recorder.bytes());
+        recorder.close();
+        // 关闭后的记录被忽略
+        recorder.record(serial::Recorder::RX, data.data(), 1, serial::monotonicNs());
+        EXPECT_EQ(2u, recorder.records());
+    }
+
+    serial::Recording recording = serial::Recording::fromFile(file.path);
+    ASSERT_EQ(2u, recording.records().size());
+    std::vector<uint8_t> joined = recording.records()[0].data;
+    joined.insert(joined.end(), recording.records()[1].data.begin(), recording.records()[1].data.end());
+    EXPECT_EQ(data, joined);
+
+    // 截断最后一条记录，模拟录制进程异常退出
+    ASSERT_EQ(0, ::truncate(file.path.c_str(), serial::Recorder::FILE_HEADER_SIZE +
+                                               serial::Recorder::RECORD_HEADER_SIZE + 65535 + 100));
+    EXPECT_EQ(1u, serial::Recording::fromFile(file.path).records().size());
+
+    ASSERT_EQ(0, ::truncate(file.path.c_str(), 3));
+    EXPECT_THROW(serial::Recording::fromFile(file.path), std::runtime_error);
+}
+
+TEST(ReplayTest, InjectIntoServo) {
+    Logger::LogLevel level = Logger::getLogLevel();
+    Logger::setLogLevel(Logger::OFF);
+
+    TempFile file;
+    serial::Recording recording = makeRecording(file.path);
+    ASSERT_EQ(6u, recording.records().size());
+
+    PtyPair pty;
+    Servo servo(pty.open());
+    std::vector<FrameTimestamp> timestamps;
+    servo.setTimedDataCallback([&](const std::vector<uint8_t> &packet, const FrameTimestamp &timestamp) {
+        EXPECT_EQ(STATUS_FRAME, packet);
+        timestamps.push_back(timestamp);
+    });
+
+    serial::Replayer replayer(recording);
+    replayer.setSpeed(0);
+    replayer.setChannel(1);
+    size_t count = replayer.run([&](const serial::Recording::Record &record, uint64_t now_ns) {
+        EXPECT_EQ(serial::Recorder::RX, record.direction);
+        servo.inject(record.data.data(), record.data.size(), now_ns);
+    });
+    EXPECT_EQ(3u, count);
+    ASSERT_EQ(3u, timestamps.size());
+    EXPECT_GE(timestamps[2].rx_ns, timestamps[0].rx_ns);
+
+    // 通道 0 只有 TX 记录
+    replayer.setChannel(0);
+    EXPECT_EQ(0u, replayer.run([](const serial::Recording::Record &, uint64_t) {}));
+    replayer.setDirections(false, true);
+    EXPECT_EQ(3u, replayer.run([](const serial::Recording::Record &, uint64_t) {}));
+
+    Logger::setLogLevel(level);
+}
+
+TEST(ReplayTest, KeepsRecordedTiming) {
+    TempFile file;
+    serial::Replayer replayer(makeRecording(file.path));
+
+    // 计划时间按记录的间隔排列；实际调用不早于计划时间（首条记录的休眠可能略晚，不比较实际间隔的下限）
+    std::vector<uint64_t> arrivals;
+    std::vector<uint64_t> due;
+    auto sink = [&](const serial::Recording::Record &, uint64_t due_ns) {
+        arrivals.push_back(serial::monotonicNs());
+        due.push_back(due_ns);
+    };
+
+    // 原始时序：RX 记录间隔 20 ms
+    replayer.run(sink);
+    ASSERT_EQ(3u, arrivals.size());
+    EXPECT_EQ(40000000u, due[2] - due[0]);
+    for (size_t i = 0; i < arrivals.size(); ++i) {
+        EXPECT_GE(arrivals[i], due[i]);
+    }
+    EXPECT_LT(arrivals[2] - arrivals[0], 200000000u);
+
+    // 10 倍速
+    arrivals.clear();
+    due.clear();
+    replayer.setSpeed(10);
+    replayer.run(sink);
+    ASSERT_EQ(3u, arrivals.size());
+    EXPECT_EQ(4000000u, due[2] - due[0]);
+    for (size_t i = 0; i < arrivals.size(); ++i) {
+        EXPECT_GE(arrivals[i], due[i]);
+    }
+    EXPECT_LT(arrivals[2] - arrivals[0], 40000000u);
+
+    EXPECT_THROW(replayer.setSpeed(-1), std::invalid_argument);
+}
+
+TEST(ReplayTest, StopInterruptsWait) {
+    TempFile file;
+    {
+        serial::Recorder recorder(file.path);
+        recorder.record(serial::Recorder::RX, STATUS_FRAME.data(), STATUS_FRAME.size(), recorder.startTime());
+        recorder.record(serial::Recorder::RX, STATUS_FRAME.data(), STATUS_FRAME.size(),
+                        recorder.startTime() + 10000000000ULL);
+    }
+    serial::Replayer replayer(serial::Recording::fromFile(file.path));
+
+    // 两条记录间隔 10 s，stop() 立即结束等待
+    size_t count = 0;
+    std::thread runner([&] { count = replayer.run([](const serial::Recording::Record &, uint64_t) {}); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto begin = std::chrono::steady_clock::now();
+    replayer.stop();
+    runner.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(500));
+    EXPECT_EQ(1u, count);
+
+    // 停止只作用于那一次回放
+    replayer.setSpeed(0);
+    EXPECT_EQ(2u, replayer.run([](const serial::Recording::Record &, uint64_t) {}));
+}
+
+// 没有读取方时伪终端很快写满，stop() 和析构不能一直等待写入
+TEST(ReplayTest, ReplayPortStopsWithoutReader) {
+    TempFile file;
+    {
+        serial::Recorder recorder(file.path);
+        std::vector<uint8_t> block(60000, 0x55);
+        for (uint64_t i = 0; i < 4; ++i) {
+            recorder.record(serial::Recorder::RX, block.data(), block.size(), recorder.startTime() + i * 1000000ULL);
+        }
+    }
+    auto replayer = std::make_shared<serial::Replayer>(serial::Recording::fromFile(file.path));
+    replayer->setSpeed(0);
+
+    serial::ReplayPort replay_port;
+    replay_port.start(replayer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(replay_port.finished());
+
+    auto begin = std::chrono::steady_clock::now();
+    replay_port.stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(1000));
+    EXPECT_TRUE(replay_port.finished());
+}
+
+TEST(ReplayTest, ReplayPortDrivesReactor) {
+    Logger::LogLevel level = Logger::getLogLevel();
+    Logger::setLogLevel(Logger::OFF);
+
+    TempFile file;
+    auto replayer = std::make_shared<serial::Replayer>(makeRecording(file.path));
+    serial::ReplayPort replay_port;
+    auto reactor = std::make_shared<serial::Reactor>();
+    reactor->start();
+
+    std::mutex mutex;
+    size_t packets = 0;
+    {
+        Servo servo(std::make_shared<serial::Serial>(replay_port.port(), 115200,
+                                                     serial::Timeout::simpleTimeout(100)));
+        servo.setDataCallback([&](const std::vector<uint8_t> &packet) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (packet == STATUS_FRAME) {
+                ++packets;
+            }
+        });
+        servo.init(reactor);
+
+        replay_port.start(replayer);
+        replay_port.wait();
+        EXPECT_TRUE(replay_port.finished());
+        EXPECT_TRUE(waitFor([&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return packets == 3;
+        }));
+    }
+
+    Logger::setLogLevel(level);
+}
@@ -0,0 +1,198 @@
+//
+// Created by noodles on 26-10-18.
+// 串口测试：通过伪终端验证 serial::Serial 的读写行为
+//
+#include "pty_pair.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(SerialLowLatencyTest, ReportsWhatWasApplied) {
+    PtyPair pty;
+    auto port = pty.open();
+
+    // 伪终端没有 USB 串口驱动，不支持的项被跳过而不是抛出异常
+    serial::LowLatencyInfo info = port->setLowLatency(true);
+    EXPECT_TRUE(info.enabled);
+    EXPECT_TRUE(info.immediate_read);
+    EXPECT_EQ(-1, info.latency_timer_ms);
+    EXPECT_NE(std::string::npos, info.details.find("latency_timer unavailable")) << info.details;
+    EXPECT_EQ(info.details, port->getLowLatency().details);
+
+    info = port->setLowLatency(false);
+    EXPECT_FALSE(info.enabled);
+    EXPECT_FALSE(info.immediate_read);
+}
+
+TEST(SerialLowLatencyTest, AppliedWhenOpened) {
+    PtyPair pty;
+    serial::Serial port("", 115200, serial::Timeout::simpleTimeout(100));
+
+    serial::LowLatencyInfo info = port.setLowLatency(true);
+    EXPECT_TRUE(info.enabled);
+    EXPECT_FALSE(info.immediate_read);
+
+    port.setPort(pty.port);
+    port.open();
+    EXPECT_TRUE(port.getLowLatency().immediate_read);
+
+    // 关闭再打开后重新生效
+    port.close();
+    port.open();
+    EXPECT_TRUE(port.getLowLatency().immediate_read);
+}
+
+TEST(SerialLowLatencyTest, ReadCollectsSplitFrame) {
+    PtyPair pty;
+    auto port = pty.open();
+    port->setLowLatency(true);
+
+    std::thread writer([&pty] {
+        pty.write("01234");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pty.write("56789");
+    });
+
+    std::string data = port->read(10);
+    writer.join();
+    EXPECT_EQ("0123456789", data);
+}
+
+TEST(SerialWriteBatchTest, FramesArriveInOrder) {
+    PtyPair pty;
+    auto port = pty.open();
+
+    std::vector<std::vector<uint8_t> > frames = {{'a', 'b'}, {}, {'c'}, {'d', 'e', 'f'}};
+    EXPECT_EQ(6u, port->writeBatch(frames));
+    EXPECT_EQ("abcdef", pty.read(6));
+
+    EXPECT_EQ(0u, port->writeBatch({}));
+}
+
+TEST(SerialWriteBatchTest, LargerThanKernelBuffer) {
+    PtyPair pty;
+    auto port = std::make_shared<serial::Serial>(pty.port, 115200, serial::Timeout::simpleTimeout(2000));
+
+    // 超过伪终端缓冲区，writev 多次部分写入，需要从帧中间继续
+    std::vector<std::vector<uint8_t> > frames;
+    std::string expected;
+    for (size_t i = 0; i < 40; ++i) {
+        std::vector<uint8_t> frame(1000 + i * 7);
+        for (size_t j = 0; j < frame.size(); ++j) {
+            frame[j] = static_cast<uint8_t>('A' + (i + j) % 26);
+        }
+        expected.append(frame.begin(), frame.end());
+        frames.push_back(frame);
+    }
+
+    std::string received;
+    std::thread reader([&] { received = pty.read(expected.size(), 3000); });
+    EXPECT_EQ(expected.size(), port->writeBatch(frames));
+    reader.join();
+    EXPECT_TRUE(received == expected) << "received " << received.size() << " of " << expected.size();
+}
+
+TEST(SerialReadBufferTest, ReadlineKeepsRemainder) {
+    PtyPair pty;
+    auto port = pty.open();
+
+    ASSERT_TRUE(pty.write("first\nsecond\nthird"));
+    EXPECT_EQ("first\n", port->readline());
+
+    // 多读的数据留在读缓冲区，available / read 都能看到
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(12u, port->available());
+    EXPECT_TRUE(port->waitReadable());
+    EXPECT_EQ("sec", port->read(3));
+    EXPECT_EQ("ond\n", port->readline());
+
+    // 超时返回已读到的部分
+    EXPECT_EQ("third", port->readline());
+    EXPECT_EQ("", port->readline());
+}
+
+TEST(SerialReadBufferTest, DelimiterAcrossChunks) {
+    PtyPair pty;
+    auto port = pty.open();
+
+    std::thread writer([&pty] {
+        pty.write("OK\r");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pty.write("\nERR\r\nrest");
+    });
+
+    EXPECT_EQ("OK\r\n", port->readUntil("\r\n"));
+    writer.join();
+    EXPECT_EQ("ERR\r\n", port->readUntil("\r\n"));
+    EXPECT_EQ("re", port->readUntil("\r\n", 2));
+
+    port->flushInput();
+    EXPECT_EQ(0u, port->available());
+}
+
+TEST(SerialReadBufferTest, Readlines) {
+    PtyPair pty;
+    auto port = pty.open();
+
+    ASSERT_TRUE(pty.write("a;bb;ccc"));
+    std::vector<std::string> lines = port->readlines(65536, ";");
+    ASSERT_EQ(3u, lines.size());
+    EXPECT_EQ("a;", lines[0]);
+    EXPECT_EQ("bb;", lines[1]);
+    EXPECT_EQ("ccc", lines[2]);
+}
+
+TEST(SerialReadBufferTest, ReadUntilPredicate) {
+    PtyPair pty;
+    auto port = pty.open();
+
+    // 舵机应答包：FF FF ID LEN ... CHECKSUM，长度由第 4 个字节决定
+    auto packet = [](const uint8_t *data, size_t size) -> size_t {
+        if (size < 4) {
+            return 0;
+        }
+        size_t length = 4 + static_cast<size_t>(data[3]);
+        return size >= length ? length : 0;
+    };
+
+    std::thread writer([&pty] {
+        pty.write(std::string("\xFF\xFF\x01", 3));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pty.write(std::string("\x02\x00\xFC\xFF\xFF\x02\x02\x00\xFB", 9));
+    });
+
+    std::vector<uint8_t> first, second;
+    EXPECT_EQ(6u, port->readUntil(first, packet));
+    writer.join();
+    EXPECT_EQ(6u, port->readUntil(second, packet));
+    EXPECT_EQ((std::vector<uint8_t>{0xFF, 0xFF, 0x01, 0x02, 0x00, 0xFC}), first);
+    EXPECT_EQ((std::vector<uint8_t>{0xFF, 0xFF, 0x02, 0x02, 0x00, 0xFB}), second);
+}
+
+TEST(SerialTimestampTest, ChunkTimeIsKept) {
+    PtyPair pty;
+    auto port = pty.open();
+    EXPECT_EQ(0u, port->getReadTimestamp());
+
+    uint64_t before = serial::monotonicNs();
+    EXPECT_EQ(2u, port->write("hi"));
+    uint64_t after = serial::monotonicNs();
+    EXPECT_GE(port->getWriteTimestamp(), before);
+    EXPECT_LE(port->getWriteTimestamp(), after);
+    EXPECT_EQ("hi", pty.read(2));
+
+    // 同一块数据中的两行使用读出时的时间，而不是取出时的时间
+    ASSERT_TRUE(pty.write("a\nb\n"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ("a\n", port->readline());
+    uint64_t first = port->getReadTimestamp();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ("b\n", port->readline());
+    EXPECT_EQ(first, port->getReadTimestamp());
+    EXPECT_GT(first, after);
+
+    ASSERT_TRUE(pty.write("c"));
+    EXPECT_EQ("c", port->read(1));
+    EXPECT_GE(port->getReadTimestamp(), first + 20 * 1000 * 1000);
+}
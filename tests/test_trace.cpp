@@ -0,0 +1,103 @@
+//
+// Created by noodles on 26-10-18.
+// 二进制跟踪测试：多线程写入、线程退出和停止时写出、文件读取
+//
+#include "trace.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char *TRACE_PATH = "/tmp/up_core_trace_test.uptr";
+}
+
+TEST(TraceTest, DisabledByDefault) {
+    EXPECT_FALSE(trace::enabled());
+    // 未开启时直接返回
+    trace::emit(trace::FRAME_TX);
+    UP_TRACE(trace::FRAME_RX, 1);
+}
+
+TEST(TraceTest, ThreadsWriteFixedSizeRecords) {
+    trace::start(TRACE_PATH, 64);
+    ASSERT_TRUE(trace::enabled());
+
+    const int threads = 4;
+    const uint32_t count = 1000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t] {
+            for (uint32_t i = 0; i < count; ++i) {
+                UP_TRACE(trace::TRANSACTION_BEGIN, static_cast<uint8_t>(t), 0, i);
+                const uint8_t frame[] = {0xFF, 0xFF, static_cast<uint8_t>(t), 0x02, 0x20, 0xDC};
+                UP_TRACE_FRAME(trace::FRAME_RX, frame, sizeof(frame), i);
+            }
+        });
+    }
+    for (std::thread &worker: workers) {
+        worker.join();
+    }
+    // 当前线程的记录在 stop() 时写出
+    trace::emit(trace::TIMEOUT, 9, 0, 7, 500, 0, 12345);
+    trace::stop();
+    EXPECT_FALSE(trace::enabled());
+
+    uint64_t start_ns = 0;
+    std::vector<trace::Record> records = trace::load(TRACE_PATH, &start_ns);
+    ASSERT_EQ(threads * count * 2 + 1, records.size());
+    EXPECT_GT(start_ns, 0u);
+
+    // 每个线程的记录按写入顺序排列
+    std::map<uint32_t, uint32_t> next_transaction;
+    std::map<uint32_t, uint8_t> thread_servo;
+    for (const trace::Record &record: records) {
+        if (record.event == trace::TIMEOUT) {
+            EXPECT_EQ(9, record.id);
+            EXPECT_EQ(500u, record.arg0);
+            EXPECT_EQ(12345u, record.time_ns);
+            continue;
+        }
+        if (thread_servo.count(record.thread)) {
+            EXPECT_EQ(thread_servo[record.thread], record.id);
+        }
+        thread_servo[record.thread] = record.id;
+        EXPECT_EQ(next_transaction[record.thread], record.transaction);
+        if (record.event == trace::FRAME_RX) {
+            EXPECT_EQ(6u, record.arg0);
+            EXPECT_EQ(0x20, record.flags);
+            EXPECT_EQ(0xDC2002u, record.arg1 >> 24);
+            ++next_transaction[record.thread];
+        } else {
+            EXPECT_EQ(trace::TRANSACTION_BEGIN, record.event);
+        }
+    }
+    EXPECT_EQ(static_cast<size_t>(threads), next_transaction.size());
+    EXPECT_STREQ("FRAME_RX", trace::eventName(trace::FRAME_RX));
+    EXPECT_STREQ("UNKNOWN", trace::eventName(100));
+
+    std::remove(TRACE_PATH);
+}
+
+TEST(TraceTest, RestartDiscardsStaleRecords) {
+    trace::start(TRACE_PATH);
+    trace::emit(trace::RETRY, 1);
+    trace::flush();
+    EXPECT_EQ(1u, trace::load(TRACE_PATH).size());
+
+    // 重新开始时覆盖文件，新文件中只有新记录
+    trace::start(TRACE_PATH);
+    trace::emit(trace::ERROR, 2, 0x04);
+    trace::stop();
+    std::vector<trace::Record> records = trace::load(TRACE_PATH);
+    ASSERT_EQ(1u, records.size());
+    EXPECT_EQ(trace::ERROR, records[0].event);
+    EXPECT_EQ(0x04, records[0].flags);
+
+    std::FILE *file = std::fopen(TRACE_PATH, "wb");
+    std::fputs("not a trace", file);
+    std::fclose(file);
+    EXPECT_THROW(trace::load(TRACE_PATH), std::runtime_error);
+    std::remove(TRACE_PATH);
+}
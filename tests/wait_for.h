@@ -0,0 +1,25 @@
+//
+// Created by noodles on 26-10-18.
+// 测试共用的轮询等待
+//
+
+#ifndef UP_CORE_WAIT_FOR_H
+#define UP_CORE_WAIT_FOR_H
+
+#include <chrono>
+#include <thread>
+
+// 每毫秒检查一次 predicate，在 timeout_ms 内成立时返回 true
+template<typename Predicate>
+bool waitFor(Predicate predicate, int timeout_ms = 1000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+#endif //UP_CORE_WAIT_FOR_H
@@ -0,0 +1,75 @@
+import argparse
+import os
+from up_core import FirmwarePackage
+
+VERSION = "1.0.0"
+
+
+def guess_model_version(bin_path):
+    """从固件文件名推断型号和版本，如 CDS5516_1.0.bin -> (CDS5516, 1.0)"""
+    name = os.path.splitext(os.path.basename(bin_path))[0]
+    if '_' in name:
+        model, version = name.split('_', 1)
+        return model, version
+    return name, ""
+
+
+def pack_firmware(bin_path, output, model, version, block_size):
+    """把固件镜像打包为固件包，并重新加载校验一次"""
+    with open(bin_path, 'rb') as file:
+        image = file.read()
+
+    packed = FirmwarePackage.pack(image, model, version, block_size)
+    with open(output, 'wb') as file:
+        file.write(packed)
+
+    package = FirmwarePackage.fromFile(output)
+    print_info(output, package)
+
+
+def print_info(path, package):
+    print(f"固件包: {path}")
+    print(f"  型号: {package.model}")
+    print(f"  版本: {package.version}")
+    print(f"  镜像大小: {package.image_size} 字节")
+    print(f"  数据块: {package.block_size} 字节 x {package.frame_count}")
+    print(f"  CRC-32: 0x{package.image_crc:08X}")
+
+
+def main():
+    """主函数，解析命令行参数，打包固件或查看固件包信息。"""
+    parser = argparse.ArgumentParser(description="固件打包工具")
+
+    # 固件文件路径
+    parser.add_argument('bin_path', help='要打包的固件文件路径（--info 时为固件包路径）')
+
+    # 输出文件
+    parser.add_argument('-o', '--output', type=str, help='固件包输出路径（默认: 固件文件名 .upk）')
+
+    # 型号和版本，默认从文件名推断
+    parser.add_argument('-m', '--model', type=str, help='舵机型号（默认从文件名推断，如 CDS5516）')
+    parser.add_argument('-fv', '--firmware_version', type=str, help='固件版本（默认从文件名推断，如 1.0）')
+
+    # 预组装数据帧的数据块大小
+    parser.add_argument('-bs', '--block_size', type=int, default=128, choices=[128, 1024],
+                        help='数据块大小（默认: 128，1024 为 XMODEM-1K）')
+
+    # 只校验并显示固件包信息
+    parser.add_argument('-i', '--info', action='store_true', help='校验并显示固件包信息')
+
+    # 显示版本号
+    parser.add_argument('-v', '--version', action='version', version=f'%(prog)s {VERSION}', help='显示版本信息')
+
+    args = parser.parse_args()
+
+    if args.info:
+        print_info(args.bin_path, FirmwarePackage.fromFile(args.bin_path))
+        return
+
+    model, version = guess_model_version(args.bin_path)
+    output = args.output or os.path.splitext(args.bin_path)[0] + '.upk'
+    pack_firmware(args.bin_path, output, args.model or model, args.firmware_version or version, args.block_size)
+
+
+if __name__ == "__main__":
+    main()
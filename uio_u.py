@@ -1,7 +1,7 @@
 import argparse
 import base64
 import up_core as up
-from up_core import LogLevel, FirmwareUpdate
+from up_core import LogLevel, FirmwareUpdate, FirmwarePackage
 
 VERSION = "1.0.0"
 
@@ -12,12 +12,17 @@ def upgrade_firmware(device, baudrate, bin_path, file_buffer, servo_id, total_re
     """调用固件升级逻辑"""
     fw_update = FirmwareUpdate()
 
-    if file_buffer:
-        # 使用字节流进行升级
-        success = fw_update.upgrade_stream(device, baudrate, list(file_buffer), servo_id,
+    if file_buffer and file_buffer.startswith(b'UPFW'):
+        # 固件包先校验，损坏时不会让舵机进入 Bootloader
+        package = FirmwarePackage.fromBytes(file_buffer)
+        success = fw_update.upgrade_package(device, baudrate, package, servo_id,
+                                            total_retry, handshake_count, frame_retry, sign_retry)
+    elif file_buffer:
+        # 使用字节流进行升级，bytes 通过缓冲区协议直接传入，无需转换为 list
+        success = fw_update.upgrade_stream(device, baudrate, file_buffer, servo_id,
                                            total_retry, handshake_count, frame_retry, sign_retry)
     else:
-        # 使用文件路径进行升级
+        # 使用文件路径进行升级，固件包（uio_p.py 生成的 .upk）会自动识别并校验
         success = fw_update.upgrade_path(device, baudrate, bin_path, servo_id,
                                          total_retry, handshake_count, frame_retry, sign_retry)
 